@@ -1,5 +1,6 @@
 #include "DataGenerator.h"
 #include "Huffman.h"
+#include "TimeframeFile.h"
 #include <ctime>
 /*
 * Generating samples
@@ -11,7 +12,7 @@ void DataGenerator::t_sink(void){
     incrementingOccupancySink();
   } else if(constants::DG_SIMULTION_TYPE == 3){
     globalRandomnessSink();
-  } else if(constants::DG_SIMULTION_TYPE == 4){
+  } else if(constants::DG_SIMULTION_TYPE == 4 || constants::DG_SIMULTION_TYPE == 6){
     sendBlackEvents();
   } else {
     sendGaussianDistribution();
@@ -226,7 +227,7 @@ int DataGenerator::generateCore(int portNumber, int currentTimeWindow, int packe
 void DataGenerator::sendBlackEvents(){
 
   std::cout << "DataGenerator: Reading events into memory" << endl;
-  Datamap dataMap = readBlackEvents(); //readBlackEvents();//readPileUpEvents();
+  Datamap dataMap = constants::DG_SIMULTION_TYPE == 6 ? readTimeframes() : readBlackEvents(); //readBlackEvents();//readPileUpEvents();
   int counter = 0;
   int logcounter = 0;
   const int logperiod = constants::SAMPA_NUMBER_INPUT_PORTS * 1000;
@@ -389,6 +390,107 @@ huffman.WriteCodesToFile(constants::HUFFMAN_TREE_FILE_NAME, codes);
 return map;
 }
 
+/*
+Reads merged timeframes from the binary file written by the generator, see
+generator/TimeframeFile.h. The file can also be a named pipe the generator
+is writing to, the timeframes are then handed over without intermediate
+files.
+The channels of all frames are used in sequence, every window takes the
+next SAMPA_NUMBER_INPUT_PORTS * NUMBER_OF_SAMPA_CHIPS channels like in
+readBlackEvents. The window covers the timebins below
+NUMBER_OF_SAMPLES_IN_EACH_TIME_WINDOW, timebins without signal are sent as
+empty samples.
+*/
+DataGenerator::Datamap DataGenerator::readTimeframes(){
+  TimeframeReader reader;
+  std::vector<uint16_t> words;
+  Huffman huffman;
+  Datamap map;
+  int sampleId = 0;
+  int timeFrame = 1;
+  int count = 0;
+  int nChannels = 0;
+  const uint16_t voidSample = 0xffff;
+
+  if (reader.Open(constants::TIMEFRAME_FILE) < 0) {
+    std::cerr << "DataGenerator: can not open file " << constants::TIMEFRAME_FILE << " for reading of timeframe data" << std::endl;
+    return map;
+  }
+
+  std::cout << "DataGenerator: reading timeframes from file " << constants::TIMEFRAME_FILE << std::endl;
+
+  //A timeframe longer than a time window is spread over consecutive time windows.
+  const int windowLength = constants::NUMBER_OF_SAMPLES_IN_EACH_TIME_WINDOW;
+  const int nWindows = reader.GetChannelLength() > 0 ? (reader.GetChannelLength() - 1) / windowLength + 1 : 1;
+  std::vector<DataEntry> entries(nWindows);
+  std::vector<uint16_t> samples(reader.GetChannelLength());
+  while(timeFrame <= constants::NUMBER_TIME_WINDOWS_TO_SIMULATE && reader.NextFrame() > 0){
+    for(unsigned channel = 0; channel < reader.GetNChannels(); channel++){
+
+      //Break when selected number of timeframes is done.
+      if(timeFrame > constants::NUMBER_TIME_WINDOWS_TO_SIMULATE){
+        break;
+      }
+      if(reader.GetDenseChannel(channel, &samples[0], voidSample) < 0){
+        continue;
+      }
+
+      for(int window = 0; window < nWindows; window++){
+        std::list<Sample> list;
+        uint16_t prev = 0;
+        for(int time = (window + 1) * windowLength - 1; time >= window * windowLength; time--){
+          if(time >= (int)samples.size() || samples[time] == voidSample){
+            //Empty sample
+            Sample sample;
+            sample.timeWindow = timeFrame + window;
+            list.push_back(sample);
+
+            //Huffman generation.
+            words.push_back(constants::HUFFMAN_PREFIX);
+            prev = 0;
+            continue;
+          }
+          int signal = samples[time];
+          Sample sample(timeFrame + window, sampleId, 1, signal);
+          list.push_back(sample);
+          sampleId++;
+
+          //Huffman!
+          uint16_t temp = signal;
+          int16_t t_res = (temp - prev) + constants::HUFFMAN_PREFIX;
+          uint16_t res = t_res;
+          words.push_back(res);
+          prev = temp;
+        }
+
+        //Insert the time window for 1 channel.
+        entries[window].insert(std::pair<int, std::list<Sample>>(count, list));
+      }
+      count++;
+      nChannels++;
+
+      //When number of channels is reached, start new timeframe.
+      if(count == constants::SAMPA_NUMBER_INPUT_PORTS * constants::NUMBER_OF_SAMPA_CHIPS){
+        for(int window = 0; window < nWindows; window++){
+          map.push_back(entries[window]);
+          entries[window].clear();
+        }
+        count = 0;
+        timeFrame += nWindows;
+      }
+    }
+  }
+
+  //Generate huffman table and write it to file.
+  HuffCodeMap codes;
+  huffman.CreateTree(words, codes);
+  huffman.WriteCodesToFile(constants::HUFFMAN_TREE_FILE_NAME, codes);
+
+  std::cout << nChannels << " channel(s) read" << std::endl;
+
+  return map;
+}
+
 DataGenerator::Datamap DataGenerator::readEvents(){
   std::ifstream inputFile(constants::DATA_FILE);
   std::vector<uint16_t> words;
@@ -50,6 +50,7 @@ public:
 	Datamap readBlackEvents();
 	Datamap readPileUpEvents();
 	Datamap readEvents();
+	Datamap readTimeframes();
 	void sendBlackEvents();
 
 	void write_log_to_file_sink(int _packetCounter, int _port, int _currentTimeWindow);
@@ -24,8 +24,9 @@ namespace constants
 	const int DG_OCCUPANCY = 70; //%
 
 	const bool DG_GENERATE_OUTPUT = false;//writting to logfile
-	const int DG_SIMULTION_TYPE = 4; // 1 = standard, 2 = incremental occupancy!, 3 = global randomness, 4 = real events, 5 = gauss
+	const int DG_SIMULTION_TYPE = 4; // 1 = standard, 2 = incremental occupancy!, 3 = global randomness, 4 = real events, 5 = gauss, 6 = merged timeframes
 	const char DATA_FILE[] = "blackevents-pileup";
+	const char TIMEFRAME_FILE[] = "timeframes.tfbin"; // binary timeframe file or named pipe of the generator
 	//CRU
 	const int CRU_WAIT_TIME = 5;	//2 ns (clock cycles) for 500MHz
 	const int CRU_NUMBER_INPUT_PORTS = 1 * NUMBER_OF_FECS; //24 gbt per 1 CRU
@@ -0,0 +1,127 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ArchiveChannelSource.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Channel source reading events from an event archive
+
+#include "ArchiveChannelSource.h"
+#include <cerrno>
+
+namespace {
+  // bunch header used as empty bunch
+  const unsigned short kNoBunch[2]={0, 0};
+}
+
+ArchiveChannelSource::ArchiveChannelSource()
+  : ChannelSource()
+  , mArchive()
+  , mEvent()
+  , mEventIndex(-1)
+  , mMinDDL(-1)
+  , mMaxDDL(-1)
+  , mNextChannel(0)
+  , mDDLNumber(0)
+  , mHWAddress(0)
+  , mBunch(kNoBunch)
+  , mNextBunch(NULL)
+  , mChannelEnd(NULL)
+{
+}
+
+ArchiveChannelSource::~ArchiveChannelSource()
+{
+}
+
+int ArchiveChannelSource::Open(const char* filename)
+{
+  mEventIndex=-1;
+  SetName(filename);
+  return mArchive.Open(filename);
+}
+
+int ArchiveChannelSource::NextEvent()
+{
+  if (!mArchive.IsOpen() || mEventIndex+1>=(int)mArchive.GetNEvents()) return 0;
+  int result=GotoEvent(mEventIndex+1);
+  return result<0?result:1;
+}
+
+int ArchiveChannelSource::GotoEvent(int eventIndex)
+{
+  if (eventIndex<0) return -EINVAL;
+  int result=mArchive.GetEvent(eventIndex, mEvent);
+  if (result<0) return result;
+  mEventIndex=eventIndex;
+  SelectDDLRange(mMinDDL, mMaxDDL);
+  return 0;
+}
+
+void ArchiveChannelSource::SelectDDLRange(int minDDL, int maxDDL)
+{
+  mMinDDL=minDDL;
+  mMaxDDL=maxDDL;
+  mNextChannel=0;
+  mDDLNumber=~0u;
+  mBunch=kNoBunch;
+  mNextBunch=NULL;
+  mChannelEnd=NULL;
+}
+
+bool ArchiveChannelSource::NextDDL()
+{
+  // skip the remaining channels of the current DDL and channels outside
+  // of the selected range, channels are ordered by index
+  unsigned nChannels=mEvent.GetNChannels();
+  for (; mNextChannel<nChannels; mNextChannel++) {
+    unsigned DDLNumber=mEvent.GetChannelIndex(mNextChannel)>>16;
+    if (DDLNumber==mDDLNumber) continue;
+    if (mMinDDL>=0 && mMaxDDL>=0 &&
+	(DDLNumber<(unsigned)mMinDDL || DDLNumber>(unsigned)mMaxDDL)) continue;
+    mDDLNumber=DDLNumber;
+    return true;
+  }
+  return false;
+}
+
+bool ArchiveChannelSource::NextChannel()
+{
+  if (mNextChannel>=mEvent.GetNChannels()) return false;
+  unsigned index=mEvent.GetChannelIndex(mNextChannel);
+  if ((index>>16)!=mDDLNumber) return false;
+  unsigned size=0;
+  mNextBunch=mEvent.GetChannelData(mNextChannel, size);
+  mChannelEnd=mNextBunch+size;
+  mBunch=kNoBunch;
+  mHWAddress=index&0xffff;
+  mNextChannel++;
+  return true;
+}
+
+bool ArchiveChannelSource::NextBunch()
+{
+  if (mNextBunch>=mChannelEnd) return false;
+  mBunch=mNextBunch;
+  mNextBunch+=2+mBunch[1];
+  return true;
+}
+
+ChannelSource* ArchiveChannelSource::Clone() const
+{
+  ArchiveChannelSource* source=new ArchiveChannelSource;
+  if (source->Open(GetName().c_str())<0) {
+    delete source;
+    return NULL;
+  }
+  return source;
+}
@@ -0,0 +1,88 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ArchiveChannelSource.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Channel source reading events from an event archive
+
+#ifndef ARCHIVECHANNELSOURCE_H
+#define ARCHIVECHANNELSOURCE_H
+
+#include "ChannelSource.h"
+#include "EventArchive.h"
+#include "DecodedEvent.h"
+
+/**
+ * @class ArchiveChannelSource
+ * Channel source for memory mapped EventArchive files.
+ *
+ * The channels of the archive are ordered by channel index, DDLs without
+ * any channel are not visible in the iteration. The decoded event is
+ * available directly via GetDecodedEvent.
+ */
+class ArchiveChannelSource : public ChannelSource {
+ public:
+  ArchiveChannelSource();
+  ~ArchiveChannelSource();
+
+  /**
+   * Open archive file.
+   * @return 0 on success, negative error code if failed
+   */
+  int Open(const char* filename);
+
+  /// number of events in the archive
+  unsigned GetNEvents() const {return mArchive.GetNEvents();}
+
+  int NextEvent();
+  int GotoEvent(int eventIndex);
+  int GetEventIndex() const {return mEventIndex;}
+  void SelectDDLRange(int minDDL, int maxDDL);
+  bool NextDDL();
+  unsigned GetDDLNumber() const {return mDDLNumber;}
+  bool NextChannel();
+  unsigned GetHWAddress() const {return mHWAddress;}
+  bool NextBunch();
+  int GetStartTimeBin() const {return mBunch[0];}
+  int GetBunchLength() const {return mBunch[1];}
+  const unsigned short* GetSignals() const {return mBunch+2;}
+  const DecodedEvent* GetDecodedEvent() {return mEventIndex>=0?&mEvent:NULL;}
+  ChannelSource* Clone() const;
+
+ private:
+  /// the mapped archive
+  EventArchive mArchive;
+  /// current event attached to the archive
+  DecodedEvent mEvent;
+  /// index of current event, -1 before first event
+  int mEventIndex;
+  /// min DDL of the selection
+  int mMinDDL;
+  /// max DDL of the selection
+  int mMaxDDL;
+  /// next channel of the event to be read
+  unsigned mNextChannel;
+  /// current DDL
+  unsigned mDDLNumber;
+  /// HW address of current channel
+  unsigned mHWAddress;
+  /// current bunch
+  const unsigned short* mBunch;
+  /// next bunch of the current channel
+  const unsigned short* mNextBunch;
+  /// end of bunch data of the current channel
+  const unsigned short* mChannelEnd;
+};
+#endif
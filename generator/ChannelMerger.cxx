@@ -16,544 +16,1393 @@
 //  @brief  Various functionality for merging of TPC raw data
 
 #include "ChannelMerger.h"
-#include "AliAltroRawStreamV3.h"
-#include "AliRawReader.h"
-#include "AliHLTHuffman.h"
-#include "TString.h"
-#include "TGrid.h"
-#include "TTree.h"
-#include "TFolder.h"
-#include "TH1F.h"
-#include "TH2F.h"
+#include "SampleStore.h"
+#include "ThreadPool.h"
+#include "DecodedEvent.h"
+#include "EventCache.h"
+#include "EventArchive.h"
+#include "ChannelSource.h"
+#include "ZeroSuppression.h"
+#include "SignalAccumulation.h"
+#include "CodeLengthTable.h"
+#include "HuffmanCoder.h"
+#include "InputPrefetcher.h"
+#include "PedestalEstimator.h"
+#include "ChannelMergerT.h"
+#include "TimeframeFile.h"
+#include "CollisionTimeline.h"
 #include <iomanip>
 #include <assert.h>
 #include <fstream>
+#include <sstream>
 #include <cstdlib>
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <map>
 
 const ChannelMerger::buffer_t VOID_SIGNAL=~(ChannelMerger::buffer_t)(0);
 const ChannelMerger::buffer_t MAX_ACCUMULATED_SIGNAL=VOID_SIGNAL-1;
+// number of TPC DDLs, default range for parallel merging
+const unsigned NUMBER_OF_TPC_DDLS=216;
+
+/**
+ * Input cursor of one merging thread.
+ * Every worker has its own clone of the current input source and reads a
+ * contiguous range of DDLs.
+ */
+class ChannelMergerWorker {
+public:
+  ChannelMergerWorker(unsigned minDDL, unsigned maxDDL)
+    : mMinDDL(minDDL), mMaxDDL(maxDDL), mSource(NULL), mSourceGeneration(0) {}
+  ~ChannelMergerWorker() {Close();}
+
+  void Close() {
+    if (mSource) delete mSource;
+    mSource=NULL;
+  }
+
+  /// min DDL number of the range
+  unsigned mMinDDL;
+  /// max DDL number of the range
+  unsigned mMaxDDL;
+  /// clone of the input source
+  ChannelSource* mSource;
+  /// generation of the input source the clone was created from
+  unsigned mSourceGeneration;
+};
 
 ChannelMerger::ChannelMerger()
   : mChannelLenght(1024)
-  , mInitialBufferSize(600000 * mChannelLenght * sizeof(buffer_t))
-  , mBufferSize(0)
-  , mBuffer(NULL) // TODO change to nullptr when moving to c++11
-  , mUnderflowBuffer(NULL) // TODO change to nullptr when moving to c++11
-  , mChannelPositions()
-  , mChannelBaseline()
-  , mChannelMappingPadrow()
-  , mChannelMappingPad()
-  , mChannelOccupancy()
+  , mKernels(&SelectChannelKernels(mChannelLenght))
+  , mDriftLength(0)
+  , mDDLs()
+  , mChannels()
+  , mChannelLayout(kLayoutFirstSeen)
+  , mPadPlaneChannels()
+  , mPadPlaneChannelsBase(0)
+  , mNMappedChannels(0)
   , mZSThreshold(VOID_SIGNAL)
   , mBaselineshift(0)
-  , mSignalOverflowCount(0)
-  , mRawReader(NULL)
-  , mInputStream(NULL)
+  , mSource(NULL)
+  , mOwnSource(false)
+  , mSourceGeneration(0)
   , mInputStreamMinDDL(-1)
   , mInputStreamMaxDDL(-1)
   , mMinPadRow(-1)
   , mMaxPadRow(-1)
   , mNoiseFactor(0)
-  , mChannelHistograms(new TFolder("ChannelHistograms", "ChannelHistograms"))
+  , mRandomSeed(0)
+  , mRandomFrame(0)
+  , mTimelineInput(-1)
+  , mLog(&std::cout)
+  , mNThreads(0)
+  , mThreadPool(NULL)
+  , mWorkers()
+  , mEventCache(NULL)
+  , mEventPoolSize(0)
+  , mInputPrefetcher(NULL)
+  , mInputPrefetchDepth(0)
+  , mInputReadAhead(true)
+  , mWideAccumulation(false)
+  , mChannelHistograms(NULL)
+  , mReleaseChannelHistograms(NULL)
 {
-  if (mChannelHistograms) mChannelHistograms->IsOwner();
 }
 
 ChannelMerger::~ChannelMerger()
 {
-  if (mBuffer) delete [] mBuffer;
-  mBuffer=NULL;
-  if (mUnderflowBuffer) delete [] mUnderflowBuffer;
-  mUnderflowBuffer=NULL;
-  if (mInputStream) delete mInputStream;
-  if (mRawReader) delete mRawReader;
+  ReleaseWorkers();
+  if (mEventCache) delete mEventCache;
+  mEventCache=NULL;
+  if (mInputPrefetcher) delete mInputPrefetcher;
+  mInputPrefetcher=NULL;
+  ReleaseSource();
+  for (std::vector<DDLData*>::iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl==NULL) continue;
+    delete (*ddl)->buffer;
+    for (unsigned i=0; i<(*ddl)->underflowBuffers.size(); i++) {
+      delete (*ddl)->underflowBuffers[i];
+    }
+    if ((*ddl)->wideBuffer) delete (*ddl)->wideBuffer;
+    for (unsigned i=0; i<(*ddl)->wideUnderflowBuffers.size(); i++) {
+      delete (*ddl)->wideUnderflowBuffers[i];
+    }
+    delete *ddl;
+  }
+  mDDLs.clear();
+
+  if (mChannelHistograms && mReleaseChannelHistograms) {
+    (*mReleaseChannelHistograms)(mChannelHistograms);
+  }
+  mChannelHistograms=NULL;
+}
+
+void ChannelMerger::SetNThreads(unsigned nThreads)
+{
+  if (nThreads==mNThreads) return;
+  ReleaseWorkers();
+  mNThreads=nThreads;
+}
+
+void ChannelMerger::ReleaseWorkers()
+{
+  if (mThreadPool) delete mThreadPool;
+  mThreadPool=NULL;
+  for (std::vector<ChannelMergerWorker*>::iterator worker=mWorkers.begin();
+       worker!=mWorkers.end(); worker++) {
+    delete *worker;
+  }
+  mWorkers.clear();
+}
+
+int ChannelMerger::InitEventCache(unsigned maxSize, unsigned poolSize)
+{
+  if (mEventCache) delete mEventCache;
+  mEventCache=NULL;
+  mEventPoolSize=poolSize;
+  if (maxSize==0) return 0;
+  mEventCache=new EventCache((unsigned long)maxSize*1024*1024);
+  return 0;
+}
+
+int ChannelMerger::InitWorkers()
+{
+  unsigned minDDL=0;
+  unsigned maxDDL=NUMBER_OF_TPC_DDLS-1;
+  if (mInputStreamMinDDL>=0 && mInputStreamMaxDDL>=0) {
+    if (mInputStreamMaxDDL<mInputStreamMinDDL) return -EINVAL;
+    minDDL=mInputStreamMinDDL;
+    maxDDL=mInputStreamMaxDDL;
+  }
+  if (mWorkers.size()>0 &&
+      mWorkers.front()->mMinDDL==minDDL &&
+      mWorkers.back()->mMaxDDL==maxDDL) {
+    // workers are set up for the current DDL range
+    return 0;
+  }
+  ReleaseWorkers();
+
+  // the DDL data needs to exist before dispatching the workers, the
+  // threads must not change the DDL list
+  for (unsigned ddl=minDDL; ddl<=maxDDL; ddl++) GetDDLData(ddl);
+
+  unsigned nDDLs=maxDDL-minDDL+1;
+  unsigned nWorkers=std::min(mNThreads, nDDLs);
+  unsigned first=minDDL;
+  for (unsigned i=0; i<nWorkers; i++) {
+    // distribute the remainder over the first workers
+    unsigned count=nDDLs/nWorkers + (i<nDDLs%nWorkers?1:0);
+    mWorkers.push_back(new ChannelMergerWorker(first, first+count-1));
+    first+=count;
+  }
+  mThreadPool=new ThreadPool(nWorkers);
+  return 0;
+}
+
+void ChannelMerger::SetRandomSeed(unsigned long long seed)
+{
+  mRandomSeed=seed;
+  for (unsigned DDLNumber=0; DDLNumber<mDDLs.size(); DDLNumber++) {
+    if (mDDLs[DDLNumber]) mDDLs[DDLNumber]->random.Seed(GetFrameSeed(), DDLNumber);
+  }
+}
+
+void ChannelMerger::SeedTimeframe(unsigned frameNumber)
+{
+  mRandomFrame=frameNumber;
+  SetRandomSeed(mRandomSeed);
+}
+
+unsigned long long ChannelMerger::GetFrameSeed() const
+{
+  // the seed is mixed by SplitMix64 when seeding the generator, frames
+  // with consecutive numbers get unrelated sequences
+  return mRandomSeed+mRandomFrame*0x9e3779b97f4a7c15ULL;
+}
 
-  if (mChannelHistograms) {
-    mChannelHistograms->SaveAs("ChannelHistograms.root");
-    delete mChannelHistograms;
+void ChannelMerger::SetInputPrefetch(unsigned depth, bool readAhead)
+{
+  if (mInputPrefetcher) delete mInputPrefetcher;
+  mInputPrefetcher=NULL;
+  mInputPrefetchDepth=depth;
+  mInputReadAhead=readAhead;
+}
+
+void ChannelMerger::SetWideAccumulation(bool bWide)
+{
+  mWideAccumulation=bWide;
+  for (std::vector<DDLData*>::iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl==NULL) continue;
+    if ((*ddl)->wideBuffer) delete (*ddl)->wideBuffer;
+    for (unsigned i=0; i<(*ddl)->wideUnderflowBuffers.size(); i++) {
+      delete (*ddl)->wideUnderflowBuffers[i];
+    }
+    (*ddl)->wideBuffer=NULL;
+    (*ddl)->wideUnderflowBuffers.clear();
+    if (!bWide) continue;
+    (*ddl)->wideBuffer=new WideSampleStore(mChannelLenght);
+    (*ddl)->wideUnderflowBuffers.resize((*ddl)->underflowBuffers.size(), NULL);
+    for (unsigned i=0; i<(*ddl)->wideUnderflowBuffers.size(); i++) {
+      (*ddl)->wideUnderflowBuffers[i]=new WideSampleStore(mChannelLenght);
+    }
+    // the slots follow the channels added to the buffers
+    for (unsigned i=0; i<(*ddl)->addedChannels.size(); i++) {
+      (*ddl)->wideBuffer->AddChannel();
+      for (unsigned k=0; k<(*ddl)->wideUnderflowBuffers.size(); k++) {
+	(*ddl)->wideUnderflowBuffers[k]->AddChannel();
+      }
+    }
   }
 }
 
 int ChannelMerger::MergeCollisions(std::vector<float> collisiontimes, std::istream& inputfiles)
+{
+  return MergeCollisions(collisiontimes, &inputfiles);
+}
+
+int ChannelMerger::MergeCollisions(std::vector<float> collisiontimes, ChannelSource& source)
+{
+  if (mSource!=&source) {
+    ReleaseSource();
+    mSource=&source;
+    mOwnSource=false;
+    mSourceGeneration++;
+  }
+  return MergeCollisions(collisiontimes, NULL);
+}
+
+int ChannelMerger::MergeCollisions(const std::vector<float>& collisiontimes, std::istream* inputfiles)
+{
+  int iMergedCollisions=MergeEvents(collisiontimes, inputfiles);
+  // the signal buffers hold the accumulated samples after merging
+  if (mWideAccumulation) NarrowAccumulation(1);
+  return iMergedCollisions;
+}
+
+int ChannelMerger::MergeEvents(const std::vector<float>& collisiontimes, std::istream* inputfiles)
 {
   int iMergedCollisions = 0;
-  std::cout << "merging " << collisiontimes.size() << " collision(s) into timeframe" << endl;
+  if (mNThreads>1) {
+    int result=InitWorkers();
+    if (result<0) return result;
+  }
+  (*mLog) << "merging " << collisiontimes.size() << " collision(s) into timeframe" << std::endl;
   for (std::vector<float>::const_iterator collisionOffset = collisiontimes.begin();
        collisionOffset != collisiontimes.end();
        collisionOffset++) {
     bool bHaveData=false;
     do {
-      if (mRawReader == NULL || !mRawReader->NextEvent()) {
-	int result=InitNextInput(inputfiles);
-	if (result==0) return iMergedCollisions;
-	if (result<0) return result;
-      }
-      mInputStream->Reset();
-      if (mInputStreamMinDDL>=0 && mInputStreamMaxDDL>=0) {
-	mRawReader->Select("TPC", mInputStreamMinDDL, mInputStreamMaxDDL);
+      const DecodedEvent* event=NULL;
+      if (mEventCache && mEventPoolSize>0 && mEventCache->GetNEvents()>=mEventPoolSize) {
+	// replay mode, collisions are drawn from the pool of decoded events
+	event=mEventCache->Draw();
       } else {
-      mInputStream->SelectRawData("TPC");
-      }
-      while (mInputStream->NextDDL()) {
-	if (!bHaveData) {
-	  std::cout << "   adding collision " << iMergedCollisions << " at offset " << *collisionOffset << endl;
+	int result=mSource?mSource->NextEvent():0;
+	if (result<0) return result;
+	if (result==0) {
+	  result=inputfiles?InitNextInput(*inputfiles):0;
+	  if (result==0 && mEventCache && mEventPoolSize>0 && mEventCache->GetNEvents()>0) {
+	    // input exhausted before the pool was filled, replay what is available
+	    (*mLog) << "   replaying pool of " << mEventCache->GetNEvents() << " decoded event(s)" << std::endl;
+	    mEventPoolSize=mEventCache->GetNEvents();
+	    continue;
+	  }
+	  if (result==0) return iMergedCollisions;
+	  if (result<0) return result;
 	}
-	bHaveData=true;
-	unsigned DDLNumber=mInputStream->GetDDLNumber();
-	// cout << " reading event " << std::setw(4)// << eventCount
-	//      << "  DDL " << std::setw(4) << DDLNumber
-	//      << " (" << line << ")"
-	//      << endl;
-	while (mInputStream->NextChannel()) {
-	  if (mInputStream->IsChannelBad()) continue;
-	  unsigned HWAddress=mInputStream->GetHWAddress();
-	  unsigned index=DDLNumber<<16 | HWAddress;
-	  if (mMinPadRow >=0 &&
-	      (mChannelMappingPadrow.find(index) == mChannelMappingPadrow.end() ||
-	       mChannelMappingPadrow[index] < (unsigned)mMinPadRow)) continue;
-	  if (mMaxPadRow >=0 &&
-	      (mChannelMappingPadrow.find(index) == mChannelMappingPadrow.end() ||
-	       mChannelMappingPadrow[index] > (unsigned)mMaxPadRow)) continue;
-	  AddChannel(*collisionOffset, index, *mInputStream);
+	// sources holding decoded data, e.g. archives, are merged directly
+	event=mSource->GetDecodedEvent();
+	if (event==NULL && mEventCache) {
+	  event=GetCurrentEvent();
+	  if (event==NULL) return -ENOMEM;
 	}
       }
+      int nDDLs=MergeEvent(*collisionOffset, event);
+      if (nDDLs<0) return nDDLs;
+      if (nDDLs>0) {
+	(*mLog) << "   adding collision " << iMergedCollisions << " at offset " << *collisionOffset << std::endl;
+	bHaveData=true;
+      }
     } while (!bHaveData);
     iMergedCollisions++;
   }
   return iMergedCollisions;
 }
 
-int ChannelMerger::InitNextInputFile(std::istream& inputfiles)
+int ChannelMerger::MergeEvent(float offset, const DecodedEvent* event)
 {
-  // Init the input stream for reading of events from next file
-  if (mInputStream) {
-    // delete previous raw reader and stream
-    delete mInputStream;
-    delete mRawReader;
-    mInputStream=NULL;
-    mRawReader=NULL;
+  int result=0;
+  if (event) {
+    result=MergeDecodedEvent(offset, *event);
+  } else if (mThreadPool) {
+    result=MergeEventParallel(offset);
+  } else {
+    mSource->SelectDDLRange(mInputStreamMinDDL, mInputStreamMaxDDL);
+    result=MergeDDLs(offset, *mSource);
   }
-  // open a new file
-  TString line;
-  line.ReadLine(inputfiles);
-  while (inputfiles.good()) {
-    static TGrid* pGrid=NULL;
-    if (pGrid==NULL && line.BeginsWith("alien://")) {
-      pGrid=TGrid::Connect("alien");
-      if (!pGrid) return -1;
+  FlushMessages();
+  return result;
+}
+
+void ChannelMerger::FlushMessages()
+{
+  for (std::vector<DDLData*>::iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl==NULL) continue;
+    if (!(*ddl)->messages.empty()) {
+      (*mLog) << (*ddl)->messages << std::flush;
+      (*ddl)->messages.clear();
+    }
+    if (!(*ddl)->errors.empty()) {
+      std::cerr << (*ddl)->errors << std::flush;
+      (*ddl)->errors.clear();
     }
-    cout << "open file " << " '" << line << "'" << endl;
-    mRawReader=AliRawReader::Create(line);
-    mInputStream=new AliAltroRawStreamV3(mRawReader);
-    if (!mRawReader || !mInputStream) {
+  }
+}
+
+int ChannelMerger::AssignEvents(CollisionTimeline& timeline, std::istream& inputfiles)
+{
+  // the events are selected like in MergeEvents and the channels like in
+  // MergeDDLs and MergeDecodedEvent, the sources are only iterated
+  std::vector<unsigned char> seen;
+  std::vector<unsigned> newChannels;
+  std::string line;
+  while (timeline.GetNAssignedCollisions()<timeline.GetNCollisions() &&
+	 std::getline(inputfiles, line)) {
+    ChannelSource* source=ChannelSource::Create(line.c_str());
+    if (!source) {
+      std::cerr << "can not open input '" << line << "'" << std::endl;
       return -1;
     }
-    mRawReader->RewindEvents();
-    if (mRawReader->NextEvent()) return 1;
-    line.ReadLine(inputfiles);
+    unsigned input=timeline.AddInput(line);
+    int result=0;
+    while (timeline.GetNAssignedCollisions()<timeline.GetNCollisions() &&
+	   (result=source->NextEvent())>0) {
+      int nDDLs=0;
+      newChannels.clear();
+      const DecodedEvent* event=source->GetDecodedEvent();
+      if (event) {
+	nDDLs=event->GetNDDLs();
+	for (unsigned i=0; i<event->GetNChannels(); i++) {
+	  unsigned index=event->GetChannelIndex(i);
+	  unsigned DDLNumber=index>>16;
+	  if (mInputStreamMinDDL>=0 && mInputStreamMaxDDL>=0 &&
+	      (DDLNumber<(unsigned)mInputStreamMinDDL || DDLNumber>(unsigned)mInputStreamMaxDDL)) continue;
+	  if (!GetDDLData(DDLNumber).IsAccepted(index&0xffff)) continue;
+	  newChannels.push_back(index);
+	}
+      } else {
+	source->SelectDDLRange(mInputStreamMinDDL, mInputStreamMaxDDL);
+	while (source->NextDDL()) {
+	  nDDLs++;
+	  unsigned DDLNumber=source->GetDDLNumber();
+	  DDLData& ddl=GetDDLData(DDLNumber);
+	  if (ddl.nAccepted==0) continue;
+	  while (source->NextChannel()) {
+	    if (source->IsChannelBad()) continue;
+	    unsigned HWAddress=source->GetHWAddress();
+	    if (HWAddress>=kNChannelsPerDDL) continue;
+	    if (!ddl.IsAccepted(HWAddress)) continue;
+	    newChannels.push_back(DDLNumber<<16 | HWAddress);
+	  }
+	}
+      }
+      // events without DDL are skipped by the merging
+      if (nDDLs==0) continue;
+      timeline.AssignEvent(input, source->GetEventIndex());
+      for (std::vector<unsigned>::const_iterator index=newChannels.begin();
+	   index!=newChannels.end(); index++) {
+	unsigned DDLNumber=*index>>16;
+	if (seen.size()<(DDLNumber+1)*kNChannelsPerDDL) seen.resize((DDLNumber+1)*kNChannelsPerDDL, 0);
+	unsigned char& flag=seen[DDLNumber*kNChannelsPerDDL+(*index&0xffff)];
+	if (flag) continue;
+	flag=1;
+	timeline.AddNewChannel(*index);
+      }
+    }
+    delete source;
+    if (result<0) return result;
   }
-  cout << "no more input files specified" << endl;
-  return 0;
+  return timeline.GetNAssignedFrames();
 }
 
-int ChannelMerger::GrowBuffer(unsigned newsize)
+int ChannelMerger::RegisterChannels(const CollisionTimeline& timeline, unsigned endFrame)
 {
-  if (newsize <= mBufferSize) return 0;
+  std::vector<unsigned> channels;
+  timeline.GetChannels(endFrame, channels);
+  for (std::vector<unsigned>::const_iterator index=channels.begin();
+       index!=channels.end(); index++) {
+    DDLData& ddl=GetDDLData(*index>>16);
+    AssignSlot(ddl, ddl.channels[*index&0xffff]);
+  }
+  return channels.size();
+}
 
-  buffer_t* lastData=mBuffer;
-  mBuffer = new buffer_t[newsize];
-  if (lastData) {
-    memcpy(mBuffer, lastData, mBufferSize * sizeof(buffer_t));
-    delete [] lastData;
+int ChannelMerger::MergeCollisions(const CollisionTimeline& timeline, unsigned frame)
+{
+  if (mNThreads>1) {
+    int result=InitWorkers();
+    if (result<0) return result;
   }
-  // initialize to VOID_SIGNAL value to indicate timebins without signals
-  memset(mBuffer+mBufferSize, 0xff, (newsize - mBufferSize) * sizeof(buffer_t));
+  unsigned nCollisions=timeline.GetNCollisions(frame);
+  (*mLog) << "merging " << nCollisions << " collision(s) into timeframe" << std::endl;
+  int iMergedCollisions=0;
+  for (unsigned collision=0; collision<nCollisions; collision++) {
+    unsigned input=0;
+    int eventIndex=timeline.GetEvent(frame, collision, input);
+    // no more events available for the collision
+    if (eventIndex<0) break;
+    if (mSource==NULL || mTimelineInput!=(int)input) {
+      ReleaseSource();
+      const std::string& name=timeline.GetInputName(input);
+      (*mLog) << "open file " << " '" << name << "'" << std::endl;
+      mSource=ChannelSource::Create(name.c_str());
+      if (!mSource) {
+	std::cerr << "can not open input '" << name << "'" << std::endl;
+	return -1;
+      }
+      mOwnSource=true;
+      mSourceGeneration++;
+      mTimelineInput=input;
+    }
+    int result=mSource->GotoEvent(eventIndex);
+    if (result<0) return result;
+    const DecodedEvent* event=mSource->GetDecodedEvent();
+    if (event==NULL && mEventCache) {
+      event=GetCurrentEvent();
+      if (event==NULL) return -ENOMEM;
+    }
+    float offset=timeline.GetCollisionTime(frame, collision);
+    result=MergeEvent(offset, event);
+    if (result<0) return result;
+    (*mLog) << "   adding collision " << iMergedCollisions << " at offset " << offset << std::endl;
+    iMergedCollisions++;
+  }
+  // the signal buffers hold the accumulated samples after merging
+  if (mWideAccumulation) NarrowAccumulation(1);
+  return iMergedCollisions;
+}
 
-  lastData=mUnderflowBuffer;
-  mUnderflowBuffer = new buffer_t[newsize];
-  if (lastData) {
-    memcpy(mUnderflowBuffer, lastData, mBufferSize * sizeof(buffer_t));
-    delete [] lastData;
+int ChannelMerger::MergeDDLs(float offset, ChannelSource& source)
+{
+  int nDDLs=0;
+  while (source.NextDDL()) {
+    nDDLs++;
+    unsigned DDLNumber=source.GetDDLNumber();
+    DDLData& ddl=GetDDLData(DDLNumber);
+    // cout << " reading event " << std::setw(4)// << eventCount
+    //      << "  DDL " << std::setw(4) << DDLNumber
+    //      << endl;
+    // DDLs outside the padrow range are skipped without reading channels
+    if (ddl.nAccepted==0) continue;
+    while (source.NextChannel()) {
+      if (source.IsChannelBad()) continue;
+      unsigned HWAddress=source.GetHWAddress();
+      if (HWAddress>=kNChannelsPerDDL) continue;
+      if (!ddl.IsAccepted(HWAddress)) continue;
+      AddChannel(offset, ddl, ddl.channels[HWAddress], source);
+    }
   }
-  memset(mUnderflowBuffer+mBufferSize, 0xff, (newsize - mBufferSize) * sizeof(buffer_t));
+  return nDDLs;
+}
 
-  mBufferSize=newsize;
+int ChannelMerger::ConvertToArchive(std::istream& inputfiles, const char* filename, int maxEvents)
+{
+  EventArchiveWriter writer;
+  int result=writer.Open(filename);
+  if (result<0) {
+    std::cerr << "can not create event archive '" << filename << "'" << std::endl;
+    return result;
+  }
+  DecodedEvent event;
+  while (maxEvents<0 || writer.GetNEvents()<(unsigned)maxEvents) {
+    result=mSource?mSource->NextEvent():0;
+    if (result==0) {
+      result=InitNextInput(inputfiles);
+      if (result==0) break;
+    }
+    if (result<0) return result;
+    // archives can be merged into a new one
+    const DecodedEvent* decoded=mSource->GetDecodedEvent();
+    if (decoded==NULL) {
+      mSource->SelectDDLRange(mInputStreamMinDDL, mInputStreamMaxDDL);
+      DecodeEvent(*mSource, event);
+      decoded=&event;
+    }
+    result=writer.AddEvent(*decoded);
+    if (result<0) return result;
+  }
+  result=writer.Close();
+  if (result>=0) {
+    (*mLog) << "wrote " << result << " event(s) to archive '" << filename << "'" << std::endl;
+  }
+  return result;
+}
 
-  return 0;
+int ChannelMerger::EstimatePedestals(std::istream& inputfiles, PedestalEstimator& estimator, int maxEvents)
+{
+  int nEvents=0;
+  while (maxEvents<0 || nEvents<maxEvents) {
+    int result=mSource?mSource->NextEvent():0;
+    if (result==0) {
+      result=InitNextInput(inputfiles);
+      if (result==0) break;
+    }
+    if (result<0) return result;
+    const DecodedEvent* decoded=mSource->GetDecodedEvent();
+    if (decoded && mInputStreamMinDDL>=0 && mInputStreamMaxDDL>=0) {
+      estimator.AddEvent(*decoded, mInputStreamMinDDL, mInputStreamMaxDDL);
+    } else if (decoded) {
+      estimator.AddEvent(*decoded);
+    } else {
+      mSource->SelectDDLRange(mInputStreamMinDDL, mInputStreamMaxDDL);
+      estimator.AddEvent(*mSource);
+    }
+    nEvents++;
+  }
+  estimator.Print();
+  return nEvents;
 }
 
-int ChannelMerger::StartTimeframe()
+const DecodedEvent* ChannelMerger::GetCurrentEvent()
 {
-  // start a new timeframe
-  //
-  buffer_t* lastData=mBuffer;
-  mBuffer=mUnderflowBuffer;
-  mUnderflowBuffer=lastData;
-  // initialize to VOID_SIGNAL value to indicate timebins without signals
-  if (mUnderflowBuffer) memset(mUnderflowBuffer, 0xff, mBufferSize * sizeof(buffer_t));
-  mSignalOverflowCount=0;
+  // events are identified by input, event number and DDL selection
+  std::ostringstream key;
+  key << mSource->GetName() << "#" << mSource->GetEventIndex()
+      << "#" << mInputStreamMinDDL << "-" << mInputStreamMaxDDL
+      << "#" << mMinPadRow << "-" << mMaxPadRow;
+  const DecodedEvent* event=mEventCache->Find(key.str());
+  if (event) return event;
+
+  mSource->SelectDDLRange(mInputStreamMinDDL, mInputStreamMaxDDL);
+  DecodedEvent* decoded=new DecodedEvent;
+  DecodeEvent(*mSource, *decoded, true);
+  return mEventCache->Insert(key.str(), decoded);
+}
 
-  for (std::map<unsigned int, int>::iterator it=mChannelOccupancy.begin();
-       it != mChannelOccupancy.end(); it++) {
-    it->second=-1;
+int ChannelMerger::DecodeEvent(ChannelSource& source, DecodedEvent& event, bool acceptedOnly)
+{
+  // without acceptedOnly, all channels are kept independently of the padrow
+  // selection, e.g. for archives, the selection is applied when merging
+  event.Clear();
+  while (source.NextDDL()) {
+    event.AddDDL();
+    unsigned DDLNumber=source.GetDDLNumber();
+    const DDLData* ddl=acceptedOnly?&GetDDLData(DDLNumber):NULL;
+    if (ddl && ddl->nAccepted==0) continue;
+    while (source.NextChannel()) {
+      if (source.IsChannelBad()) continue;
+      unsigned HWAddress=source.GetHWAddress();
+      if (HWAddress>=kNChannelsPerDDL) continue;
+      if (ddl && !ddl->IsAccepted(HWAddress)) continue;
+      event.AddChannel(DDLNumber<<16 | HWAddress);
+      while (source.NextBunch()) {
+	event.AddBunch(source.GetStartTimeBin(), source.GetBunchLength(), source.GetSignals());
+      }
+    }
   }
-
-  return 0;
+  event.Compact();
+  return event.GetNChannels();
 }
 
-int ChannelMerger::AddChannel(float offset, unsigned int index, AliAltroRawStreamV3& stream)
+int ChannelMerger::MergeDecodedEvent(float offset, const DecodedEvent& event)
 {
-  // add channel samples
-  unsigned position=mChannelPositions.size();
-  if (mChannelPositions.find(index) == mChannelPositions.end()) {
-    // add index to map
-    mChannelPositions[index]=position;
-    //std::cout << "adding new channel with index " << std::hex << std::setw(8) << index << " at position " << std::dec << position << std::endl;
+  if (mThreadPool) {
+    mThreadPool->Run(mWorkers.size(), [&](unsigned i) {
+	MergeDecodedEvent(offset, event, mWorkers[i]->mMinDDL, mWorkers[i]->mMaxDDL);
+      });
+  } else if (mInputStreamMinDDL>=0 && mInputStreamMaxDDL>=0) {
+    MergeDecodedEvent(offset, event, mInputStreamMinDDL, mInputStreamMaxDDL);
   } else {
-    // get position from map
-    position=mChannelPositions[index];
-    //std::cout << "using channel with index " << std::hex << std::setw(8) << index << " at position " << std::dec << position << std::endl;
+    MergeDecodedEvent(offset, event, 0, ~0u);
   }
+  return event.GetNDDLs();
+}
 
-  unsigned int baseline=0;
-  if (mChannelBaseline.find(index) != mChannelBaseline.end()) {
-    baseline = mChannelBaseline[index];
+int ChannelMerger::MergeDecodedEvent(float offset, const DecodedEvent& event, unsigned minDDL, unsigned maxDDL)
+{
+  int nChannels=0;
+  for (unsigned i=0; i<event.GetNChannels(); i++) {
+    unsigned index=event.GetChannelIndex(i);
+    unsigned DDLNumber=index>>16;
+    if (DDLNumber<minDDL || DDLNumber>maxDDL) continue;
+    if ((index&0xffff)>=kNChannelsPerDDL) continue;
+    DDLData& ddl=GetDDLData(DDLNumber);
+    if (!ddl.IsAccepted(index&0xffff)) continue;
+    ChannelInfo& channel=ddl.channels[index&0xffff];
+    unsigned size=0;
+    const DecodedEvent::sample_t* data=event.GetChannelData(i, size);
+    AddChannel(offset, ddl, channel, data, size);
+    nChannels++;
   }
+  return nChannels;
+}
 
-  unsigned int threshold=mZSThreshold;
-  if (threshold != VOID_SIGNAL) {
-    if (mBaselineshift<0) {
-      threshold+=-mBaselineshift;
-    } else if (threshold<=(unsigned)mBaselineshift) {
-      threshold=0;
-    } else {
-      threshold-=mBaselineshift;
-    }
-    // adjust threshold to baseline
-    threshold+=baseline;
+int ChannelMerger::MergeEventParallel(float offset)
+{
+  // every worker positions its own source at the current event of the
+  // main source and merges its DDL range, the DDLs do not share any data
+  int eventIndex=mSource->GetEventIndex();
+  // the clones are created on the calling thread, opening a source is not
+  // thread safe for all source types, e.g. the ROOT based raw reader
+  for (std::vector<ChannelMergerWorker*>::iterator it=mWorkers.begin(); it!=mWorkers.end(); it++) {
+    ChannelMergerWorker& worker=**it;
+    if (worker.mSource!=NULL && worker.mSourceGeneration==mSourceGeneration) continue;
+    worker.Close();
+    worker.mSource=mSource->Clone();
+    if (worker.mSource==NULL) return -ENOSYS;
+    worker.mSourceGeneration=mSourceGeneration;
   }
-
-  unsigned reqsize=position + 1; // need space for one channel starting at position
-  reqsize *= mChannelLenght * sizeof(buffer_t);
-  if (reqsize > mBufferSize) {
-    unsigned newsize=0;
-    if (mBufferSize == 0 && reqsize < mInitialBufferSize) {
-      newsize = mInitialBufferSize;
-    } else if (reqsize < 2 * mBufferSize) {
-      newsize = 2 * mBufferSize;
-    } else {
-      newsize = reqsize;
-    }
-    GrowBuffer(newsize);
+  std::vector<int> results(mWorkers.size(), 0);
+  mThreadPool->Run(mWorkers.size(), [&](unsigned i) {
+      ChannelMergerWorker& worker=*mWorkers[i];
+      int result=worker.mSource->GotoEvent(eventIndex);
+      if (result<0) {results[i]=result; return;}
+      worker.mSource->SelectDDLRange(worker.mMinDDL, worker.mMaxDDL);
+      results[i]=MergeDDLs(offset, *worker.mSource);
+    });
+  int nDDLs=0;
+  for (std::vector<int>::const_iterator result=results.begin();
+       result!=results.end(); result++) {
+    if (*result<0) return *result;
+    nDDLs+=*result;
   }
+  return nDDLs;
+}
 
-  position*=mChannelLenght;
-  assert(position+mChannelLenght<=mBufferSize);
-  while (stream.NextBunch()) {
-    int startTime=stream.GetStartTimeBin();
-    startTime-=offset * mChannelLenght;
-    int bunchLength=stream.GetBunchLength();
-    const unsigned short* signals=stream.GetSignals();
-    bool bSignalPeak=false;
-    for (Int_t i=0; i<bunchLength; i++) {
-      assert(signals[i]<1024);
-      if (signals[i]>=1024) {
-	std::cout << "invalid signal value " << signals[i] << std::endl;
+void ChannelMerger::ReleaseSource()
+{
+  if (mSource && mOwnSource) delete mSource;
+  mSource=NULL;
+  mOwnSource=false;
+  mTimelineInput=-1;
+}
+
+int ChannelMerger::InitNextInputFile(std::istream& inputfiles)
+{
+  // Init the input source for reading of events from next file
+  ReleaseSource();
+  if (mInputPrefetchDepth>0) {
+    // the files are opened by the background thread
+    if (mInputPrefetcher && &mInputPrefetcher->GetStream()!=&inputfiles) {
+      delete mInputPrefetcher;
+      mInputPrefetcher=NULL;
+    }
+    if (!mInputPrefetcher) {
+      mInputPrefetcher=new InputPrefetcher(inputfiles, mInputPrefetchDepth, mInputReadAhead);
+    }
+    std::string name;
+    ChannelSource* source=NULL;
+    int result=0;
+    while (mInputPrefetcher->Next(name, source, result)>0) {
+      (*mLog) << "open file " << " '" << name << "'" << std::endl;
+      if (!source) {
+	std::cerr << "can not open input '" << name << "'" << std::endl;
+	return -1;
       }
+      mSource=source;
+      mOwnSource=true;
+      mSourceGeneration++;
+      if (!mInputReadAhead) result=mSource->NextEvent();
+      if (result!=0) return result;
+      ReleaseSource();
+    }
+    delete mInputPrefetcher;
+    mInputPrefetcher=NULL;
+    (*mLog) << "no more input files specified" << std::endl;
+    return 0;
+  }
+  // open a new file
+  std::string line;
+  std::getline(inputfiles, line);
+  while (inputfiles.good()) {
+    (*mLog) << "open file " << " '" << line << "'" << std::endl;
+    mSource=ChannelSource::Create(line.c_str());
+    if (!mSource) {
+      std::cerr << "can not open input '" << line << "'" << std::endl;
+      return -1;
+    }
+    mOwnSource=true;
+    mSourceGeneration++;
+    int result=mSource->NextEvent();
+    if (result!=0) return result;
+    ReleaseSource();
+    std::getline(inputfiles, line);
+  }
+  (*mLog) << "no more input files specified" << std::endl;
+  return 0;
+}
 
-      unsigned currentSignal=signals[i];
-      unsigned originalSignal=signals[i];
+int ChannelMerger::StartTimeframe()
+{
+  // start a new timeframe
+  //
+  for (std::vector<DDLData*>::iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl==NULL) continue;
+    // rotate the buffers, the buffer of the last timeframe becomes the
+    // underflow buffer of the last following frame
+    std::vector<SampleStore*>& underflowBuffers=(*ddl)->underflowBuffers;
+    SampleStore* lastData=(*ddl)->buffer;
+    (*ddl)->buffer=underflowBuffers.front();
+    std::copy(underflowBuffers.begin()+1, underflowBuffers.end(), underflowBuffers.begin());
+    underflowBuffers.back()=lastData;
+    // release all blocks, timebins without signals read as VOID_SIGNAL
+    lastData->Clear();
+    if ((*ddl)->wideBuffer) {
+      std::vector<WideSampleStore*>& wideUnderflowBuffers=(*ddl)->wideUnderflowBuffers;
+      WideSampleStore* lastWideData=(*ddl)->wideBuffer;
+      (*ddl)->wideBuffer=wideUnderflowBuffers.front();
+      std::copy(wideUnderflowBuffers.begin()+1, wideUnderflowBuffers.end(), wideUnderflowBuffers.begin());
+      wideUnderflowBuffers.back()=lastWideData;
+      lastWideData->Clear();
+    }
+    (*ddl)->signalOverflowCount=0;
+  }
 
-      // ZS
-      if (threshold!=VOID_SIGNAL) {
-	if (!bSignalPeak && currentSignal>threshold &&
-	    i+1<bunchLength && signals[i+1]>threshold) {
-	  // signal peak starts at two consecutive signals over threshold
-	  bSignalPeak=true;
-	} else if (bSignalPeak && currentSignal>threshold) {
-	  // signal belonging to active signal peak
-	} else if (bSignalPeak && currentSignal<=threshold) {
-	  if ((i+1<bunchLength && signals[i+1]>threshold) ||
-	      (i+2<bunchLength && signals[i+2]>threshold)) {
-	    // signal below threshold after peak, merged if next or
-	    // next to next signal over threshold
-	    // two signal peaks intercepted by one or two consecutive
-	    // signals below threshold are merged
-	  } else {
-	    // signal below threshold after peak
-	    bSignalPeak=false;
-	    currentSignal=0;
-	  }
-	} else {
-	  // suppress signal
-	  currentSignal=0;;
-	}
-      }
-      // subtract baseline
-      if (originalSignal<baseline) originalSignal=0;
-      else originalSignal-=baseline;
+  for (std::vector<ChannelInfo*>::iterator chit=mChannels.begin();
+       chit != mChannels.end(); chit++) {
+    (*chit)->occupancy=-1;
+  }
 
-      unsigned tb=baseline;
-      if (mBaselineshift<0) tb+=-mBaselineshift;
-      else if ((unsigned)mBaselineshift<tb) tb-=mBaselineshift;
-      if (currentSignal<tb) currentSignal=0;
-      else currentSignal-=tb;
+  return 0;
+}
 
-      int timebin=startTime-i;
-      if (timebin < (int)mChannelLenght && timebin >= 0) {
-	if (mBuffer[position+timebin] == VOID_SIGNAL) {
-	  // first value in this timebin
-	  if (currentSignal==0 && mNoiseFactor >= 1) {
-	    // this value is noise base line
-	    mBuffer[position+timebin]=ManipulateNoise(originalSignal);
-	  } else {
-	    mBuffer[position+timebin]=originalSignal;
-	  }
-	} else if (mBuffer[position+timebin] > MAX_ACCUMULATED_SIGNAL-currentSignal) {
-	  // range overflow
-	  assert(0); // stop here or count errors if assert disabled (NDEBUG)
-	  if (mSignalOverflowCount<10) {
-	    std::cout << "overflow at timebin " << timebin
-		      << " MAX_ACCUMULATED_SIGNAL=" << MAX_ACCUMULATED_SIGNAL
-		      << " buffer=" << mBuffer[position+timebin]
-		      << " signal=" << currentSignal
-		      << std::endl;
-	  }
-	  mBuffer[position+timebin] = MAX_ACCUMULATED_SIGNAL;
-	  mSignalOverflowCount++;
-	} else {
-	mBuffer[position+timebin]+=currentSignal;
-	}
-      } else if (timebin < 0 && (timebin + (int)mChannelLenght) >= 0) {
-	timebin += mChannelLenght;
-	if (mUnderflowBuffer[position+timebin] == VOID_SIGNAL) {
-	  // first value in this timebin
-	  if (currentSignal==0 && mNoiseFactor >= 1) {
-	    // this value is noise base line
-	    mUnderflowBuffer[position+timebin]=ManipulateNoise(originalSignal);
-	  } else {
-	    mUnderflowBuffer[position+timebin]=originalSignal;
-	  }
-	} else if (mUnderflowBuffer[position+timebin] > MAX_ACCUMULATED_SIGNAL-currentSignal) {
-	  // range overflow
-	  mUnderflowBuffer[position+timebin] = MAX_ACCUMULATED_SIGNAL;
-	  // overflow is only counted for buffer of current timeframe
-	  assert(0); // stop here
-	} else {
-	mUnderflowBuffer[position+timebin]+=currentSignal;
-	}
-      } else {
-	// TODO: some out-of-range counter
-	std::cerr << "sample with timebin " << timebin << " out of range" << std::endl;
+int ChannelMerger::MoveTimeframe(ChannelMerger& target)
+{
+  if (&target==this) return 0;
+  // an empty target adopts the channel length
+  if (target.mChannelLenght!=mChannelLenght &&
+      target.SetChannelLength(mChannelLenght)<0) return -EINVAL;
+  target.mZSThreshold=mZSThreshold;
+  target.mBaselineshift=mBaselineshift;
+
+  for (unsigned DDLNumber=0; DDLNumber<mDDLs.size(); DDLNumber++) {
+    DDLData* ddl=mDDLs[DDLNumber];
+    if (ddl==NULL) continue;
+    DDLData& targetDDL=target.GetDDLData(DDLNumber);
+    // channels are never removed, the target table follows the source
+    // table and the slots of the buffers are identical
+    if (targetDDL.addedChannels.size()!=ddl->addedChannels.size()) {
+      targetDDL.addedChannels.clear();
+      for (std::vector<ChannelInfo*>::const_iterator chit=ddl->addedChannels.begin();
+	   chit!=ddl->addedChannels.end(); chit++) {
+	targetDDL.addedChannels.push_back(targetDDL.channels+((*chit)->index&0xffff));
       }
     }
+    for (unsigned i=0; i<kNChannelsPerDDL; i++) {
+      targetDDL.channels[i]=ddl->channels[i];
+    }
+    std::swap(ddl->buffer, targetDDL.buffer);
+    ddl->buffer->Clear();
+    // the reserved blocks of the pad plane layout stay with the buffer
+    if (ddl->buffer->GetNReservedSlots()==0) {
+      ddl->buffer->ReserveSlots(ddl->underflowBuffers[0]->GetNReservedSlots());
+    }
+    while (ddl->buffer->GetNChannels()<ddl->underflowBuffers[0]->GetNChannels()) {
+      ddl->buffer->AddChannel();
+    }
+    targetDDL.signalOverflowCount=ddl->signalOverflowCount;
+    ddl->signalOverflowCount=0;
+  }
+  // the slots of the previous data of the target are released, the
+  // underflow buffer of the target is not used for processing
+  for (unsigned DDLNumber=mDDLs.size(); DDLNumber<target.mDDLs.size(); DDLNumber++) {
+    if (target.mDDLs[DDLNumber]) target.mDDLs[DDLNumber]->buffer->Clear();
   }
 
   return 0;
 }
 
-int ChannelMerger::Normalize(unsigned scalingFactor)
+int ChannelMerger::SetChannelLength(unsigned length)
 {
-  if (scalingFactor==0) return 0;
-
-  for (std::map<unsigned int, unsigned int>::const_iterator chit=mChannelPositions.begin();
-       chit!=mChannelPositions.end(); chit++) {
-    unsigned position=chit->second;
-    position*=mChannelLenght;
-    for (unsigned i=0; i<mChannelLenght; i++) {
-      unsigned signal=mBuffer[position+i];
-      if (signal == VOID_SIGNAL) continue;
-      mBuffer[position+i]=signal/scalingFactor;
-    }
+  if (length==0) return -EINVAL;
+  for (std::vector<DDLData*>::const_iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl) return -EBUSY;
   }
+  mChannelLenght=length;
+  mKernels=&SelectChannelKernels(mChannelLenght);
   return 0;
 }
 
-int ChannelMerger::Analyze(TTree& target, const char* statfilename)
+int ChannelMerger::SetDriftLength(unsigned length)
 {
-
-  // tree setup
-  int DDLNumber=0;
-  int HWAddr=0;
-  int PadRow=0;
-  int Pad=0;
-  int MinSignal=0;
-  int MaxSignal=0;
-  int AvrgSignal=0;
-  int MinSignalDiff=0;
-  int MaxSignalDiff=0;
-  int MinTimebin=0;
-  int MaxTimebin=0;
-  int NFilledTimebins=0;
-  int NBunches=0;
-  // strangely enough, TTree::SetBranchAddress requires the
-  // array to be 'unsigned int' although the branch was created with
-  // in array.
-  unsigned int BunchLength[mChannelLenght];
-
-  if (target.GetBranch("DDLNumber") != NULL) {
-    target.SetBranchAddress("DDLNumber", &DDLNumber);
+  for (std::vector<DDLData*>::const_iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl) return -EBUSY;
   }
+  mDriftLength=length;
+  return 0;
+}
 
-  if (target.GetBranch("HWAddr") != NULL) {
-    target.SetBranchAddress("HWAddr", &HWAddr);
+int ChannelMerger::SetChannelLayout(int layout)
+{
+  if (layout!=kLayoutFirstSeen && layout!=kLayoutPadPlane) return -EINVAL;
+  // the DDLs are created when reading the mapping, the layout can be
+  // changed as long as no slots have been assigned
+  for (std::vector<DDLData*>::const_iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl && (*ddl)->buffer->GetNChannels()>0) return -EBUSY;
   }
+  mChannelLayout=layout;
+  return 0;
+}
 
-  if (target.GetBranch("PadRow") != NULL) {
-    target.SetBranchAddress("PadRow", &PadRow);
+unsigned int ChannelMerger::GetSignalOverflowCount() const
+{
+  unsigned int count=0;
+  for (std::vector<DDLData*>::const_iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl) count+=(*ddl)->signalOverflowCount;
   }
+  return count;
+}
 
-  if (target.GetBranch("MinSignal") != NULL) {
-    target.SetBranchAddress("MinSignal", &MinSignal);
+ChannelMerger::DDLData& ChannelMerger::GetDDLData(unsigned DDLNumber)
+{
+  if (DDLNumber>=mDDLs.size()) {
+    mDDLs.resize(DDLNumber+1, NULL);
+  }
+  if (mDDLs[DDLNumber]==NULL) {
+    DDLData* ddl=new DDLData;
+    for (unsigned i=0; i<kNChannelsPerDDL; i++) {
+      ChannelInfo& channel=ddl->channels[i];
+      channel.index=DDLNumber<<16 | i;
+      channel.position=kNoPosition;
+      channel.baseline=0;
+      channel.padrow=-1;
+      channel.pad=-1;
+      channel.occupancy=-1;
+      channel.mapped=false;
+      channel.added=false;
+    }
+    UpdateAcceptance(*ddl);
+    // one underflow buffer for every following frame spanned by the drift
+    unsigned nUnderflowFrames=GetNUnderflowFrames();
+    ddl->buffer=new SampleStore(mChannelLenght);
+    for (unsigned i=0; i<nUnderflowFrames; i++) {
+      ddl->underflowBuffers.push_back(new SampleStore(mChannelLenght));
+    }
+    ddl->wideBuffer=NULL;
+    if (mWideAccumulation) {
+      ddl->wideBuffer=new WideSampleStore(mChannelLenght);
+      for (unsigned i=0; i<nUnderflowFrames; i++) {
+	ddl->wideUnderflowBuffers.push_back(new WideSampleStore(mChannelLenght));
+      }
+    }
+    ddl->signalOverflowCount=0;
+    ddl->random.Seed(GetFrameSeed(), DDLNumber);
+    mDDLs[DDLNumber]=ddl;
   }
+  return *mDDLs[DDLNumber];
+}
 
-  if (target.GetBranch("MaxSignal") != NULL) {
-    target.SetBranchAddress("MaxSignal", &MaxSignal);
+ChannelMerger::ChannelInfo* ChannelMerger::GetChannelInfo(unsigned index)
+{
+  unsigned DDLNumber=(index&0xffff0000)>>16;
+  unsigned HWAddr=index&0x0000ffff;
+  if (HWAddr>=kNChannelsPerDDL) return NULL;
+  return GetDDLData(DDLNumber).channels+HWAddr;
+}
+
+SampleStore& ChannelMerger::GetBuffer(const ChannelInfo& channel)
+{
+  return *mDDLs[channel.index>>16]->buffer;
+}
+
+namespace {
+  struct ChannelIndexLess {
+    template<typename T>
+    bool operator()(const T* a, const T* b) const {return a->index < b->index;}
+  };
+}
+
+const std::vector<ChannelMerger::ChannelInfo*>& ChannelMerger::GetChannels()
+{
+  // the list is rebuilt if channels have been added, the channels of
+  // every DDL are kept in the order of adding
+  unsigned nChannels=0;
+  for (std::vector<DDLData*>::const_iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl) nChannels+=(*ddl)->addedChannels.size();
   }
+  if (nChannels!=mChannels.size()) {
+    mChannels.clear();
+    for (std::vector<DDLData*>::const_iterator ddl=mDDLs.begin();
+	 ddl!=mDDLs.end(); ddl++) {
+      if (*ddl==NULL) continue;
+      std::vector<ChannelInfo*> channels((*ddl)->addedChannels);
+      std::sort(channels.begin(), channels.end(), ChannelIndexLess());
+      mChannels.insert(mChannels.end(), channels.begin(), channels.end());
+    }
+  }
+  return mChannels;
+}
+
+namespace {
+  struct PadPlaneLess {
+    template<typename T>
+    bool operator()(const T* a, const T* b) const {
+      if ((a->index>>16)!=(b->index>>16)) return (a->index>>16) < (b->index>>16);
+      if (a->padrow!=b->padrow) return a->padrow < b->padrow;
+      if (a->pad!=b->pad) return a->pad < b->pad;
+      return a->index < b->index;
+    }
+  };
+}
 
-  if (target.GetBranch("AvrgSignal") != NULL) {
-    target.SetBranchAddress("AvrgSignal", &AvrgSignal);
+const std::vector<ChannelMerger::ChannelInfo*>& ChannelMerger::GetPadPlaneChannels()
+{
+  // rebuilt together with the channel list if channels have been added
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  if (channels.size()!=mPadPlaneChannelsBase) {
+    mPadPlaneChannels.clear();
+    for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+	 chit!=channels.end(); chit++) {
+      if ((*chit)->mapped) mPadPlaneChannels.push_back(*chit);
+    }
+    std::sort(mPadPlaneChannels.begin(), mPadPlaneChannels.end(), PadPlaneLess());
+    mPadPlaneChannelsBase=channels.size();
   }
+  return mPadPlaneChannels;
+}
+
+ChannelMerger::PadRowIterator ChannelMerger::GetPadRows()
+{
+  GetPadPlaneChannels();
+  return PadRowIterator(this);
+}
 
-  if (target.GetBranch("MinSignalDiff") != NULL) {
-    target.SetBranchAddress("MinSignalDiff", &MinSignalDiff);
+void ChannelMerger::GetBufferOrder(std::vector<unsigned>& order)
+{
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  order.clear();
+  order.reserve(channels.size());
+  if (mChannelLayout!=kLayoutPadPlane) {
+    for (unsigned c=0; c<channels.size(); c++) order.push_back(c);
+    return;
+  }
+  // the padrows of a DDL are followed by the channels without mapping,
+  // the position in the channel list is found by the channel index
+  unsigned next=0;
+  PadRowIterator padrow=GetPadRows();
+  while (padrow.Next()) {
+    for (; next<channels.size() && (channels[next]->index>>16)<padrow.GetDDLNumber(); next++) {
+      if (!channels[next]->mapped) order.push_back(next);
+    }
+    for (unsigned i=0; i<padrow.GetNChannels(); i++) {
+      unsigned index=padrow.GetChannelIndex(i);
+      std::vector<ChannelInfo*>::const_iterator chit=
+	std::lower_bound(channels.begin(), channels.end(), index,
+			 [](const ChannelInfo* channel, unsigned value) {return channel->index<value;});
+      order.push_back(chit-channels.begin());
+    }
+  }
+  for (; next<channels.size(); next++) {
+    if (!channels[next]->mapped) order.push_back(next);
   }
+}
 
-  if (target.GetBranch("MaxSignalDiff") != NULL) {
-    target.SetBranchAddress("MaxSignalDiff", &MaxSignalDiff);
+ChannelMerger::PadRowIterator::PadRowIterator()
+  : mMerger(NULL)
+  , mBegin(0)
+  , mEnd(0)
+{
+}
+
+ChannelMerger::PadRowIterator::PadRowIterator(ChannelMerger* merger)
+  : mMerger(merger)
+  , mBegin(0)
+  , mEnd(0)
+{
+}
+
+bool ChannelMerger::PadRowIterator::Next()
+{
+  if (mMerger==NULL) return false;
+  const std::vector<ChannelInfo*>& channels=mMerger->mPadPlaneChannels;
+  mBegin=mEnd;
+  if (mBegin>=channels.size()) return false;
+  const ChannelInfo& first=*channels[mBegin];
+  for (mEnd=mBegin+1; mEnd<channels.size(); mEnd++) {
+    if ((channels[mEnd]->index>>16)!=(first.index>>16) ||
+	channels[mEnd]->padrow!=first.padrow) break;
   }
+  return true;
+}
+
+unsigned ChannelMerger::PadRowIterator::GetDDLNumber() const
+{
+  return mMerger->mPadPlaneChannels[mBegin]->index>>16;
+}
+
+int ChannelMerger::PadRowIterator::GetPadRow() const
+{
+  return mMerger->mPadPlaneChannels[mBegin]->padrow;
+}
+
+unsigned ChannelMerger::PadRowIterator::GetChannelIndex(unsigned channel) const
+{
+  return mMerger->mPadPlaneChannels[mBegin+channel]->index;
+}
+
+int ChannelMerger::PadRowIterator::GetPad(unsigned channel) const
+{
+  return mMerger->mPadPlaneChannels[mBegin+channel]->pad;
+}
+
+int ChannelMerger::PadRowIterator::GetDenseChannel(unsigned channel, buffer_t* target) const
+{
+  const ChannelInfo& info=*mMerger->mPadPlaneChannels[mBegin+channel];
+  return mMerger->GetBuffer(info).GetDenseChannel(info.position, target);
+}
+
+int ChannelMerger::PadRowIterator::SetDenseChannel(unsigned channel, const buffer_t* source) const
+{
+  const ChannelInfo& info=*mMerger->mPadPlaneChannels[mBegin+channel];
+  return mMerger->GetBuffer(info).SetDenseChannel(info.position, source);
+}
 
-  if (target.GetBranch("MinTimebin") != NULL) {
-    target.SetBranchAddress("MinTimebin", &MinTimebin);
+bool ChannelMerger::IsSelected(const ChannelInfo& channel) const
+{
+  if (mMinPadRow >=0 &&
+      (!channel.mapped || (unsigned)channel.padrow < (unsigned)mMinPadRow)) return false;
+  if (mMaxPadRow >=0 &&
+      (!channel.mapped || (unsigned)channel.padrow > (unsigned)mMaxPadRow)) return false;
+  return true;
+}
+
+void ChannelMerger::UpdateChannelSelection()
+{
+  for (std::vector<DDLData*>::iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl==NULL) continue;
+    UpdateAcceptance(**ddl);
   }
+}
 
-  if (target.GetBranch("MaxTimebin") != NULL) {
-    target.SetBranchAddress("MaxTimebin", &MaxTimebin);
+void ChannelMerger::UpdateAcceptance(DDLData& ddl)
+{
+  ddl.nAccepted=0;
+  for (unsigned word=0; word<kNChannelsPerDDL/64; word++) {
+    unsigned long long bits=0;
+    for (unsigned bit=0; bit<64; bit++) {
+      if (!IsSelected(ddl.channels[word*64+bit])) continue;
+      bits|=1ULL<<bit;
+      ddl.nAccepted++;
+    }
+    ddl.acceptance[word]=bits;
   }
+}
 
-  if (target.GetBranch("NFilledTimebins") != NULL) {
-    target.SetBranchAddress("NFilledTimebins", &NFilledTimebins);
+int ChannelMerger::AddChannel(float offset, DDLData& ddl, ChannelInfo& channel, ChannelSource& source)
+{
+  // add channel samples
+  AssignSlot(ddl, channel);
+  unsigned threshold=GetChannelThreshold(channel);
+  while (source.NextBunch()) {
+    int startTime=source.GetStartTimeBin();
+    startTime-=offset * mChannelLenght;
+    startTime-=GetDriftLength()-mChannelLenght;
+    AddBunch(ddl, channel, threshold, startTime, source.GetBunchLength(), source.GetSignals());
   }
 
-  if (target.GetBranch("NBunches") != NULL) {
-    target.SetBranchAddress("NBunches", &NBunches);
+  return 0;
+}
+
+int ChannelMerger::AddChannel(float offset, DDLData& ddl, ChannelInfo& channel, const unsigned short* data, unsigned size)
+{
+  // add channel samples from a decoded event
+  AssignSlot(ddl, channel);
+  unsigned threshold=GetChannelThreshold(channel);
+  const unsigned short* end=data+size;
+  while (data<end) {
+    int startTime=data[0];
+    startTime-=offset * mChannelLenght;
+    startTime-=GetDriftLength()-mChannelLenght;
+    int bunchLength=data[1];
+    AddBunch(ddl, channel, threshold, startTime, bunchLength, data+2);
+    data+=2+bunchLength;
   }
 
-  if (target.GetBranch("BunchLength") != NULL) {
-    target.SetBranchAddress("BunchLength", BunchLength);
+  return 0;
+}
+
+void ChannelMerger::AssignSlot(DDLData& ddl, ChannelInfo& channel)
+{
+  if (channel.added) return;
+  if (mChannelLayout==kLayoutPadPlane && ddl.buffer->GetNChannels()==0) {
+    LayoutPadPlane(ddl);
   }
+  if (channel.position == kNoPosition) {
+    // new channel, add a slot to all buffers of the DDL
+    channel.position=ddl.buffer->AddChannel();
+    for (unsigned i=0; i<ddl.underflowBuffers.size(); i++) {
+      ddl.underflowBuffers[i]->AddChannel();
+    }
+    if (ddl.wideBuffer) {
+      ddl.wideBuffer->AddChannel();
+      for (unsigned i=0; i<ddl.wideUnderflowBuffers.size(); i++) {
+	ddl.wideUnderflowBuffers[i]->AddChannel();
+      }
+    }
+  }
+  channel.added=true;
+  ddl.addedChannels.push_back(&channel);
+}
 
-  // statistics file setup
-  std::ofstream* statfile = NULL;
-  if (statfilename) {
-    statfile = new std::ofstream(statfilename);
-    if (statfile!=NULL && !statfile->good()) {
-      delete statfile;
-      statfile=NULL;
+void ChannelMerger::LayoutPadPlane(DDLData& ddl)
+{
+  // slots are reserved for all mapped channels, a channel is only added
+  // to the list of channels with its first signal
+  std::vector<ChannelInfo*> channels;
+  for (unsigned i=0; i<kNChannelsPerDDL; i++) {
+    if (ddl.channels[i].mapped && ddl.channels[i].position==kNoPosition) {
+      channels.push_back(ddl.channels+i);
+    }
+  }
+  std::sort(channels.begin(), channels.end(), PadPlaneLess());
+  // the blocks of the slots are placed in slot order, neighbouring pads
+  // and padrows are adjacent in the signal buffers; the accumulation
+  // buffers are narrowed channel by channel and allocate on demand
+  ddl.buffer->ReserveSlots(channels.size());
+  for (unsigned i=0; i<ddl.underflowBuffers.size(); i++) {
+    ddl.underflowBuffers[i]->ReserveSlots(channels.size());
+  }
+  for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+       chit!=channels.end(); chit++) {
+    (*chit)->position=ddl.buffer->AddChannel();
+    for (unsigned i=0; i<ddl.underflowBuffers.size(); i++) {
+      ddl.underflowBuffers[i]->AddChannel();
+    }
+    if (ddl.wideBuffer) {
+      ddl.wideBuffer->AddChannel();
+      for (unsigned i=0; i<ddl.wideUnderflowBuffers.size(); i++) {
+	ddl.wideUnderflowBuffers[i]->AddChannel();
+      }
     }
   }
+}
 
-  // TODO: make better condition
-  const int maxNTimeframes=10; // max number of timeframes with stored histograms
-  static int timeframeNo=0;
-  const int maxNChannelHistograms=1000; // max number of channel histograms written per timeframe
-  int nChannelHistograms=0;
-  TFolder* currentFolder=NULL;
-  if (mChannelHistograms &&
-      timeframeNo < maxNTimeframes) {
-    TString name;
-    name.Form("timeframe_%03d", timeframeNo);
-    currentFolder = new TFolder(name, name);
-    mChannelHistograms->Add(currentFolder);
-  }
-  for (std::map<unsigned int, unsigned int>::const_iterator chit=mChannelPositions.begin();
-       chit!=mChannelPositions.end(); chit++) {
-    unsigned index=chit->first;
-    unsigned position=chit->second;
-    position*=mChannelLenght;
-    DDLNumber=(index&0xffff0000)>>16;
-    HWAddr=index&0x0000ffff;
-    if (mChannelMappingPadrow.find(index) != mChannelMappingPadrow.end()) {
-      PadRow=mChannelMappingPadrow[index];
-      Pad=mChannelMappingPad[index];
+unsigned ChannelMerger::GetChannelThreshold(const ChannelInfo& channel) const
+{
+  unsigned int threshold=mZSThreshold;
+  if (threshold != VOID_SIGNAL) {
+    if (mBaselineshift<0) {
+      threshold+=-mBaselineshift;
+    } else if (threshold<=(unsigned)mBaselineshift) {
+      threshold=0;
     } else {
-      PadRow=-1;
-      Pad=-1;
+      threshold-=mBaselineshift;
     }
-    TH1* hChannel=NULL;
-    if (currentFolder!=NULL &&
-	nChannelHistograms<maxNChannelHistograms &&
-	PadRow>=0) {
-      TString name;
-      name.Form("TF_%03d_DDL_%d_HWAddr_%d_PadRow_%d_Pad_%d", timeframeNo, DDLNumber, HWAddr, PadRow, Pad);
-      hChannel=new TH1F(name, name, mChannelLenght, 0., mChannelLenght);
-      currentFolder->Add(hChannel);
-      nChannelHistograms++;
+    // adjust threshold to baseline
+    threshold+=channel.baseline;
+  }
+  return threshold;
+}
+
+namespace {
+  /**
+   * Zero suppression of one signal of a bunch.
+   * Signal peak starts at two consecutive signals over threshold, signals
+   * below threshold are kept inside the peak if the next or next to next
+   * signal is over threshold.
+   * @return signal, 0 if suppressed
+   */
+  unsigned SuppressSignal(const unsigned short* signals, int i, int bunchLength, unsigned threshold, bool& bSignalPeak)
+  {
+    unsigned currentSignal=signals[i];
+    if (!bSignalPeak && currentSignal>threshold &&
+	i+1<bunchLength && signals[i+1]>threshold) {
+      // signal peak starts at two consecutive signals over threshold
+      bSignalPeak=true;
+    } else if (bSignalPeak && currentSignal>threshold) {
+      // signal belonging to active signal peak
+    } else if (bSignalPeak && currentSignal<=threshold) {
+      if ((i+1<bunchLength && signals[i+1]>threshold) ||
+	  (i+2<bunchLength && signals[i+2]>threshold)) {
+	// signal below threshold after peak, merged if next or
+	// next to next signal over threshold
+	// two signal peaks intercepted by one or two consecutive
+	// signals below threshold are merged
+      } else {
+	// signal below threshold after peak
+	bSignalPeak=false;
+	currentSignal=0;
+      }
+    } else {
+      // suppress signal
+      currentSignal=0;
     }
-    MinSignal=-1;
-    MaxSignal=-1;
-    MinSignalDiff=-1;
-    MaxSignalDiff=-1;
-    AvrgSignal=0;
-    MinTimebin=-1;
-    MaxTimebin=mChannelLenght;
-    NFilledTimebins=0;
-    NBunches=0;
-    int nBunchSamples=0;
-    for (unsigned i=0; i<mChannelLenght; i++) {
-      int signal=mBuffer[position+i];
-      if (signal == VOID_SIGNAL) {
-	if (nBunchSamples>0) {
-	  BunchLength[NBunches++]=nBunchSamples;
-	  nBunchSamples=0;
-	}
-	continue;
+    return currentSignal;
+  }
+}
+
+int ChannelMerger::AddBunch(DDLData& ddl, const ChannelInfo& channel, unsigned threshold, int startTime, int bunchLength, const unsigned short* signals)
+{
+  unsigned position=channel.position;
+  unsigned int baseline=channel.baseline;
+  assert(position<ddl.buffer->GetNChannels());
+  // baseline subtracted from the signals to be accumulated
+  unsigned tb=baseline;
+  if (mBaselineshift<0) tb+=-mBaselineshift;
+  else if ((unsigned)mBaselineshift<tb) tb-=mBaselineshift;
+
+  const unsigned kBlockLength=SampleStore::kBlockLength;
+  const int channelLength=mChannelLenght;
+  const int nUnderflowFrames=ddl.underflowBuffers.size();
+  // signals and first values of one segment in order of ascending timebin
+  buffer_t added[kBlockLength];
+  buffer_t first[kBlockLength];
+  bool noise[kBlockLength];
+  bool bSignalPeak=false;
+  for (int i=0; i<bunchLength;) {
+    // the signals are in order of descending timebins, the segment ends at
+    // the start of the block or at the start of the timeframe; negative
+    // timebins belong to the following frames
+    int timebin=startTime-i;
+    int frame=timebin<0?(-timebin-1)/channelLength+1:0;
+    bool bUnderflow=frame>0;
+    int buffertime=timebin+frame*channelLength;
+    bool bInRange=frame<=nUnderflowFrames && buffertime<channelLength;
+    int n=bunchLength-i;
+    if (bInRange && n>buffertime%(int)kBlockLength+1) n=buffertime%kBlockLength+1;
+    if (!bInRange && timebin>=channelLength && n>timebin-channelLength+1) n=timebin-channelLength+1;
+
+    for (int k=0; k<n; k++, i++) {
+      assert(signals[i]<1024);
+      if (signals[i]>=1024) {
+	std::ostringstream message;
+	message << "invalid signal value " << signals[i] << std::endl;
+	ddl.messages+=message.str();
       }
-      if (hChannel) {
-	hChannel->Fill(i, signal);
+
+      unsigned currentSignal=signals[i];
+      unsigned originalSignal=signals[i];
+      // ZS
+      if (threshold!=VOID_SIGNAL) {
+	currentSignal=SuppressSignal(signals, i, bunchLength, threshold, bSignalPeak);
       }
-      nBunchSamples++;
-      if (MinTimebin<0) MinTimebin=i;
-      MaxTimebin=i;
-      if (MinSignal<0 || MinSignal>signal) MinSignal=signal;
-      if (MaxSignal<0 || MaxSignal<signal) MaxSignal=signal;
-      AvrgSignal+=signal;
-      NFilledTimebins++;
-      if (i>0 && mBuffer[position+i-1] != VOID_SIGNAL) {
-	signal-=mBuffer[position+i-1];
-	if (MaxSignalDiff<0 || MaxSignalDiff<(signal>=0?signal:-signal))
-	  MaxSignalDiff=signal;
-	if (MinSignalDiff<0 || MinSignalDiff>(signal>=0?signal:-signal))
-	  MinSignalDiff=signal;
+      // subtract baseline
+      if (originalSignal<baseline) originalSignal=0;
+      else originalSignal-=baseline;
+      if (currentSignal<tb) currentSignal=0;
+      else currentSignal-=tb;
+
+      if (!bInRange) {
+	// TODO: some out-of-range counter
+	std::ostringstream message;
+	message << "sample with timebin " << startTime-i << " out of range" << std::endl;
+	ddl.errors+=message.str();
+	continue;
       }
+      // first value in a timebin without signal is noise base line if
+      // the signal is suppressed
+      added[n-1-k]=currentSignal;
+      first[n-1-k]=originalSignal;
+      noise[n-1-k]=currentSignal==0 && mNoiseFactor > 1;
     }
-    if (nBunchSamples>0) {
-      BunchLength[NBunches++]=nBunchSamples;
-      nBunchSamples=0;
+    if (!bInRange) continue;
+
+    unsigned block=(buffertime-n+1)/kBlockLength;
+    unsigned offset=(buffertime-n+1)%kBlockLength;
+    unsigned nOverflows=0;
+    if (ddl.wideBuffer) {
+      WideSampleStore* buffer=bUnderflow?ddl.wideUnderflowBuffers[frame-1]:ddl.wideBuffer;
+      WideSampleStore::sample_t* data=buffer->GetBlock(position, block)+offset;
+      if (mNoiseFactor > 1) {
+	// the noise manipulation is random, applied in the original order
+	// of the signals to timebins without signal only; the number is
+	// drawn for every noise sample, the random stream of a frame does
+	// not depend on the samples shifted in from preceding frames
+	for (int k=n; k-->0;) {
+	  if (!noise[k]) continue;
+	  unsigned noiseSignal=ManipulateNoise(first[k], ddl.random);
+	  if (data[k]==WideSampleStore::kVoidSample) first[k]=noiseSignal;
+	}
+      }
+      nOverflows=SignalAccumulation::Add(data, added, first, n);
+    } else {
+      SampleStore* buffer=bUnderflow?ddl.underflowBuffers[frame-1]:ddl.buffer;
+      buffer_t* data=buffer->GetBlock(position, block)+offset;
+      if (mNoiseFactor > 1) {
+	for (int k=n; k-->0;) {
+	  if (!noise[k]) continue;
+	  unsigned noiseSignal=ManipulateNoise(first[k], ddl.random);
+	  if (data[k]==VOID_SIGNAL) first[k]=noiseSignal;
+	}
+      }
+      nOverflows=SignalAccumulation::Add(data, added, first, n);
     }
-    if (NFilledTimebins>0) {
-      AvrgSignal/=NFilledTimebins;
+    // range overflow, the sum saturates at the maximum signal; overflow is
+    // only counted for buffer of current timeframe
+    if (nOverflows>0 && !bUnderflow) {
+      if (ddl.signalOverflowCount<10) {
+	std::ostringstream message;
+	message << "overflow in timebins " << buffertime-n+1 << " to " << buffertime
+		<< " of channel 0x" << std::hex << channel.index << std::dec
+		<< ": " << nOverflows << " sample(s) saturated at MAX_ACCUMULATED_SIGNAL=" << MAX_ACCUMULATED_SIGNAL
+		<< std::endl;
+	ddl.messages+=message.str();
+      }
+      ddl.signalOverflowCount+=nOverflows;
     }
-    target.Fill();
-    if (statfile) {
-      (*statfile) << std::setw(3) << DDLNumber
-		  << std::setw(6) << HWAddr
-		  << std::setw(6) << AvrgSignal
-		  << std::setw(6) << MinSignal
-		  << std::setw(6) << MaxSignal
-		  << std::setw(6) << NFilledTimebins
-		  << std::setw(6) << NBunches
-		  << std::endl;
+  }
+
+  return 0;
+}
+
+void ChannelMerger::NarrowAccumulation(unsigned scalingFactor)
+{
+  for (std::vector<DDLData*>::iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl==NULL || (*ddl)->wideBuffer==NULL) continue;
+    WideSampleStore& wideBuffer=*(*ddl)->wideBuffer;
+    SampleStore& buffer=*(*ddl)->buffer;
+    (*ddl)->signalOverflowCount=0;
+    for (std::vector<ChannelInfo*>::const_iterator chit=(*ddl)->addedChannels.begin();
+	 chit!=(*ddl)->addedChannels.end(); chit++) {
+      unsigned position=(*chit)->position;
+      // only allocated blocks can hold signals
+      for (unsigned block=0; block<wideBuffer.GetNBlocksPerChannel(); block++) {
+	const WideSampleStore::sample_t* data=wideBuffer.FindBlock(position, block);
+	if (data==NULL) continue;
+	(*ddl)->signalOverflowCount+=SignalAccumulation::Narrow(data, SampleStore::kBlockLength, scalingFactor,
+								buffer.GetBlock(position, block));
+      }
     }
   }
-  timeframeNo++;
+}
 
-  if (statfile) {
-    statfile->close();
-    delete statfile;
-    statfile = NULL;
+int ChannelMerger::Normalize(unsigned scalingFactor)
+{
+  if (scalingFactor==0) return 0;
+  if (mWideAccumulation) {
+    // the full sums are kept in the 32 bit samples
+    NarrowAccumulation(scalingFactor);
+    return 0;
   }
 
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+       chit!=channels.end(); chit++) {
+    unsigned position=(*chit)->position;
+    SampleStore& buffer=GetBuffer(**chit);
+    // only allocated blocks can hold signals
+    for (unsigned block=0; block<buffer.GetNBlocksPerChannel(); block++) {
+      buffer_t* data=buffer.FindBlock(position, block);
+      if (data==NULL) continue;
+      for (unsigned i=0; i<SampleStore::kBlockLength; i++) {
+	unsigned signal=data[i];
+	if (signal == VOID_SIGNAL) continue;
+	data[i]=signal/scalingFactor;
+      }
+    }
+  }
   return 0;
 }
 
@@ -561,7 +1410,7 @@ int ChannelMerger::InitChannelBaseline(const char* filename, int baselineshift)
 {
   std::ifstream input(filename);
   if (!input.good()) return -1;
-  std::cout << "reading channel baseline configuration from file " << filename << std::endl;
+  (*mLog) << "reading channel baseline configuration from file " << filename << std::endl;
 
   int DDLNumber=-1;
   int HWAddr=-1;
@@ -579,7 +1428,8 @@ int ChannelMerger::InitChannelBaseline(const char* filename, int baselineshift)
       AvrgSignal+=baselineshift;
       if (AvrgSignal<0) AvrgSignal=0;
       unsigned index=DDLNumber<<16 | HWAddr;
-      mChannelBaseline[index]=AvrgSignal;
+      ChannelInfo* channel=GetChannelInfo(index);
+      if (channel) channel->baseline=AvrgSignal;
     }
     // read the rest of the line
     input.getline(buffer, bufferSize);
@@ -591,7 +1441,7 @@ int ChannelMerger::InitAltroMapping(const char* filename)
 {
   std::ifstream input(filename);
   if (!input.good()) return -1;
-  std::cout << "reading altro mapping from file " << filename << endl;
+  (*mLog) << "reading altro mapping from file " << filename << std::endl;
 
   int DDLNumber=-1;
   int HWAddr=-1;
@@ -608,15 +1458,21 @@ int ChannelMerger::InitAltroMapping(const char* filename)
     input >> Pad;
     if (input.good()) {
       unsigned index=DDLNumber<<16 | HWAddr;
-      mChannelMappingPadrow[index]=Padrow;
-      mChannelMappingPad[index]=Pad;
+      ChannelInfo* channel=GetChannelInfo(index);
+      if (channel) {
+	if (!channel->mapped) mNMappedChannels++;
+	channel->mapped=true;
+	channel->padrow=Padrow;
+	channel->pad=Pad;
+      }
     }
     // read the rest of the line
     input.getline(buffer, bufferSize);
   }
+  UpdateChannelSelection();
 
-  std::cout << "... read altro mapping for " << mChannelMappingPadrow.size() << " channel(s)" << endl;
-  return mChannelMappingPadrow.size();
+  (*mLog) << "... read altro mapping for " << mNMappedChannels << " channel(s)" << std::endl;
+  return mNMappedChannels;
 }
 
 unsigned ChannelMerger::GetThreshold() const
@@ -640,84 +1496,46 @@ int ChannelMerger::CalculateZeroSuppression(bool bApply, bool bSetOccupancy)
   unsigned threshold=GetThreshold();
   if (threshold==VOID_SIGNAL) return 0;
 
-  for (std::map<unsigned int, unsigned int>::const_iterator chit=mChannelPositions.begin();
-       chit!=mChannelPositions.end(); chit++) {
-    unsigned index=chit->first;
-    unsigned position=chit->second;
-    position*=mChannelLenght;
-    buffer_t* signalBuffer=mBuffer+position;
+  std::vector<buffer_t> channelData(mChannelLenght);
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+       chit!=channels.end(); chit++) {
+    ChannelInfo& channel=**chit;
+    unsigned position=channel.position;
+    buffer_t* signalBuffer=&channelData[0];
+    GetBuffer(**chit).GetDenseChannel(position, signalBuffer);
     int result=SignalBufferZeroSuppression(signalBuffer, mChannelLenght, threshold, mBaselineshift, bApply?signalBuffer:NULL);
+    if (result>=0 && bApply) {
+      GetBuffer(**chit).SetDenseChannel(position, signalBuffer);
+    }
     if (result>=0 && bSetOccupancy) {
-      mChannelOccupancy[index] = result;
+      channel.occupancy = result;
     }
   }
   return 0;
 }
 
-int ChannelMerger::SignalBufferZeroSuppression(ChannelMerger::buffer_t* buffer, unsigned size, unsigned threshold, int baselineshift, buffer_t* target) const
+int ChannelMerger::SignalBufferZeroSuppression(const ChannelMerger::buffer_t* buffer, unsigned size, unsigned threshold, int baselineshift, buffer_t* target) const
 {
-  {// additional scope to keep formatting
-    if (!buffer) return -1;
-    unsigned nFilledTimebins=0;
-    bool bSignalPeak=false;
-    for (int i=size-1; i>=0; i--) {
-      unsigned currentSignal=buffer[i];
-      if (currentSignal == VOID_SIGNAL) {
-	currentSignal=0;
-      }
-
-      if (!bSignalPeak && currentSignal>threshold &&
-	  i>=1 && buffer[i-1]>threshold && buffer[i-1]!=VOID_SIGNAL) {
-	// signal peak starts at two consecutive signals over threshold
-	bSignalPeak=true;
-      } else if (bSignalPeak && currentSignal>threshold) {
-	// signal belonging to active signal peak
-      } else if (bSignalPeak && currentSignal<=threshold) {
-	if ((i>=1 && buffer[i-1] != VOID_SIGNAL && buffer[i-1]>threshold) ||
-	    (i>=2 && buffer[i-1] != VOID_SIGNAL && buffer[i-2] != VOID_SIGNAL && buffer[i-2]>threshold)) {
-	  // signal below threshold after peak, merged if next or
-	  // next to next signal over threshold
-	  // two signal peaks intercepted by one or two consecutive
-	  // signals below threshold are merged
-	} else {
-	  // signal below threshold after peak
-	  bSignalPeak=false;
-	  currentSignal=VOID_SIGNAL;
-	}
-      } else {
-	// suppress signal
-	currentSignal=VOID_SIGNAL;
-      }
-
-      if (currentSignal != VOID_SIGNAL) {
-	if (baselineshift<0) {
-	  if ((int)currentSignal>-baselineshift) currentSignal-=-baselineshift;
-	  else currentSignal=0;
-	} else {
-	  // TODO: not sure if this makes sense
-	  currentSignal+=baselineshift;
-	}
-      }
-
-      if (target) {
-	if (buffer[i] != VOID_SIGNAL) {
-	  target[i] = currentSignal;
-	} else {
-	  target[i] = VOID_SIGNAL;
-	}
-      }
-      if (currentSignal != VOID_SIGNAL && buffer[i] != VOID_SIGNAL) {
-	nFilledTimebins++;
-      }
-    }
-
-    return nFilledTimebins;
-  }
-  return 0;
+  // vectorized kernel, identical to the sample by sample processing of
+  // ZeroSuppression::ApplyReference
+  return ZeroSuppression::Apply(buffer, size, threshold, baselineshift, target);
 }
 
 int ChannelMerger::WriteTimeframe(const char* filename)
 {
+  if (TimeframeFile::IsTimeframeFile(filename)) {
+    TimeframeWriter writer;
+    int result=writer.Open(filename, mChannelLenght);
+    if (result>=0) result=WriteTimeframe(writer, 0);
+    if (result>=0) result=writer.Close();
+    if (result<0) {
+      std::cerr << "can not write timeframe data to file '" << filename << "'" << std::endl;
+      return result;
+    }
+    return 0;
+  }
+
   std::ofstream output(filename);
   if (!output.good()) {
     std::cerr << "can not open file '" << filename << "' for writing timeframe data" << std::endl;
@@ -725,167 +1543,83 @@ int ChannelMerger::WriteTimeframe(const char* filename)
   }
 
   unsigned nChannels=0;
-  for (std::map<unsigned int, unsigned int>::const_iterator chit=mChannelPositions.begin();
-       chit!=mChannelPositions.end(); chit++, nChannels++) {
-    unsigned index=chit->first;
-    unsigned position=chit->second;
-    unsigned DDLNumber=(index&0xffff0000)>>16;
-    unsigned HWAddr=index&0x0000ffff;
-    position*=mChannelLenght;
-    unsigned NBunches=0;
-    int nBunchSamples=0;
-    unsigned int BunchLength[mChannelLenght];
-    unsigned int BunchTime[mChannelLenght];
-    // loop over channel to find number of bunches and length of bunches
-    for (int iSignal=mChannelLenght-1; iSignal>=0; iSignal--) {
-      int signal=mBuffer[position+iSignal];
-      if (signal == VOID_SIGNAL) {
-	if (nBunchSamples>0) {
-	  // bunch end
-	  BunchLength[NBunches++]=nBunchSamples;
-	  nBunchSamples=0;
-	}
-	continue;
-      }
-      if (nBunchSamples++==0) {
-	// bunch start
-	BunchTime[NBunches]=iSignal;
-      }
-    }
-    if (nBunchSamples>0) {
-      BunchLength[NBunches++]=nBunchSamples;
-      nBunchSamples=0;
-    }
+  std::vector<buffer_t> channelData(mChannelLenght);
+  std::vector<unsigned> bunchLength(mChannelLenght);
+  std::vector<unsigned> bunchTime(mChannelLenght);
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+       chit!=channels.end(); chit++, nChannels++) {
+    unsigned position=(*chit)->position;
+    GetBuffer(**chit).GetDenseChannel(position, &channelData[0]);
     if (nChannels>0) output << std::endl;
-    // write channel header
-    output << " " << std::setw(4) << DDLNumber
-	   << " " << std::setw(6) << HWAddr
-	   << " " << std::setw(4) << NBunches;
-    // write bunches
-    for (unsigned iBunch=0; iBunch<NBunches; iBunch++) {
-      output << " " << std::setw(4) << BunchLength[iBunch]
-	     << " " << std::setw(4) << BunchTime[iBunch];
-      for (unsigned i=0; i<BunchLength[iBunch]; i++) {
-	output << " " << std::setw(4) << mBuffer[position+BunchTime[iBunch]-i];
-      }
-    }
-    output << std::endl;
+    WriteChannel(output, **chit, &channelData[0], &bunchLength[0], &bunchTime[0]);
   }
 
   return 0;
 }
 
-int ChannelMerger::DoHuffmanCompression(AliHLTHuffman* pHuffman, bool bTrainingMode, TH2& hHuffmanFactor, TH1& hSignalDiff, TTree* huffmanstat, unsigned symbolCutoffLength)
+int ChannelMerger::WriteTimeframe(TimeframeWriter& writer, unsigned frameNumber)
 {
-  // TODO: very quick solution to estimate potentisl of huffman compressions
-  // to be implemented in a more modular fashion
-  // tree setup
-  int DDLNumber=-1;
-  int HWAddr=-1;
-  int PadRow=-2;
-  int NFilledTimebins=-1;
-  Float_t HuffmanFactor=1.;
-
-  if (huffmanstat) {
-    if (huffmanstat->GetBranch("DDLNumber") != NULL) {
-      huffmanstat->SetBranchAddress("DDLNumber", &DDLNumber);
-    }
-
-    if (huffmanstat->GetBranch("HWAddr") != NULL) {
-      huffmanstat->SetBranchAddress("HWAddr", &HWAddr);
-    }
-
-    if (huffmanstat->GetBranch("PadRow") != NULL) {
-      huffmanstat->SetBranchAddress("PadRow", &PadRow);
-    }
-
-    if (huffmanstat->GetBranch("NFilledTimebins") != NULL) {
-      huffmanstat->SetBranchAddress("NFilledTimebins", &NFilledTimebins);
-    }
-
-    if (huffmanstat->GetBranch("HuffmanFactor") != NULL) {
-      huffmanstat->SetBranchAddress("HuffmanFactor", &HuffmanFactor);
-    }
+  int result=writer.StartFrame(frameNumber);
+  if (result<0) return result;
+  std::vector<buffer_t> channelData(mChannelLenght);
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+       chit!=channels.end(); chit++) {
+    GetBuffer(**chit).GetDenseChannel((*chit)->position, &channelData[0]);
+    writer.AddDenseChannel((*chit)->index, &channelData[0], mChannelLenght, VOID_SIGNAL);
   }
+  result=writer.FinishFrame();
+  return result<0?result:0;
+}
 
-  for (std::map<unsigned int, unsigned int>::const_iterator chit=mChannelPositions.begin();
-       chit!=mChannelPositions.end(); chit++) {
-    unsigned index=chit->first;
-    unsigned position=chit->second;
-    position*=mChannelLenght;
-    DDLNumber=(index&0xffff0000)>>16;
-    HWAddr=index&0x0000ffff;
-    if (mChannelMappingPadrow.find(index) != mChannelMappingPadrow.end()) {
-      PadRow=mChannelMappingPadrow[index];
-    } else {
-      PadRow=-1;
-    }
-    if (mChannelOccupancy.find(index) != mChannelOccupancy.end()) {
-      NFilledTimebins = mChannelOccupancy[index];
-    } else {
-      NFilledTimebins = -1;
+int ChannelMerger::EncodeTimeframe(HuffmanCoder& coder, bool bTrainingMode, std::vector<unsigned char>& target)
+{
+  // TODO: make this a property of the merger/data
+  const unsigned signalRange=1024;
+  if (!bTrainingMode && !coder.IsReady()) return -EINVAL;
+
+  unsigned initialSize=target.size();
+  std::vector<buffer_t> channelData(mChannelLenght);
+  std::vector<buffer_t> symbols(mChannelLenght);
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+       chit!=channels.end(); chit++) {
+    unsigned position=(*chit)->position;
+    GetBuffer(**chit).GetDenseChannel(position, &channelData[0]);
+    CodeLengthTable::DeltaSymbols(&channelData[0], mChannelLenght, signalRange, &symbols[0]);
+    if (bTrainingMode) {
+      coder.AddTrainingValues(&symbols[0], mChannelLenght);
+      continue;
     }
+    int result=coder.EncodeChannel((*chit)->index, &symbols[0], mChannelLenght, target);
+    if (result<0) return result;
+  }
 
-    HuffmanFactor=0.;
-
-    // TODO: make this a property of the merger/data
-    unsigned signalRange=1024;
-    unsigned signalBitLength=10;
-
-    unsigned bitcount=0;
-    unsigned lastSignal=0;
-    for (unsigned i=0; i<mChannelLenght; i++) {
-      unsigned signal=mBuffer[position+i];
-      if (signal == VOID_SIGNAL) {
-	signal=0;
-      }
-      if (signal >= signalRange) {
-	// TODO: handling of signal exceeding the range needs to be defined.
-	// this should be handled in the pile up algorithm
-	signal=signalRange-1;
-      }
-
-      int signalDiff = signal;
-      signalDiff-=lastSignal;
-      hSignalDiff.Fill(signalDiff);
-      signalDiff+=signalRange;
-      if (signalDiff>=0 && (unsigned)signalDiff<2*signalRange) {
-      } else {
-	std::cout << "signal difference out of range: " << signalDiff << std::endl;
-      }
-      assert(signalDiff>=0 && (unsigned)signalDiff<2*signalRange);
+  return target.size()-initialSize;
+}
 
-      AliHLTUInt64_t v = signalDiff;
-      if (bTrainingMode) {
-	pHuffman->AddTrainingValue(v);
-      } else {
-	AliHLTUInt64_t length = 0;
-	pHuffman->Encode(v, length);
-	if (symbolCutoffLength==0 || length<symbolCutoffLength) {
-	  bitcount+=length;
-	} else {
-	 bitcount+=symbolCutoffLength;
-	 bitcount+=signalBitLength;
-	}
-      }
-      lastSignal=signal;
-    }
-    if (!bTrainingMode && bitcount>0) {
-      bitcount+=(40-bitcount%40); // align to 40 bit altro format
-      HuffmanFactor=mChannelLenght*signalBitLength;
-      HuffmanFactor/=bitcount;
-      if (huffmanstat) {
-	huffmanstat->Fill();
-      }
-      hHuffmanFactor.Fill(PadRow, HuffmanFactor);
-      if (HuffmanFactor<1.) {
-	std::cout << "HuffmanFactor smaller than 1: " << HuffmanFactor << " bitcount " << bitcount << std::endl;
-      }
-      //assert(HuffmanFactor>=1.);
+void ChannelMerger::WriteChannel(std::ostream& output, const ChannelInfo& channel, const buffer_t* channelData,
+				 unsigned* BunchLength, unsigned* BunchTime) const
+{
+  unsigned index=channel.index;
+  unsigned DDLNumber=(index&0xffff0000)>>16;
+  unsigned HWAddr=index&0x0000ffff;
+  // loop over channel to find number of bunches and length of bunches
+  unsigned NBunches=mKernels->FindBunches(channelData, mChannelLenght, BunchLength, BunchTime);
+  // write channel header
+  output << " " << std::setw(4) << DDLNumber
+	 << " " << std::setw(6) << HWAddr
+	 << " " << std::setw(4) << NBunches;
+  // write bunches
+  for (unsigned iBunch=0; iBunch<NBunches; iBunch++) {
+    output << " " << std::setw(4) << BunchLength[iBunch]
+	   << " " << std::setw(4) << BunchTime[iBunch];
+    for (unsigned i=0; i<BunchLength[iBunch]; i++) {
+      output << " " << std::setw(4) << channelData[BunchTime[iBunch]-i];
     }
   }
-
-  return 0;
+  output << std::endl;
 }
 
 int ChannelMerger::WriteSystemcInputFile(const char* filename)
@@ -901,29 +1635,28 @@ int ChannelMerger::WriteSystemcInputFile(const char* filename)
   // The input method is implemented in DataGenerator::readBlackEvents
   // Note: Currently, this method can only read one bunch per channel
   // TODO: this function can probably be merged with WriteTimeframe
-  int DDLNumber=-1;
   int HWAddr=-1;
-  int PadRow=-2;
 
   if (!filename) return -1;
+  // binary input of the DataGenerator, see DataGenerator::readTimeframes
+  if (TimeframeFile::IsTimeframeFile(filename)) return WriteTimeframe(filename);
+  // the SystemC simulation reads a fixed range of timebins, see below
+  if (mChannelLenght<=1021) return -EINVAL;
   std::ofstream ofile(filename);
   if (!ofile.good()) {
     return -1;
   }
 
-  for (std::map<unsigned int, unsigned int>::const_iterator chit=mChannelPositions.begin();
-       chit!=mChannelPositions.end(); chit++) {
-    unsigned index=chit->first;
-    unsigned position=chit->second;
-    position*=mChannelLenght;
-    DDLNumber=(index&0xffff0000)>>16;
+  std::vector<buffer_t> channelData(mChannelLenght);
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+       chit!=channels.end(); chit++) {
+    const ChannelInfo& channel=**chit;
+    unsigned index=channel.index;
+    unsigned position=channel.position;
+    GetBuffer(**chit).GetDenseChannel(position, &channelData[0]);
     HWAddr=index&0x0000ffff;
     ofile << "hw=" << HWAddr << std::endl;
-    if (mChannelMappingPadrow.find(index) != mChannelMappingPadrow.end()) {
-      PadRow=mChannelMappingPadrow[index];
-    } else {
-      PadRow=-1;
-    }
     // TODO: these values correspond to the numbers in the systemc SAMPA
     // simulation. Make them configurable.
     unsigned startTime=1021;
@@ -932,7 +1665,7 @@ int ChannelMerger::WriteSystemcInputFile(const char* filename)
     unsigned lowerBound=startTime-bunchLength;
     ofile << startTime << " " << bunchLength << std::endl;
     for (unsigned i=startTime; i>lowerBound; --i) {
-      unsigned signal=mBuffer[position+i];
+      unsigned signal=channelData[i];
       if (signal == VOID_SIGNAL) {
 	// write all timebins to create one bunch
 	signal=0;
@@ -946,65 +1679,199 @@ int ChannelMerger::WriteSystemcInputFile(const char* filename)
   return 0;
 }
 
-int ChannelMerger::ApplyCommonModeEffect(int scalingFactor)
-{
-  // buffer for sum of ZS signals of all channels
-  std::vector<buffer_t> cmSignal(mChannelLenght, 0);
-  // temporary buffer for calculation of ZS for one channel
-  std::vector<buffer_t> zsSignal(mChannelLenght, 0);
-  // 1. loop over all channels and sum ZS signals in each timebin
-  for (std::map<unsigned int, unsigned int>::const_iterator chit=mChannelPositions.begin();
-       chit!=mChannelPositions.end(); chit++) {
-    unsigned position=chit->second;
-    position*=mChannelLenght;
-    buffer_t* signalBuffer=mBuffer+position;
-    int result=SignalBufferZeroSuppression(signalBuffer, mChannelLenght, GetThreshold(), mBaselineshift, &zsSignal[0]);
-    if (result < 0) return result;
-    for (unsigned i=0; i<mChannelLenght; ++i) {
-      if (zsSignal[i] == VOID_SIGNAL) continue;
-      cmSignal[i]+=zsSignal[i];
+int ChannelMerger::ApplyCommonModeEffect(int scalingFactor, int grouping)
+{
+  if (scalingFactor==0) return -EINVAL;
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  std::vector<unsigned> channelGroup;
+  std::vector<unsigned> groupSize;
+  int nGroups=AssignCommonModeGroups(grouping, channelGroup, groupSize);
+  if (nGroups < 0) return nGroups;
+
+  // the DDLs are distributed over the tasks, groups do not span DDLs
+  // except the global group which is summed per task and combined
+  const unsigned nTasks=mThreadPool?mThreadPool->GetNThreads():1;
+  const unsigned nSlots=grouping==kCommonModeGlobal?nTasks:nGroups;
+  // every task processes a contiguous range of complete DDLs of the
+  // channels in the order of the buffers, the sums are independent of
+  // the order
+  const unsigned nChannels=channels.size();
+  std::vector<unsigned> order;
+  GetBufferOrder(order);
+  std::vector<unsigned> taskBegin(nTasks+1, nChannels);
+  taskBegin[0]=0;
+  for (unsigned t=1; t<nTasks; t++) {
+    unsigned begin=(unsigned long long)t*nChannels/nTasks;
+    if (begin<taskBegin[t-1]) begin=taskBegin[t-1];
+    while (begin>0 && begin<nChannels &&
+	   (channels[order[begin]]->index>>16)==(channels[order[begin-1]]->index>>16)) begin++;
+    taskBegin[t]=begin;
+  }
+  struct CommonModeTask {
+    /// dense view of the current channel
+    std::vector<buffer_t> channelData;
+    /// ZS signals of the current channel
+    std::vector<buffer_t> zsSignal;
+    /// cached ZS timebins and signals of all channels of the task
+    std::vector<unsigned> zsTime;
+    std::vector<buffer_t> zsValue;
+    /// start of the cached ZS signals of every channel of the task
+    std::vector<unsigned> zsOffset;
+    unsigned nUnderflow;
+    unsigned nUnderflowChannels;
+    int result;
+  };
+  std::vector<CommonModeTask> tasks(nTasks);
+  // sum of ZS signals per group in every timebin, 32 bit do not overflow
+  std::vector<unsigned> cmSignal(nSlots*mChannelLenght, 0);
+  std::vector<unsigned> cmScaled(nGroups*mChannelLenght, 0);
+
+  // 1. zero suppress every channel once, cache the ZS signals and sum them
+  ThreadPool::task_t sum=[&](unsigned t) {
+    CommonModeTask& task=tasks[t];
+    task.channelData.resize(mChannelLenght);
+    task.zsSignal.resize(mChannelLenght);
+    task.result=0;
+    for (unsigned k=taskBegin[t]; k<taskBegin[t+1]; k++) {
+      unsigned c=order[k];
+      buffer_t* signalBuffer=&task.channelData[0];
+      GetBuffer(*channels[c]).GetDenseChannel(channels[c]->position, signalBuffer);
+      unsigned slot=grouping==kCommonModeGlobal?t:channelGroup[c];
+      int result=AddCommonModeSignal(signalBuffer, &cmSignal[slot*mChannelLenght], &task.zsSignal[0]);
+      if (result < 0) {task.result=result; return;}
+      task.zsOffset.push_back(task.zsTime.size());
+      for (unsigned i=0; i<mChannelLenght; i++) {
+	if (task.zsSignal[i]==VOID_SIGNAL) continue;
+	task.zsTime.push_back(i);
+	task.zsValue.push_back(task.zsSignal[i]);
+      }
+    }
+    task.zsOffset.push_back(task.zsTime.size());
+  };
+  if (mThreadPool) mThreadPool->Run(nTasks, sum);
+  else sum(0);
+  for (unsigned t=0; t<nTasks; t++) {
+    if (tasks[t].result < 0) return tasks[t].result;
+  }
+  for (unsigned slot=1; grouping==kCommonModeGlobal && slot<nSlots; slot++) {
+    for (unsigned i=0; i<mChannelLenght; i++) {
+      cmSignal[i]+=cmSignal[slot*mChannelLenght+i];
     }
   }
 
-  if (scalingFactor<0) scalingFactor=mChannelPositions.size();
+  // the division is done once per group and timebin
+  for (int g=0; g<nGroups; g++) {
+    unsigned scaling=scalingFactor<0?groupSize[g]:scalingFactor;
+    if (scaling==0) continue;
+    const unsigned* sumSignal=&cmSignal[g*mChannelLenght];
+    unsigned* scaledSignal=&cmScaled[g*mChannelLenght];
+    for (unsigned i=0; i<mChannelLenght; i++) {
+      scaledSignal[i]=sumSignal[i]/scaling;
+    }
+  }
 
   // 2. subtract scaled (sum - current channel) from current channel
+  ThreadPool::task_t subtract=[&](unsigned t) {
+    CommonModeTask& task=tasks[t];
+    task.nUnderflow=0;
+    task.nUnderflowChannels=0;
+    unsigned n=0;
+    for (unsigned k=taskBegin[t]; k<taskBegin[t+1]; k++) {
+      unsigned c=order[k];
+      buffer_t* signalBuffer=&task.channelData[0];
+      GetBuffer(*channels[c]).GetDenseChannel(channels[c]->position, signalBuffer);
+      unsigned group=grouping==kCommonModeGlobal?0:channelGroup[c];
+      unsigned scaling=scalingFactor<0?groupSize[group]:scalingFactor;
+      unsigned offset=task.zsOffset[n++];
+      unsigned nZS=task.zsOffset[n]-offset;
+      int result=SubtractCommonModeSignal(signalBuffer, &cmSignal[group*mChannelLenght], &cmScaled[group*mChannelLenght], scaling,
+					  nZS, nZS>0?&task.zsTime[offset]:NULL, nZS>0?&task.zsValue[offset]:NULL);
+      task.nUnderflow+=result;
+      if (result>0) task.nUnderflowChannels++;
+      GetBuffer(*channels[c]).SetDenseChannel(channels[c]->position, signalBuffer);
+    }
+  };
+  if (mThreadPool) mThreadPool->Run(nTasks, subtract);
+  else subtract(0);
+
   unsigned nUnderflow=0;
   unsigned nUnderflowChannels=0;
-  for (std::map<unsigned int, unsigned int>::const_iterator chit=mChannelPositions.begin();
-       chit!=mChannelPositions.end(); chit++) {
-    unsigned position=chit->second;
-    position*=mChannelLenght;
-    bool bHaveUnderflow=false;
-    buffer_t* signalBuffer=mBuffer+position;
-    int result=SignalBufferZeroSuppression(signalBuffer, mChannelLenght, GetThreshold(), mBaselineshift, &zsSignal[0]);
-    if (result < 0) return result;
-    for (unsigned i=0; i<mChannelLenght; ++i) {
-      unsigned int cmImpact=cmSignal[i];
-      if (zsSignal[i] != VOID_SIGNAL) {
-	if (cmImpact > zsSignal[i]) {
-	  cmImpact -= zsSignal[i];
-	} else {
-	  cmImpact = 0;
-	}
-      }
-      cmImpact/=scalingFactor;
-      if (mBuffer[position + i] < cmImpact) {
-	mBuffer[position + i] = 0;
-	nUnderflow++;
-	if (!bHaveUnderflow) nUnderflowChannels++;
-	bHaveUnderflow = true;
-      } else {
-	mBuffer[position + i] -= cmImpact;
-      }
-    }
+  for (unsigned t=0; t<nTasks; t++) {
+    nUnderflow+=tasks[t].nUnderflow;
+    nUnderflowChannels+=tasks[t].nUnderflowChannels;
   }
-  std::cout << "ApplyCommonModeEffect: scaling " << scalingFactor << "; " << nUnderflow << " underflow(s) in " << nUnderflowChannels << " channel(s)" << std::endl;
+  (*mLog) << "ApplyCommonModeEffect: ";
+  if (grouping!=kCommonModeGlobal) (*mLog) << nGroups << " group(s), ";
+  if (scalingFactor<0 && grouping!=kCommonModeGlobal) (*mLog) << "scaling by group size";
+  else (*mLog) << "scaling " << (scalingFactor<0?channels.size():scalingFactor);
+  (*mLog) << "; " << nUnderflow << " underflow(s) in " << nUnderflowChannels << " channel(s)" << std::endl;
 
   return 0;
 }
 
-unsigned ChannelMerger::ManipulateNoise(unsigned signal) const
+int ChannelMerger::AddCommonModeSignal(const buffer_t* signalBuffer, unsigned* cmSignal, buffer_t* zsSignal) const
+{
+  int result=SignalBufferZeroSuppression(signalBuffer, mChannelLenght, GetThreshold(), mBaselineshift, zsSignal);
+  if (result < 0) return result;
+  mKernels->AddCommonMode(zsSignal, mChannelLenght, cmSignal);
+  return result;
+}
+
+int ChannelMerger::SubtractCommonModeSignal(buffer_t* signalBuffer, const unsigned* cmSignal, const unsigned* cmScaled, unsigned scalingFactor,
+					    unsigned nZS, const unsigned* zsTime, const buffer_t* zsValue) const
+{
+  // the own contribution is only removed in the few timebins with ZS
+  // signal, the original signals are kept for the correction
+  const unsigned kMaxLocal=64;
+  buffer_t localOriginal[kMaxLocal];
+  std::vector<buffer_t> original(nZS>kMaxLocal?nZS:0);
+  buffer_t* originalSignal=nZS>kMaxLocal?&original[0]:localOriginal;
+  for (unsigned i=0; i<nZS; i++) originalSignal[i]=signalBuffer[zsTime[i]];
+
+  int nUnderflow=mKernels->SubtractCommonMode(signalBuffer, mChannelLenght, cmScaled);
+  for (unsigned i=0; i<nZS; i++) {
+    unsigned timebin=zsTime[i];
+    unsigned signal=originalSignal[i];
+    unsigned cmImpact=cmSignal[timebin]>zsValue[i]?cmSignal[timebin]-zsValue[i]:0;
+    cmImpact/=scalingFactor;
+    if (signal<cmScaled[timebin]) nUnderflow--;
+    if (signal<cmImpact) {
+      signalBuffer[timebin]=0;
+      nUnderflow++;
+    } else {
+      signalBuffer[timebin]=signal-cmImpact;
+    }
+  }
+  return nUnderflow;
+}
+
+int ChannelMerger::AssignCommonModeGroups(int grouping, std::vector<unsigned>& channelGroup, std::vector<unsigned>& groupSize)
+{
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  channelGroup.assign(channels.size(), 0);
+  groupSize.clear();
+  if (grouping==kCommonModeGlobal) {
+    groupSize.push_back(channels.size());
+    return 1;
+  }
+  if (grouping!=kCommonModePartition && grouping!=kCommonModeFEC) return -EINVAL;
+  // partition: DDL number; FEC: DDL number, branch and FEC of the HW address
+  unsigned shift=grouping==kCommonModePartition?16:7;
+  std::map<unsigned, unsigned> groups;
+  for (unsigned c=0; c<channels.size(); c++) {
+    unsigned key=channels[c]->index>>shift;
+    std::map<unsigned, unsigned>::iterator group=groups.find(key);
+    if (group==groups.end()) {
+      group=groups.insert(std::make_pair(key, (unsigned)groupSize.size())).first;
+      groupSize.push_back(0);
+    }
+    channelGroup[c]=group->second;
+    groupSize[group->second]++;
+  }
+  return groupSize.size();
+}
+
+unsigned ChannelMerger::ManipulateNoise(unsigned signal, RandomGenerator& generator) const
 {
   // manipulate a noise signal by applying a factor and
   // add a randomized adc count in the range of the factor
@@ -1013,18 +1880,8 @@ unsigned ChannelMerger::ManipulateNoise(unsigned signal) const
   unsigned noisesignal=signal;
   if (factor <= 1) return signal;
   noisesignal *= factor;
-  noisesignal += std::rand() % factor;
+  noisesignal += generator.Uniform(factor);
   if (mBaselineshift<0 && noisesignal >= -mBaselineshift * (factor - 1))
     noisesignal -= -mBaselineshift * (factor - 1);
   return noisesignal;
 }
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-  // this function can be used to check whether the ChannelMerger is part
-  // of the Generator library
-  bool __IsChannelMergerIncludedInLibrary() {return true;}
-#ifdef __cplusplus
-}
-#endif
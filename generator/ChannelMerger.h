@@ -22,15 +22,28 @@
 
 #include <iostream>
 #include <vector>
-#include <map>
+#include <string>
+#include "RandomGenerator.h"
 
-class AliAltroRawStreamV3;
-class AliRawReader;
 class TTree;
 class TFolder;
 class TH1;
 class TH2;
 class AliHLTHuffman;
+template<typename SampleT> class SampleStoreT;
+typedef SampleStoreT<unsigned short> SampleStore;
+typedef SampleStoreT<unsigned> WideSampleStore;
+class ThreadPool;
+class ChannelMergerWorker;
+class DecodedEvent;
+class EventCache;
+class ChannelSource;
+class CollisionTimeline;
+class HuffmanCoder;
+class InputPrefetcher;
+class PedestalEstimator;
+class TimeframeWriter;
+struct ChannelKernels;
 
 /**
  * @class ChannelMerger
@@ -42,6 +55,20 @@ class AliHLTHuffman;
  * are added to the sample buffer. Timebins of a channel which are moved outside
  * the range are added to the underflow buffer and are used in the next frame.
  *
+ * Both buffers are sparse stores (see SampleStore) which only hold the
+ * filled regions of the channels, memory scales with the occupancy. The
+ * algorithms working on the full channel use a dense view of the channel.
+ *
+ * Events are read through the ChannelSource interface, input files are
+ * either raw data files or event archives (see EventArchive) created with
+ * ConvertToArchive. The merging is independent of ROOT and AliRoot, only
+ * the analysis functionality (Analyze, DoHuffmanCompression) and the raw
+ * data source require them.
+ *
+ * Channel table and buffers are kept separately for every DDL, DDLs do
+ * not share any data. Merging of collisions can thus be distributed over
+ * multiple threads each processing a range of DDLs, see SetNThreads.
+ *
  * @section Modes of operation
  * The class supports different modes of operation:
  * - accumulation: all signals are simply added to the sample buffer
@@ -50,6 +77,29 @@ class AliHLTHuffman;
  * - zero suppression: signal over threshold indicates cluster signal; noise
  *             signal otherwise
  *
+ * @section Continuous readout
+ * Timeframes follow each other seamlessly, samples of collisions shifted
+ * out of the current timeframe are kept in underflow buffers for the
+ * following timeframes. For continuous readout, the timeframes are the
+ * heartbeat frames, the channel length is set to the heartbeat frame
+ * length and the number of timebins of the input events, the drift
+ * length, can exceed it, see SetDriftLength. The collision times of the
+ * frames are taken from a continuous sequence, e.g. CollisionDistribution.
+ * One underflow buffer is kept per frame spanned by the drift length,
+ * the memory is bounded by drift length plus frame length independently
+ * of the number of generated frames.
+ *
+ * @section Channel layout
+ * The slots of the channels in the buffers of a DDL are assigned in the
+ * order of the first signal by default. With the pad plane layout, the
+ * mapped channels of a DDL get consecutive slots ordered by padrow and
+ * pad, see SetChannelLayout. The blocks of those slots are reserved in
+ * slot order, see SampleStoreT::ReserveSlots, neighbouring pads and
+ * padrows are adjacent in memory. Algorithms working on neighbouring pads
+ * and padrows iterate the padrows with PadRowIterator, the common mode
+ * effect and the channel statistics process the channels in the order of
+ * the buffers.
+ *
  * @section Tools and monitoring
  * tbc.
  *
@@ -72,21 +122,140 @@ class ChannelMerger {
   ChannelMerger();
   ~ChannelMerger();
 
+  /**
+   * Merge collisions into the current timeframe.
+   * Events are read from the input files in the list, see ChannelSource for
+   * the supported inputs.
+   * @param collisiontimes   offsets of the collisions wrt frame size
+   * @param inputfiles       list of input files, one per line
+   * @return number of merged collisions, negative error code if failed
+   */
   int MergeCollisions(std::vector<float> collisiontimes, std::istream& inputfiles);
 
+  /**
+   * Merge collisions into the current timeframe reading from a source.
+   * The source is not owned and must exist as long as the merger uses it.
+   * Worker threads require the source to support Clone.
+   */
+  int MergeCollisions(std::vector<float> collisiontimes, ChannelSource& source);
+
+  /**
+   * Assign the events of the input files to the collisions of a timeline.
+   * The events are assigned in the order of the sequential merging by
+   * MergeCollisions, events without data in the DDL range are skipped.
+   * The channels of every collision are recorded with the channel
+   * selection of the merger, the mapping and the ranges have to be
+   * initialized before. The inputs are read once, the data is not merged.
+   * @param timeline         timeline with the collision times of all frames
+   * @param inputfiles       list of input files, one per line
+   * @return number of frames with events for all collisions, negative
+   *         error code if failed
+   */
+  int AssignEvents(CollisionTimeline& timeline, std::istream& inputfiles);
+
+  /**
+   * Add the channels of all collisions of the timeline before a frame.
+   * The channel set is then identical to the one after merging all
+   * preceding frames, without reading their events.
+   * @return number of added channels
+   */
+  int RegisterChannels(const CollisionTimeline& timeline, unsigned endFrame);
+
+  /**
+   * Merge the collisions of a frame of the timeline into the current
+   * timeframe. The inputs are opened as required and positioned at the
+   * assigned events. Together with SeedTimeframe and the merging of the
+   * frames spanned by the drift length before, the frame is identical to
+   * the sequential merging of all frames.
+   * @return number of merged collisions, negative error code if failed
+   */
+  int MergeCollisions(const CollisionTimeline& timeline, unsigned frame);
+
   /**
    * Start a new timeframe.
    *
-   * Sample buffer and underflow buffer are exchanged to keep the sample
-   * of collisions which have been shifted out of previous timeframe.
-   * The new underflow buffer is cleared.
+   * The first underflow buffer becomes the sample buffer to keep the
+   * samples of collisions which have been shifted out of previous
+   * timeframes, the buffers are rotated without copying. The buffer of the
+   * last timeframe is cleared and reused for the last following frame, the
+   * cost scales with the number of channels which received shifted-out
+   * samples.
    */
   int StartTimeframe();
 
+  /**
+   * Move the data of the current timeframe to another merger.
+   * The channel table and the signal buffers are handed over together with
+   * the configuration required for processing the timeframe, i.e. ZS
+   * threshold and baselineshift. The target can process the timeframe, e.g.
+   * by Analyze or ProcessTimeframe, while this instance merges the next
+   * timeframe. Samples shifted into the next timeframe stay in this
+   * instance, the buffers are exchanged without copying the samples.
+   * @param target     merger receiving the timeframe, its previous data is dropped
+   * @return 0 on success, -EINVAL if the channel length differs
+   */
+  int MoveTimeframe(ChannelMerger& target);
+
   /**
    * Check overflow counter for the current TF
    */
-  unsigned int GetSignalOverflowCount() const {return mSignalOverflowCount;}
+  unsigned int GetSignalOverflowCount() const;
+
+  /// number of timebins of a channel
+  unsigned GetChannelLength() const {return mChannelLenght;}
+
+  /**
+   * Set the number of timebins of a channel, default 1024.
+   * The channel processing is specialized for 1024 and 1021 timebins,
+   * other lengths, e.g. longer frames, use the generic implementation.
+   * Has to be set before the first channel is added.
+   * @param length     number of timebins
+   * @return 0 on success, -EBUSY if channels exist, -EINVAL if length is 0
+   */
+  int SetChannelLength(unsigned length);
+
+  /**
+   * Set the number of timebins of the input events for continuous readout.
+   * Events exceeding the channel length, i.e. the heartbeat frame length,
+   * are spread over the following frames. The collision time refers to
+   * the earliest timebin of the event, samples are never shifted into
+   * frames which have been finished. Without drift length or for a drift
+   * length not exceeding the channel length, one underflow buffer is used.
+   * Has to be set before the first channel is added.
+   * @param length     number of timebins, 0 for the channel length
+   * @return 0 on success, -EBUSY if channels exist
+   */
+  int SetDriftLength(unsigned length);
+
+  /// number of timebins of the input events, the channel length if not set
+  unsigned GetDriftLength() const {return mDriftLength>mChannelLenght?mDriftLength:mChannelLenght;}
+
+  /// number of following frames kept in underflow buffers
+  unsigned GetNUnderflowFrames() const {return (GetDriftLength()-1)/mChannelLenght+1;}
+
+  /// assignment of the buffer slots to the channels
+  enum ChannelLayout {
+    /// slots in the order of the first signal of a channel
+    kLayoutFirstSeen=0,
+    /// slots of the mapped channels of a DDL ordered by padrow and pad
+    kLayoutPadPlane
+  };
+
+  /**
+   * Set the layout of the channel slots in the buffers.
+   * In the pad plane layout, the slots of all mapped channels of a DDL are
+   * assigned when the first channel of the DDL is added, the channel
+   * mapping has to be initialized before, see InitAltroMapping. Channels
+   * without mapping follow in the order of the first signal. The layout
+   * only changes the memory order, not the content of the timeframes.
+   * Has to be set before the first channel is added.
+   * @param layout     see ChannelLayout
+   * @return 0 on success, -EBUSY if channels exist, -EINVAL if invalid layout
+   */
+  int SetChannelLayout(int layout);
+
+  /// layout of the channel slots, see ChannelLayout
+  int GetChannelLayout() const {return mChannelLayout;}
 
   /**
    * Normalize signals of all timebins in all channels.
@@ -125,6 +294,8 @@ class ChannelMerger {
    * DDLNo   HWAddress  baselineADC   minADC  maxADC  nTimebins nBunches
    * </pre>
    * This format can be used to initialize the baseline for channels.
+   * The channels are analyzed in the order of the buffers, see
+   * SetChannelLayout.
    *
    * @param target        Target tree for statistics
    * @param statfilename  optional file name for dump in a text file
@@ -139,6 +310,87 @@ class ChannelMerger {
     mInputStreamMaxDDL=max;
   }
 
+  /**
+   * Set number of threads for merging of collisions.
+   *
+   * The DDL range is split into contiguous sub ranges which are merged
+   * concurrently, every thread reads the current event of the input with
+   * its own clone of the source. All TPC DDLs are distributed if no DDL range
+   * is set. Merging is done in the calling thread for 0 or 1.
+   */
+  void SetNThreads(unsigned nThreads);
+
+  /**
+   * Enable the cache of decoded events.
+   *
+   * Every raw event is decoded once into compact bunch lists and kept in
+   * memory, events occurring repeatedly in the input are merged from the
+   * cache. The least recently used events are removed if the size exceeds
+   * the limit.
+   *
+   * If a pool size is specified, the first poolSize events are read from
+   * the input and all further collisions are drawn randomly out of the
+   * cached events without reading the input any more. The cache size must
+   * be big enough to keep the pool.
+   * @param maxSize    maximum size of the cache in MByte, 0 disables cache
+   * @param poolSize   number of events for replay, 0 disables replay
+   */
+  int InitEventCache(unsigned maxSize, unsigned poolSize=0);
+
+  /**
+   * Open the next input files of the file list in advance.
+   *
+   * The files are opened in a background thread while the current file is
+   * merged, with readAhead also the first event is read, see
+   * InputPrefetcher. The file list stream is then read by the background
+   * thread and must not be used otherwise, it has to provide an end.
+   * @param depth      number of files opened in advance, 0 disables prefetch
+   * @param readAhead  read the first event of the prefetched files
+   */
+  void SetInputPrefetch(unsigned depth, bool readAhead=true);
+
+  /**
+   * Accumulate the signals in 32 bit samples.
+   *
+   * Signals are accumulated in 16 bit samples by default and saturate at
+   * the maximum signal, the saturated samples are counted, see
+   * GetSignalOverflowCount. For a high number of collisions, e.g. for the
+   * estimation of the baseline with Normalize, the signals can be
+   * accumulated in 32 bit samples. The sums are converted to the 16 bit
+   * samples after merging and by Normalize, the overflow count is then the
+   * number of samples saturated in the conversion. Has to be set before
+   * merging the first timeframe.
+   * @param bWide      accumulate in 32 bit samples
+   */
+  void SetWideAccumulation(bool bWide);
+
+  /**
+   * Convert input events to an event archive.
+   *
+   * Events of all input files are decoded and written to a binary archive,
+   * see EventArchive. Archive files with extension ".evarc" can be used
+   * as input files instead of raw data, the data is merged directly from
+   * the mapped archive. The DDL range is applied if set.
+   * @param inputfiles   list of input files
+   * @param filename     name of the archive file
+   * @param maxEvents    maximum number of events, all if negative
+   * @return number of events, negative error code if failed
+   */
+  int ConvertToArchive(std::istream& inputfiles, const char* filename, int maxEvents=-1);
+
+  /**
+   * Estimate pedestal and noise of the channels from black events.
+   *
+   * The bunches of all input events are added to the estimator while
+   * reading, no timeframes are merged. The DDL range is applied if set.
+   * Write the result with PedestalEstimator::Write.
+   * @param inputfiles   list of input files
+   * @param estimator    target of the channel statistics
+   * @param maxEvents    maximum number of events, all if negative
+   * @return number of events, negative error code if failed
+   */
+  int EstimatePedestals(std::istream& inputfiles, PedestalEstimator& estimator, int maxEvents=-1);
+
   /**
    * Set range of padrows to be considered when reading raw data.
    *
@@ -150,6 +402,7 @@ class ChannelMerger {
   void SetPadRowRange(int min, int max) {
     mMinPadRow=min;
     mMaxPadRow=max;
+    UpdateChannelSelection();
   }
 
   void InitZeroSuppression(unsigned int threshold) {mZSThreshold=threshold;}
@@ -196,6 +449,28 @@ class ChannelMerger {
    */
   void InitNoiseManipulation(unsigned factor) {mNoiseFactor = factor; }
 
+  /**
+   * Set the stream for the progress messages, std::cout by default.
+   * Errors are written to std::cerr.
+   */
+  void SetLogStream(std::ostream* stream) {mLog=stream?stream:&std::cout;}
+
+  /**
+   * Set the seed of the random numbers, e.g. for the noise manipulation.
+   * Every DDL uses its own stream of the seed, the result does not depend
+   * on the number of threads and the threads do not share any state.
+   * The default seed is 0.
+   */
+  void SetRandomSeed(unsigned long long seed);
+
+  /**
+   * Seed the random streams of all DDLs for a timeframe.
+   * The random numbers of the timeframe then only depend on seed and frame
+   * number, frames can be generated independently and in any order, see
+   * CollisionTimeline. Frame 0 uses the streams of SetRandomSeed.
+   */
+  void SeedTimeframe(unsigned frameNumber);
+
   /**
    * Get threshold used for zero suppression
    *
@@ -207,7 +482,7 @@ class ChannelMerger {
    * Calculate zero suppression for all channels
    * @param bApply         if true, result of ZS set to signal buffer
    *                       if false, no changes to original buffer
-   * @param bSetOccupancy  if true, calculated occupancy set in map mChannelOccupancy
+   * @param bSetOccupancy  if true, calculated occupancy set in the channel table
    */
   int CalculateZeroSuppression(bool bApply=true, bool bSetOccupancy=true);
 
@@ -223,9 +498,20 @@ class ChannelMerger {
 
   /**
    * Write the time frame data to a text file.
+   * A file name with extension ".tfbin" is written in the binary format
+   * of TimeframeFile.
+   * @return 0 on success, negative error code if failed
    */
   int WriteTimeframe(const char* filename);
 
+  /**
+   * Append the time frame data to a binary timeframe file.
+   * @param writer       open writer
+   * @param frameNumber  number of the frame stored in the file
+   * @return 0 on success, negative error code if failed
+   */
+  int WriteTimeframe(TimeframeWriter& writer, unsigned frameNumber);
+
   /**
    * Evaluate Huffman compression for encoding the difference of signals.
    *
@@ -243,12 +529,40 @@ class ChannelMerger {
    */
   int DoHuffmanCompression(AliHLTHuffman* pHuffman, bool bTrainingMode, TH2& hHuffmanFactor, TH1& hSignalDiff, TTree* huffmanstat=NULL, unsigned symbolCutoffLength=0);
 
+  /**
+   * Huffman encoding of the difference of signals.
+   *
+   * In training mode the symbols of all channels are added to the
+   * training frequencies of the coder, otherwise every channel is encoded
+   * and the channel record is appended to the target buffer, see
+   * HuffmanCoder. Symbols are the signal differences shifted by the
+   * signal range, signals exceeding the range are truncated.
+   * @param coder          Huffman coder
+   * @param bTrainingMode  indicates training mode
+   * @param target         target buffer for the encoded channels
+   * @return number of bytes appended, negative error code if failed
+   */
+  int EncodeTimeframe(HuffmanCoder& coder, bool bTrainingMode, std::vector<unsigned char>& target);
+
   /**
    * Special function to write the channel data in the format currently used
    * as input for the SystemC simulation
+   * A file name with extension ".tfbin" is written in the binary format of
+   * TimeframeFile, which the SAMPA DataGenerator reads with all bunches of
+   * all timebins.
    */
   int WriteSystemcInputFile(const char* filename);
 
+  /// channel groups sharing one common mode signal
+  enum CommonModeGrouping {
+    /// all channels of the timeframe
+    kCommonModeGlobal=0,
+    /// channels of one readout partition, i.e. DDL
+    kCommonModePartition,
+    /// channels of one front-end card
+    kCommonModeFEC
+  };
+
   /**
    * Apply the common mode effect.
    * The effect is an intrinsic feature of the detector readout
@@ -257,10 +571,88 @@ class ChannelMerger {
    * scaled by the number of pads.
    * Its believed that this method is just a rough simplification
    * but should be enough for estimation of data rates.
+   *
+   * The ZS signals are calculated once per channel and kept for the
+   * correction of the channel's own contribution, the sum is accumulated
+   * in 32 bit. The DDLs are processed in parallel if worker threads are
+   * available, see SetNThreads.
    * @param scalingFactor  scaling factor to be applied, number of
-   *                       available channels is used if -1
+   *                       channels in the group is used if -1
+   * @param grouping       channel groups, see CommonModeGrouping
+   * @return 0 on success, negative error code if failed
+   */
+  int ApplyCommonModeEffect(int scalingFactor = -1, int grouping = kCommonModeGlobal);
+
+  /**
+   * Parameters of the fused processing of a timeframe, see ProcessTimeframe.
+   * The optional steps are disabled by default, ZS is calculated if a
+   * threshold is set.
    */
-  int ApplyCommonModeEffect(int scalingFactor = -1);
+  struct ProcessingParameters {
+    ProcessingParameters()
+      : applyZeroSuppression(true)
+      , applyCommonModeEffect(false)
+      , commonModeScalingFactor(-1)
+      , commonModeGrouping(kCommonModeGlobal)
+      , statistics(NULL)
+      , statisticsFileName(NULL)
+      , huffman(NULL)
+      , huffmanTrainingMode(false)
+      , hHuffmanFactor(NULL)
+      , hSignalDiff(NULL)
+      , huffmanStatistics(NULL)
+      , huffmanLengthCutoff(0)
+      , timeframeFileName(NULL)
+      , timeframeWriter(NULL)
+      , timeframeNumber(0)
+    {}
+
+    /// apply ZS to the buffers, otherwise only the occupancy is calculated
+    bool applyZeroSuppression;
+    /// apply the common mode effect, see ApplyCommonModeEffect
+    bool applyCommonModeEffect;
+    /// scaling factor of the common mode effect
+    int commonModeScalingFactor;
+    /// channel groups of the common mode effect, see CommonModeGrouping
+    int commonModeGrouping;
+    /// target tree for the channel statistics, see Analyze
+    TTree* statistics;
+    /// optional text file for the channel statistics, see Analyze
+    const char* statisticsFileName;
+    /// Huffman encoder, see DoHuffmanCompression
+    AliHLTHuffman* huffman;
+    /// Huffman training mode
+    bool huffmanTrainingMode;
+    /// histogram for the Huffman compression factor, required with encoder
+    TH2* hHuffmanFactor;
+    /// histogram for the difference of signals, required with encoder
+    TH1* hSignalDiff;
+    /// optional tree for the Huffman statistics
+    TTree* huffmanStatistics;
+    /// cutoff for the maximum code length
+    unsigned huffmanLengthCutoff;
+    /// text file for the timeframe data, see WriteTimeframe
+    const char* timeframeFileName;
+    /// binary timeframe file the frame is appended to
+    TimeframeWriter* timeframeWriter;
+    /// number of the frame in the binary timeframe file
+    unsigned timeframeNumber;
+  };
+
+  /**
+   * Process the timeframe in one pass per channel.
+   *
+   * The result is identical to the sequence of CalculateZeroSuppression,
+   * ApplyCommonModeEffect, Analyze, DoHuffmanCompression and WriteTimeframe,
+   * but every channel is loaded only once and all steps work on the data
+   * while it is in the cache. The common mode effect depends on the sum of
+   * all channels and requires an additional pass for ZS and summing before
+   * the channels are processed. The channels are processed in the order of
+   * the buffers, unless the timeframe is written which requires the order
+   * of the channel index.
+   * @return 0 on success, negative error code if failed
+   */
+  int ProcessTimeframe(const ProcessingParameters& parameters);
 
   /**
    * Manipulate the noise signal
@@ -268,38 +660,315 @@ class ChannelMerger {
    * and a randomized ADC count in the range of the is factor added.
    * This requires the pedestal to be subtracted,
    * Real signals are not changed by the algorithm
+   * @param signal     noise signal
+   * @param generator  random generator of the DDL
    */
-  unsigned ManipulateNoise(unsigned signal) const;
+  unsigned ManipulateNoise(unsigned signal, RandomGenerator& generator) const;
 
   typedef unsigned short buffer_t;
 
+  /**
+   * @class PadRowIterator
+   * Iteration over the padrows of the added channels.
+   * The padrows are visited in the order of DDL and padrow, the channels of
+   * a padrow are ordered by pad. Channels without mapping are skipped. In
+   * the pad plane layout, the slots of the channels follow the same order.
+   * <pre>
+   * ChannelMerger::PadRowIterator padrow=merger.GetPadRows();
+   * while (padrow.Next()) {
+   *   for (unsigned i=0; i<padrow.GetNChannels(); i++) {
+   *     padrow.GetDenseChannel(i, buffer);
+   *   }
+   * }
+   * </pre>
+   * The iterator is invalidated if channels are added.
+   */
+  class PadRowIterator {
+   public:
+    PadRowIterator();
+
+    /// advance to the next padrow, false if there is no further padrow
+    bool Next();
+
+    /// DDL number of the current padrow
+    unsigned GetDDLNumber() const;
+    /// current padrow
+    int GetPadRow() const;
+    /// number of channels of the current padrow
+    unsigned GetNChannels() const {return mEnd-mBegin;}
+    /// channel index of a channel of the current padrow
+    unsigned GetChannelIndex(unsigned channel) const;
+    /// pad of a channel of the current padrow
+    int GetPad(unsigned channel) const;
+
+    /**
+     * Fill the dense view of a channel of the current padrow.
+     * @return number of allocated blocks
+     */
+    int GetDenseChannel(unsigned channel, buffer_t* target) const;
+
+    /// write back the dense view of a channel of the current padrow
+    int SetDenseChannel(unsigned channel, const buffer_t* source) const;
+
+   private:
+    friend class ChannelMerger;
+    PadRowIterator(ChannelMerger* merger);
+
+    /// merger holding the channels
+    ChannelMerger* mMerger;
+    /// first channel of the current padrow in the pad plane channel list
+    unsigned mBegin;
+    /// end of the current padrow in the pad plane channel list
+    unsigned mEnd;
+  };
+
+  /// iterator over the padrows, positioned before the first padrow
+  PadRowIterator GetPadRows();
+
  protected:
 
  private:
+  /// number of channels per DDL, range of the 12 bit ALTRO HW address
+  static const unsigned kNChannelsPerDDL=0x1000;
+  /// position of channels without slot in the buffers
+  static const unsigned kNoPosition=~0u;
+
+  /**
+   * Entry of the channel table.
+   * All properties of a channel required in the merging and analysis
+   * are kept together, the table is organized in one array per DDL
+   * indexed by the HW address.
+   */
+  struct ChannelInfo {
+    /// channel index composed out of DDL number and HW address
+    unsigned index;
+    /// slot in the sample buffers, kNoPosition if not yet assigned
+    unsigned position;
+    /// baseline to be subtracted
+    unsigned baseline;
+    /// padrow from the channel mapping, -1 if not mapped
+    int padrow;
+    /// pad from the channel mapping, -1 if not mapped
+    int pad;
+    /// number of filled timebins after zero suppression, -1 if not calculated
+    int occupancy;
+    /// channel mapping is available
+    bool mapped;
+    /// channel has been added to the list of channels of the DDL
+    bool added;
+  };
+
+  /**
+   * Channel table and sample buffers of one DDL.
+   */
+  struct DDLData {
+    /// channel table indexed by HW address
+    ChannelInfo channels[kNChannelsPerDDL];
+    /// acceptance of the channels by the padrow range, one bit per HW address
+    unsigned long long acceptance[kNChannelsPerDDL/64];
+    /// number of accepted channels
+    unsigned nAccepted;
+    /// channels added to the buffers, in order of adding
+    std::vector<ChannelInfo*> addedChannels;
+    /// sample buffer of the current timeframe
+    SampleStore* buffer;
+    /// samples shifted into the following timeframes, one buffer per frame
+    std::vector<SampleStore*> underflowBuffers;
+    /// accumulated samples of the current timeframe, NULL if not in wide mode
+    WideSampleStore* wideBuffer;
+    /// accumulated samples shifted into the following timeframes
+    std::vector<WideSampleStore*> wideUnderflowBuffers;
+    /// number of signal overflows in the current timeframe
+    unsigned signalOverflowCount;
+    /// random stream of the DDL
+    RandomGenerator random;
+    /// messages of the merging for the log and the error stream, the DDLs
+    /// are merged concurrently, see FlushMessages
+    std::string messages;
+    std::string errors;
+
+    /// check if a channel is accepted by the padrow range
+    bool IsAccepted(unsigned HWAddress) const {
+      return (acceptance[HWAddress>>6]>>(HWAddress&63))&1;
+    }
+  };
+
+  /**
+   * Get data of a DDL, created if not yet existing.
+   */
+  DDLData& GetDDLData(unsigned DDLNumber);
+
+  /**
+   * Get the channel table entry for a channel index.
+   * The table for the DDL is created if not yet existing.
+   * @return pointer to entry, NULL if HW address out of range
+   */
+  ChannelInfo* GetChannelInfo(unsigned index);
+
+  /**
+   * Get the sample buffer holding a channel.
+   */
+  SampleStore& GetBuffer(const ChannelInfo& channel);
+
+  /**
+   * Get all channels added to the buffers ordered by channel index.
+   */
+  const std::vector<ChannelInfo*>& GetChannels();
+
   /**
-   * Grow both sample and underflow buffer.
+   * Get the mapped channels added to the buffers ordered by DDL, padrow
+   * and pad.
    */
-  int GrowBuffer(unsigned newsize);
+  const std::vector<ChannelInfo*>& GetPadPlaneChannels();
+
+  /**
+   * Get the positions in the list of channels, see GetChannels, in the
+   * order of the buffer slots. The order is DDL by DDL, in the pad plane
+   * layout the padrows of a DDL follow PadRowIterator and the channels
+   * without mapping come last.
+   */
+  void GetBufferOrder(std::vector<unsigned>& order);
+
+  /**
+   * Update the acceptance bitmaps of all DDLs according to padrow range.
+   */
+  void UpdateChannelSelection();
+
+  /**
+   * Update the acceptance bitmap of one DDL.
+   * The bitmap is calculated when the padrow range or the mapping is set,
+   * rejected channels are skipped before reading their bunches.
+   */
+  void UpdateAcceptance(DDLData& ddl);
+
+  /**
+   * Check padrow selection for one channel.
+   */
+  bool IsSelected(const ChannelInfo& channel) const;
 
   /**
    * Add data of a channel to buffer.
    *
    * Sampled data of the channel is shifted by offset towards zero. Underflow
    * is added to the underflow buffer and will be used in the next timeframe.
-   * Every channel is identified by a channel index, new channels are added
-   * to the map of channel positions.
+   * New channels get a position in the buffers assigned in the channel table.
    * @param offset     relative offset of the current collision wrt frame size
-   * @param index      channel index composed out of HW address and sector number
-   * @param stream     input stream to read channel data
+   * @param ddl        data of the DDL the channel belongs to
+   * @param channel    channel table entry
+   * @param source     input source positioned at the channel
    */
-  int AddChannel(float offset, unsigned int index, AliAltroRawStreamV3& stream);
+  int AddChannel(float offset, DDLData& ddl, ChannelInfo& channel, ChannelSource& source);
+
+  /**
+   * Add data of a channel from a decoded event, see DecodedEvent for the
+   * format of the bunch data.
+   */
+  int AddChannel(float offset, DDLData& ddl, ChannelInfo& channel, const unsigned short* data, unsigned size);
+
+  /// assign the position in the buffers for a new channel
+  void AssignSlot(DDLData& ddl, ChannelInfo& channel);
+
+  /// assign the slots of all mapped channels of a DDL in pad plane order
+  void LayoutPadPlane(DDLData& ddl);
+
+  /// ZS threshold of a channel adjusted to baseline and baselineshift
+  unsigned GetChannelThreshold(const ChannelInfo& channel) const;
+
+  /**
+   * Add one bunch of signals to the buffers.
+   * The signals are prepared sample by sample for each range of timebins
+   * within one block of the sample buffer and accumulated by the
+   * vectorized kernel, see SignalAccumulation.
+   * @param ddl        data of the DDL the channel belongs to
+   * @param channel    channel table entry, position must be assigned
+   * @param threshold  ZS threshold of the channel
+   * @param startTime  timebin of the first signal shifted by the collision offset
+   * @param bunchLength number of signals
+   * @param signals    signal array
+   */
+  int AddBunch(DDLData& ddl, const ChannelInfo& channel, unsigned threshold, int startTime, int bunchLength, const unsigned short* signals);
+
+  /**
+   * Merge collisions reading from the current source and the input
+   * files if specified.
+   */
+  int MergeCollisions(const std::vector<float>& collisiontimes, std::istream* inputfiles);
+
+  /// merge collisions into the buffers, see MergeCollisions
+  int MergeEvents(const std::vector<float>& collisiontimes, std::istream* inputfiles);
+
+  /**
+   * Merge the current event, either decoded or from the current source.
+   * @return number of DDLs, negative error code if failed
+   */
+  int MergeEvent(float offset, const DecodedEvent* event);
+
+  /**
+   * Write the messages collected by the merging of the DDLs to the log and
+   * the error stream in the order of the DDLs. Called on the calling
+   * thread after the merging of every event.
+   */
+  void FlushMessages();
+
+  /**
+   * Convert the 32 bit samples of the wide accumulation to the signal buffers.
+   * @param scalingFactor   signals are divided by specified scaling factor
+   */
+  void NarrowAccumulation(unsigned scalingFactor);
+
+  /**
+   * Get decoded data of the current event of the source.
+   * The event is decoded and added to the cache if not yet cached.
+   */
+  const DecodedEvent* GetCurrentEvent();
+
+  /**
+   * Decode all channels of the source into bunch lists.
+   * @param source         positioned source
+   * @param event          target
+   * @param acceptedOnly   decode only channels accepted by the padrow range
+   * @return number of channels
+   */
+  int DecodeEvent(ChannelSource& source, DecodedEvent& event, bool acceptedOnly=false);
+
+  /**
+   * Merge a decoded event, distributed to the worker threads if enabled.
+   * @return number of DDLs
+   */
+  int MergeDecodedEvent(float offset, const DecodedEvent& event);
+
+  /**
+   * Merge the channels of a DDL range from a decoded event.
+   * @return number of merged channels
+   */
+  int MergeDecodedEvent(float offset, const DecodedEvent& event, unsigned minDDL, unsigned maxDDL);
+
+  /**
+   * Add all selected channels of the DDLs in the source.
+   * Only the data of the DDLs read from the source is changed, the method
+   * can be called concurrently for disjoint DDL ranges.
+   * @return number of DDLs
+   */
+  int MergeDDLs(float offset, ChannelSource& source);
+
+  /**
+   * Merge current event of the source using the worker threads.
+   * @return number of DDLs, negative error code if failed
+   */
+  int MergeEventParallel(float offset);
+
+  /// create worker threads and DDL ranges if not existing for current setup
+  int InitWorkers();
+  /// delete worker threads
+  void ReleaseWorkers();
 
   /**
    * Zero suppression for one signal buffer
    *
    * Method does not directly change any members but works on an array of signals.
    * the corrected values can either be applied to the array or not, the occupancy
-   * (number of filled timebins) is returned.
+   * (number of filled timebins) is returned. See ZeroSuppression for the
+   * algorithm and the kernels.
    * @param buffer        pointer to signal buffer
    * @param size          number of signals
    * @param threshold     ZS threshold in ADC counts
@@ -307,35 +976,111 @@ class ChannelMerger {
    * @param target        target buffer for ZS corrected value, optional, can be equal
    *                      to original signal buffer
    */
-  int SignalBufferZeroSuppression(buffer_t* buffer, unsigned size, unsigned threshold, int baselineshift, buffer_t* target=NULL) const;
+  int SignalBufferZeroSuppression(const buffer_t* buffer, unsigned size, unsigned threshold, int baselineshift, buffer_t* target=NULL) const;
+
+  /**
+   * Add the ZS signals of a channel to the common mode signal.
+   * @param signalBuffer  signals of the channel
+   * @param cmSignal      common mode signal
+   * @param zsSignal      buffer to receive the ZS signals of the channel
+   * @return number of filled timebins, negative error code if failed
+   */
+  int AddCommonModeSignal(const buffer_t* signalBuffer, unsigned* cmSignal, buffer_t* zsSignal) const;
+
+  /**
+   * Subtract the common mode signal of all other channels from a channel.
+   * The scaled common mode signal is subtracted from all timebins, the
+   * timebins with ZS signal of the channel itself are corrected to the
+   * scaled sum without the own contribution.
+   * @param signalBuffer  signals of the channel
+   * @param cmSignal      common mode signal of the group of the channel
+   * @param cmScaled      common mode signal divided by the scaling factor
+   * @param scalingFactor scaling factor
+   * @param nZS           number of timebins with ZS signal
+   * @param zsTime        timebins with ZS signal
+   * @param zsValue       ZS signals of the timebins
+   * @return number of timebins with underflow
+   */
+  int SubtractCommonModeSignal(buffer_t* signalBuffer, const unsigned* cmSignal, const unsigned* cmScaled, unsigned scalingFactor,
+			       unsigned nZS, const unsigned* zsTime, const buffer_t* zsValue) const;
+
+  /**
+   * Assign the channels to the groups of the common mode effect.
+   * @param grouping      see CommonModeGrouping
+   * @param channelGroup  target to receive the group of every channel of GetChannels
+   * @param groupSize     target to receive the number of channels of every group
+   * @return number of groups, negative error code if failed
+   */
+  int AssignCommonModeGroups(int grouping, std::vector<unsigned>& channelGroup, std::vector<unsigned>& groupSize);
+
+  /**
+   * Write the bunches of one channel in the format of WriteTimeframe.
+   * The arrays bunchLength and bunchTime are used as scratch space and
+   * must hold one entry per timebin.
+   */
+  void WriteChannel(std::ostream& output, const ChannelInfo& channel, const buffer_t* channelData,
+		    unsigned* bunchLength, unsigned* bunchTime) const;
+
+  /// variables of the statistics tree and state of the analysis, see Analyze
+  struct AnalysisContext;
+  /// variables of the Huffman statistics tree, see DoHuffmanCompression
+  struct HuffmanContext;
+
+  /// set up branches, statistics file and histograms of a timeframe
+  void InitAnalysis(AnalysisContext& context, TTree& target, const char* statfilename);
+  /// analyze one channel
+  void AnalyzeChannel(AnalysisContext& context, const ChannelInfo& channel, const buffer_t* channelData, TTree& target);
+  /// close the analysis of a timeframe
+  void FinishAnalysis(AnalysisContext& context);
+
+  /// set up branches of the Huffman statistics tree and the code length table
+  void InitHuffmanCompression(HuffmanContext& context, AliHLTHuffman* pHuffman, bool bTrainingMode, TTree* huffmanstat, unsigned symbolCutoffLength);
+  /// evaluate the Huffman compression of one channel
+  void HuffmanCompressChannel(HuffmanContext& context, const ChannelInfo& channel, const buffer_t* channelData,
+			      AliHLTHuffman* pHuffman, bool bTrainingMode, TH2& hHuffmanFactor, TH1& hSignalDiff,
+			      TTree* huffmanstat);
 
   /*
-   * Init the input stream for reading of events from next file
+   * Init the input source for reading of events from next file
    */
   int InitNextInputFile(std::istream& inputfiles);
 
+  /// delete the current source if owned
+  void ReleaseSource();
+
+  /// seed of the random streams of the current frame
+  unsigned long long GetFrameSeed() const;
+
   /// backward compatibility
   int InitNextInput(std::istream& inputfiles) {
     return InitNextInputFile(inputfiles);
   }
 
   unsigned mChannelLenght;
-  unsigned mInitialBufferSize;
-  unsigned mBufferSize;
-  buffer_t* mBuffer;
-  buffer_t* mUnderflowBuffer;
-  std::map<unsigned int, unsigned int> mChannelPositions;
-  std::map<unsigned int, unsigned int> mChannelBaseline;
-  std::map<unsigned int, unsigned int> mChannelMappingPadrow;
-  std::map<unsigned int, unsigned int> mChannelMappingPad;
-  std::map<unsigned int, int> mChannelOccupancy;
+  /// channel processing functions for the channel length
+  const ChannelKernels* mKernels;
+  /// number of timebins of the input events, 0 for the channel length
+  unsigned mDriftLength;
+  /// channel table and buffers, indexed by DDL number
+  std::vector<DDLData*> mDDLs;
+  /// channels added to the buffers ordered by channel index
+  std::vector<ChannelInfo*> mChannels;
+  /// layout of the channel slots, see ChannelLayout
+  int mChannelLayout;
+  /// mapped channels ordered by DDL, padrow and pad, see PadRowIterator
+  std::vector<ChannelInfo*> mPadPlaneChannels;
+  /// number of added channels when the pad plane list was created
+  unsigned mPadPlaneChannelsBase;
+  /// number of channels with mapping information
+  unsigned mNMappedChannels;
   unsigned int mZSThreshold;
   int mBaselineshift;
-  unsigned int mSignalOverflowCount;
-  /// general interface to data
-  AliRawReader* mRawReader;
-  /// interface to TPC data
-  AliAltroRawStreamV3* mInputStream;
+  /// current input source
+  ChannelSource* mSource;
+  /// source created from the input file list and owned by the merger
+  bool mOwnSource;
+  /// counter of input sources, the worker clones are renewed on change
+  unsigned mSourceGeneration;
   /// min DDL number
   int mInputStreamMinDDL;
   /// max DDL number
@@ -343,7 +1088,36 @@ class ChannelMerger {
   int mMinPadRow;
   int mMaxPadRow;
   unsigned mNoiseFactor;
+  /// seed of the random streams of the DDLs
+  unsigned long long mRandomSeed;
+  /// frame the random streams are seeded for, see SeedTimeframe
+  unsigned mRandomFrame;
+  /// timeline input of the current source, -1 if not opened from a timeline
+  int mTimelineInput;
+  /// stream for progress messages
+  std::ostream* mLog;
+  /// number of threads for merging
+  unsigned mNThreads;
+  /// threads for merging
+  ThreadPool* mThreadPool;
+  /// input cursors of the merging threads
+  std::vector<ChannelMergerWorker*> mWorkers;
+  /// cache of decoded events
+  EventCache* mEventCache;
+  /// number of events for replay from the cache
+  unsigned mEventPoolSize;
+  /// background opening of the input files
+  InputPrefetcher* mInputPrefetcher;
+  /// number of input files opened in advance
+  unsigned mInputPrefetchDepth;
+  /// read the first event of prefetched input files
+  bool mInputReadAhead;
+  /// accumulation in 32 bit samples
+  bool mWideAccumulation;
 
+  /// channel histograms, created by Analyze
   TFolder* mChannelHistograms;
+  /// function writing and deleting the histograms, set by Analyze
+  void (*mReleaseChannelHistograms)(TFolder*);
 };
 #endif
@@ -0,0 +1,608 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ChannelMergerAnalysis.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Analysis functionality of the ChannelMerger depending on ROOT
+//          and AliRoot, the merging itself is independent of them
+
+#include "ChannelMerger.h"
+#include "SampleStore.h"
+#include "CodeLengthTable.h"
+#include "ChannelMergerT.h"
+#include "TimeframeFile.h"
+#include "AliHLTHuffman.h"
+#include "TString.h"
+#include "TTree.h"
+#include "TFolder.h"
+#include "TH1F.h"
+#include "TH2F.h"
+#include <iomanip>
+#include <assert.h>
+#include <fstream>
+#include <vector>
+#include <cerrno>
+
+const ChannelMerger::buffer_t VOID_SIGNAL=~(ChannelMerger::buffer_t)(0);
+
+namespace {
+  void ReleaseChannelHistograms(TFolder* folder)
+  {
+    folder->SaveAs("ChannelHistograms.root");
+    delete folder;
+  }
+}
+
+struct ChannelMerger::AnalysisContext {
+  AnalysisContext(unsigned channelLength)
+    : DDLNumber(0)
+    , HWAddr(0)
+    , PadRow(0)
+    , Pad(0)
+    , MinSignal(0)
+    , MaxSignal(0)
+    , AvrgSignal(0)
+    , MinSignalDiff(0)
+    , MaxSignalDiff(0)
+    , MinTimebin(0)
+    , MaxTimebin(0)
+    , NFilledTimebins(0)
+    , NBunches(0)
+    , BunchLength(channelLength, 0)
+    , statfile(NULL)
+    , currentFolder(NULL)
+    , nChannelHistograms(0)
+  {}
+
+  // tree setup
+  int DDLNumber;
+  int HWAddr;
+  int PadRow;
+  int Pad;
+  int MinSignal;
+  int MaxSignal;
+  int AvrgSignal;
+  int MinSignalDiff;
+  int MaxSignalDiff;
+  int MinTimebin;
+  int MaxTimebin;
+  int NFilledTimebins;
+  int NBunches;
+  // strangely enough, TTree::SetBranchAddress requires the
+  // array to be 'unsigned int' although the branch was created with
+  // in array.
+  std::vector<unsigned int> BunchLength;
+
+  /// optional statistics file
+  std::ofstream* statfile;
+  /// histogram folder of the current timeframe
+  TFolder* currentFolder;
+  /// number of channel histograms in the current timeframe
+  int nChannelHistograms;
+};
+
+struct ChannelMerger::HuffmanContext {
+  HuffmanContext(unsigned channelLength)
+    : DDLNumber(-1)
+    , HWAddr(-1)
+    , PadRow(-2)
+    , NFilledTimebins(-1)
+    , HuffmanFactor(1.)
+    , codeLengths(NULL)
+    , symbols(channelLength, 0)
+    , signalDiffs(channelLength, 0.)
+  {}
+  ~HuffmanContext() {
+    if (codeLengths) delete codeLengths;
+  }
+
+  // tree setup
+  int DDLNumber;
+  int HWAddr;
+  int PadRow;
+  int NFilledTimebins;
+  Float_t HuffmanFactor;
+
+  /// code lengths of the Huffman table, not used in training mode
+  CodeLengthTable* codeLengths;
+  /// symbols of the current channel
+  std::vector<buffer_t> symbols;
+  /// signal differences of the current channel for the histogram
+  std::vector<double> signalDiffs;
+
+private:
+  /// copy constructor prohibited
+  HuffmanContext(const HuffmanContext&);
+  /// assignment operator prohibited
+  HuffmanContext& operator=(const HuffmanContext&);
+};
+
+namespace {
+  // TODO: make this a property of the merger/data
+  const unsigned signalRange=1024;
+  const unsigned signalBitLength=10;
+}
+
+namespace {
+  // TODO: make better condition
+  const int maxNTimeframes=10; // max number of timeframes with stored histograms
+  const int maxNChannelHistograms=1000; // max number of channel histograms written per timeframe
+  // number of analyzed timeframes
+  int timeframeNo=0;
+}
+
+int ChannelMerger::Analyze(TTree& target, const char* statfilename)
+{
+  AnalysisContext context(mChannelLenght);
+  InitAnalysis(context, target, statfilename);
+
+  // dense view of the current channel
+  std::vector<buffer_t> channelData(mChannelLenght);
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  // the channels are analyzed in the order of the buffers
+  std::vector<unsigned> order;
+  GetBufferOrder(order);
+  for (std::vector<unsigned>::const_iterator c=order.begin();
+       c!=order.end(); c++) {
+    GetBuffer(*channels[*c]).GetDenseChannel(channels[*c]->position, &channelData[0]);
+    AnalyzeChannel(context, *channels[*c], &channelData[0], target);
+  }
+
+  FinishAnalysis(context);
+  return 0;
+}
+
+void ChannelMerger::InitAnalysis(AnalysisContext& context, TTree& target, const char* statfilename)
+{
+  if (target.GetBranch("DDLNumber") != NULL) {
+    target.SetBranchAddress("DDLNumber", &context.DDLNumber);
+  }
+
+  if (target.GetBranch("HWAddr") != NULL) {
+    target.SetBranchAddress("HWAddr", &context.HWAddr);
+  }
+
+  if (target.GetBranch("PadRow") != NULL) {
+    target.SetBranchAddress("PadRow", &context.PadRow);
+  }
+
+  if (target.GetBranch("MinSignal") != NULL) {
+    target.SetBranchAddress("MinSignal", &context.MinSignal);
+  }
+
+  if (target.GetBranch("MaxSignal") != NULL) {
+    target.SetBranchAddress("MaxSignal", &context.MaxSignal);
+  }
+
+  if (target.GetBranch("AvrgSignal") != NULL) {
+    target.SetBranchAddress("AvrgSignal", &context.AvrgSignal);
+  }
+
+  if (target.GetBranch("MinSignalDiff") != NULL) {
+    target.SetBranchAddress("MinSignalDiff", &context.MinSignalDiff);
+  }
+
+  if (target.GetBranch("MaxSignalDiff") != NULL) {
+    target.SetBranchAddress("MaxSignalDiff", &context.MaxSignalDiff);
+  }
+
+  if (target.GetBranch("MinTimebin") != NULL) {
+    target.SetBranchAddress("MinTimebin", &context.MinTimebin);
+  }
+
+  if (target.GetBranch("MaxTimebin") != NULL) {
+    target.SetBranchAddress("MaxTimebin", &context.MaxTimebin);
+  }
+
+  if (target.GetBranch("NFilledTimebins") != NULL) {
+    target.SetBranchAddress("NFilledTimebins", &context.NFilledTimebins);
+  }
+
+  if (target.GetBranch("NBunches") != NULL) {
+    target.SetBranchAddress("NBunches", &context.NBunches);
+  }
+
+  if (target.GetBranch("BunchLength") != NULL) {
+    target.SetBranchAddress("BunchLength", &context.BunchLength[0]);
+  }
+
+  // statistics file setup
+  if (statfilename) {
+    context.statfile = new std::ofstream(statfilename);
+    if (context.statfile!=NULL && !context.statfile->good()) {
+      delete context.statfile;
+      context.statfile=NULL;
+    }
+  }
+
+  if (mChannelHistograms==NULL) {
+    // the folder is written and released by the destructor
+    mChannelHistograms=new TFolder("ChannelHistograms", "ChannelHistograms");
+    mChannelHistograms->IsOwner();
+    mReleaseChannelHistograms=ReleaseChannelHistograms;
+  }
+  if (mChannelHistograms &&
+      timeframeNo < maxNTimeframes) {
+    TString name;
+    name.Form("timeframe_%03d", timeframeNo);
+    context.currentFolder = new TFolder(name, name);
+    mChannelHistograms->Add(context.currentFolder);
+  }
+}
+
+void ChannelMerger::AnalyzeChannel(AnalysisContext& context, const ChannelInfo& channel, const buffer_t* channelData, TTree& target)
+{
+  unsigned index=channel.index;
+  context.DDLNumber=(index&0xffff0000)>>16;
+  context.HWAddr=index&0x0000ffff;
+  if (channel.mapped) {
+    context.PadRow=channel.padrow;
+    context.Pad=channel.pad;
+  } else {
+    context.PadRow=-1;
+    context.Pad=-1;
+  }
+  TH1* hChannel=NULL;
+  if (context.currentFolder!=NULL &&
+      context.nChannelHistograms<maxNChannelHistograms &&
+      context.PadRow>=0) {
+    TString name;
+    name.Form("TF_%03d_DDL_%d_HWAddr_%d_PadRow_%d_Pad_%d", timeframeNo, context.DDLNumber, context.HWAddr, context.PadRow, context.Pad);
+    hChannel=new TH1F(name, name, mChannelLenght, 0., mChannelLenght);
+    context.currentFolder->Add(hChannel);
+    context.nChannelHistograms++;
+  }
+  ChannelSignalStatistics statistics;
+  mKernels->CalculateStatistics(channelData, mChannelLenght, statistics, &context.BunchLength[0]);
+  if (hChannel) {
+    for (unsigned i=0; i<mChannelLenght; i++) {
+      if (channelData[i] == VOID_SIGNAL) continue;
+      hChannel->Fill(i, channelData[i]);
+    }
+  }
+  // the kernel works on local variables, the tree variables are set once
+  context.MinSignal=statistics.MinSignal;
+  context.MaxSignal=statistics.MaxSignal;
+  context.MinSignalDiff=statistics.MinSignalDiff;
+  context.MaxSignalDiff=statistics.MaxSignalDiff;
+  context.AvrgSignal=statistics.AvrgSignal;
+  context.MinTimebin=statistics.MinTimebin;
+  context.MaxTimebin=statistics.MaxTimebin;
+  context.NFilledTimebins=statistics.NFilledTimebins;
+  context.NBunches=statistics.NBunches;
+  target.Fill();
+  if (context.statfile) {
+    (*context.statfile) << std::setw(3) << context.DDLNumber
+			<< std::setw(6) << context.HWAddr
+			<< std::setw(6) << statistics.AvrgSignal
+			<< std::setw(6) << statistics.MinSignal
+			<< std::setw(6) << statistics.MaxSignal
+			<< std::setw(6) << statistics.NFilledTimebins
+			<< std::setw(6) << statistics.NBunches
+			<< std::endl;
+  }
+}
+
+void ChannelMerger::FinishAnalysis(AnalysisContext& context)
+{
+  timeframeNo++;
+
+  if (context.statfile) {
+    context.statfile->close();
+    delete context.statfile;
+    context.statfile = NULL;
+  }
+}
+
+int ChannelMerger::DoHuffmanCompression(AliHLTHuffman* pHuffman, bool bTrainingMode, TH2& hHuffmanFactor, TH1& hSignalDiff, TTree* huffmanstat, unsigned symbolCutoffLength)
+{
+  // TODO: very quick solution to estimate potentisl of huffman compressions
+  // to be implemented in a more modular fashion
+  HuffmanContext context(mChannelLenght);
+  InitHuffmanCompression(context, pHuffman, bTrainingMode, huffmanstat, symbolCutoffLength);
+
+  std::vector<buffer_t> channelData(mChannelLenght);
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  for (std::vector<ChannelInfo*>::const_iterator chit=channels.begin();
+       chit!=channels.end(); chit++) {
+    GetBuffer(**chit).GetDenseChannel((*chit)->position, &channelData[0]);
+    HuffmanCompressChannel(context, **chit, &channelData[0], pHuffman, bTrainingMode, hHuffmanFactor, hSignalDiff, huffmanstat);
+  }
+
+  return 0;
+}
+
+void ChannelMerger::InitHuffmanCompression(HuffmanContext& context, AliHLTHuffman* pHuffman, bool bTrainingMode, TTree* huffmanstat, unsigned symbolCutoffLength)
+{
+  if (huffmanstat) {
+    if (huffmanstat->GetBranch("DDLNumber") != NULL) {
+      huffmanstat->SetBranchAddress("DDLNumber", &context.DDLNumber);
+    }
+
+    if (huffmanstat->GetBranch("HWAddr") != NULL) {
+      huffmanstat->SetBranchAddress("HWAddr", &context.HWAddr);
+    }
+
+    if (huffmanstat->GetBranch("PadRow") != NULL) {
+      huffmanstat->SetBranchAddress("PadRow", &context.PadRow);
+    }
+
+    if (huffmanstat->GetBranch("NFilledTimebins") != NULL) {
+      huffmanstat->SetBranchAddress("NFilledTimebins", &context.NFilledTimebins);
+    }
+
+    if (huffmanstat->GetBranch("HuffmanFactor") != NULL) {
+      huffmanstat->SetBranchAddress("HuffmanFactor", &context.HuffmanFactor);
+    }
+  }
+
+  if (!bTrainingMode && pHuffman) {
+    // the code length of every symbol is extracted once, the bit count of
+    // a channel is a sum of table lookups instead of encoding every signal
+    context.codeLengths=new CodeLengthTable(2*signalRange, symbolCutoffLength, signalBitLength);
+    for (unsigned symbol=0; symbol<2*signalRange; symbol++) {
+      AliHLTUInt64_t length = 0;
+      pHuffman->Encode(symbol, length);
+      if (context.codeLengths->SetCodeLength(symbol, length)<0) {
+	std::cout << "code length " << length << " of symbol " << symbol << " out of range" << std::endl;
+      }
+    }
+  }
+}
+
+void ChannelMerger::HuffmanCompressChannel(HuffmanContext& context, const ChannelInfo& channel, const buffer_t* channelData,
+					   AliHLTHuffman* pHuffman, bool bTrainingMode, TH2& hHuffmanFactor, TH1& hSignalDiff,
+					   TTree* huffmanstat)
+{
+  unsigned index=channel.index;
+  context.DDLNumber=(index&0xffff0000)>>16;
+  context.HWAddr=index&0x0000ffff;
+  if (channel.mapped) {
+    context.PadRow=channel.padrow;
+  } else {
+    context.PadRow=-1;
+  }
+  context.NFilledTimebins = channel.occupancy;
+
+  context.HuffmanFactor=0.;
+
+  // symbols are the signal differences shifted by the signal range, signals
+  // exceeding the range are truncated
+  // TODO: handling of signal exceeding the range needs to be defined.
+  // this should be handled in the pile up algorithm
+  buffer_t* symbols=&context.symbols[0];
+  CodeLengthTable::DeltaSymbols(channelData, mChannelLenght, signalRange, symbols);
+  for (unsigned i=0; i<mChannelLenght; i++) {
+    context.signalDiffs[i]=(int)symbols[i]-(int)signalRange;
+  }
+  hSignalDiff.FillN(mChannelLenght, &context.signalDiffs[0], NULL);
+
+  unsigned bitcount=0;
+  if (bTrainingMode) {
+    for (unsigned i=0; i<mChannelLenght; i++) {
+      pHuffman->AddTrainingValue(symbols[i]);
+    }
+  } else if (context.codeLengths) {
+    bitcount=context.codeLengths->BitCount(symbols, mChannelLenght);
+  }
+  if (!bTrainingMode && bitcount>0) {
+    bitcount+=(40-bitcount%40); // align to 40 bit altro format
+    context.HuffmanFactor=mChannelLenght*signalBitLength;
+    context.HuffmanFactor/=bitcount;
+    if (huffmanstat) {
+      huffmanstat->Fill();
+    }
+    hHuffmanFactor.Fill(context.PadRow, context.HuffmanFactor);
+    if (context.HuffmanFactor<1.) {
+      std::cout << "HuffmanFactor smaller than 1: " << context.HuffmanFactor << " bitcount " << bitcount << std::endl;
+    }
+    //assert(HuffmanFactor>=1.);
+  }
+}
+
+int ChannelMerger::ProcessTimeframe(const ProcessingParameters& parameters)
+{
+  if (parameters.huffman && (parameters.hHuffmanFactor==NULL || parameters.hSignalDiff==NULL)) {
+    return -EINVAL;
+  }
+
+  // binary output to the writer of the parameters or to a file of its own
+  TimeframeWriter* writer=parameters.timeframeWriter;
+  TimeframeWriter fileWriter;
+  if (writer==NULL && TimeframeFile::IsTimeframeFile(parameters.timeframeFileName)) {
+    if (fileWriter.Open(parameters.timeframeFileName, mChannelLenght)<0) {
+      std::cerr << "can not open file '" << parameters.timeframeFileName << "' for writing timeframe data" << std::endl;
+      return -1;
+    }
+    writer=&fileWriter;
+  }
+  if (writer && writer->StartFrame(parameters.timeframeNumber)<0) return -EBADF;
+
+  std::ofstream* output=NULL;
+  if (parameters.timeframeFileName && writer==NULL) {
+    output=new std::ofstream(parameters.timeframeFileName);
+    if (!output->good()) {
+      std::cerr << "can not open file '" << parameters.timeframeFileName << "' for writing timeframe data" << std::endl;
+      delete output;
+      return -1;
+    }
+  }
+
+  unsigned threshold=GetThreshold();
+  // ZS is skipped without threshold, see CalculateZeroSuppression
+  bool bZeroSuppression=threshold!=VOID_SIGNAL;
+  // dense view of the current channel
+  std::vector<buffer_t> channelData(mChannelLenght);
+  buffer_t* signalBuffer=&channelData[0];
+  // temporary buffer for calculation of ZS for one channel
+  std::vector<buffer_t> zsSignal(mChannelLenght, 0);
+  // sum of ZS signals of the channels of every common mode group
+  std::vector<unsigned> cmSignal;
+  std::vector<unsigned> cmScaled;
+  std::vector<unsigned> channelGroup;
+  std::vector<unsigned> groupSize;
+  // cached ZS timebins and signals of all channels
+  std::vector<unsigned> zsTime;
+  std::vector<buffer_t> zsValue;
+  // start and number of the cached ZS signals of every channel
+  std::vector<unsigned> zsOffset;
+  std::vector<unsigned> zsLength;
+  // bunches of the current channel for the ASCII output
+  std::vector<unsigned> bunchLength(output?mChannelLenght:0);
+  std::vector<unsigned> bunchTime(output?mChannelLenght:0);
+  const std::vector<ChannelInfo*>& channels=GetChannels();
+  // the channels are processed in the order of the buffers, the timeframe
+  // output is written in the order of the channel index
+  std::vector<unsigned> order;
+  GetBufferOrder(order);
+  std::vector<unsigned> outputOrder;
+  if (output || writer) {
+    for (unsigned c=0; c<channels.size(); c++) outputOrder.push_back(c);
+  }
+  const std::vector<unsigned>& processingOrder=(output || writer)?outputOrder:order;
+
+  if (parameters.applyCommonModeEffect) {
+    // the common mode signal is the sum of all channels after ZS, the
+    // channels are zero suppressed and summed in a separate pass
+    int nGroups=AssignCommonModeGroups(parameters.commonModeGrouping, channelGroup, groupSize);
+    if (nGroups < 0 || parameters.commonModeScalingFactor==0) {
+      if (output) delete output;
+      return nGroups<0?nGroups:-EINVAL;
+    }
+    cmSignal.resize(nGroups*mChannelLenght, 0);
+    cmScaled.resize(nGroups*mChannelLenght, 0);
+    zsOffset.resize(channels.size(), 0);
+    zsLength.resize(channels.size(), 0);
+    for (std::vector<unsigned>::const_iterator k=order.begin(); k!=order.end(); k++) {
+      unsigned c=*k;
+      ChannelInfo& channel=*channels[c];
+      GetBuffer(channel).GetDenseChannel(channel.position, signalBuffer);
+      if (bZeroSuppression) {
+	int result=SignalBufferZeroSuppression(signalBuffer, mChannelLenght, threshold, mBaselineshift, parameters.applyZeroSuppression?signalBuffer:NULL);
+	if (result>=0 && parameters.applyZeroSuppression) {
+	  GetBuffer(channel).SetDenseChannel(channel.position, signalBuffer);
+	}
+	if (result>=0) {
+	  channel.occupancy = result;
+	}
+      }
+      int result=AddCommonModeSignal(signalBuffer, &cmSignal[channelGroup[c]*mChannelLenght], &zsSignal[0]);
+      if (result < 0) {
+	if (output) delete output;
+	return result;
+      }
+      // the buffer is not changed until the subtraction, the ZS signals
+      // are cached for the correction of the own contribution
+      zsOffset[c]=zsTime.size();
+      for (unsigned i=0; i<mChannelLenght; i++) {
+	if (zsSignal[i]==VOID_SIGNAL) continue;
+	zsTime.push_back(i);
+	zsValue.push_back(zsSignal[i]);
+      }
+      zsLength[c]=zsTime.size()-zsOffset[c];
+    }
+    for (int g=0; g<nGroups; g++) {
+      unsigned scaling=parameters.commonModeScalingFactor<0?groupSize[g]:parameters.commonModeScalingFactor;
+      for (unsigned i=0; i<mChannelLenght; i++) {
+	cmScaled[g*mChannelLenght+i]=cmSignal[g*mChannelLenght+i]/scaling;
+      }
+    }
+  }
+  int scalingFactor=parameters.commonModeScalingFactor;
+  if (scalingFactor<0) scalingFactor=channels.size();
+
+  AnalysisContext analysis(mChannelLenght);
+  if (parameters.statistics) {
+    InitAnalysis(analysis, *parameters.statistics, parameters.statisticsFileName);
+  }
+  HuffmanContext huffman(mChannelLenght);
+  if (parameters.huffman) {
+    InitHuffmanCompression(huffman, parameters.huffman, parameters.huffmanTrainingMode, parameters.huffmanStatistics,
+			   parameters.huffmanLengthCutoff);
+  }
+
+  unsigned nUnderflow=0;
+  unsigned nUnderflowChannels=0;
+  unsigned nChannels=0;
+  for (std::vector<unsigned>::const_iterator k=processingOrder.begin();
+       k!=processingOrder.end(); k++, nChannels++) {
+    unsigned c=*k;
+    ChannelInfo& channel=*channels[c];
+    GetBuffer(channel).GetDenseChannel(channel.position, signalBuffer);
+    if (parameters.applyCommonModeEffect) {
+      unsigned group=channelGroup[c];
+      unsigned scaling=parameters.commonModeScalingFactor<0?groupSize[group]:parameters.commonModeScalingFactor;
+      unsigned offset=zsOffset[c];
+      unsigned nZS=zsLength[c];
+      int result=SubtractCommonModeSignal(signalBuffer, &cmSignal[group*mChannelLenght], &cmScaled[group*mChannelLenght], scaling,
+					  nZS, nZS>0?&zsTime[offset]:NULL, nZS>0?&zsValue[offset]:NULL);
+      nUnderflow+=result;
+      if (result>0) nUnderflowChannels++;
+      GetBuffer(channel).SetDenseChannel(channel.position, signalBuffer);
+    } else if (bZeroSuppression) {
+      int result=SignalBufferZeroSuppression(signalBuffer, mChannelLenght, threshold, mBaselineshift, parameters.applyZeroSuppression?signalBuffer:NULL);
+      if (result>=0 && parameters.applyZeroSuppression) {
+	GetBuffer(channel).SetDenseChannel(channel.position, signalBuffer);
+      }
+      if (result>=0) {
+	channel.occupancy = result;
+      }
+    }
+
+    if (parameters.statistics) {
+      AnalyzeChannel(analysis, channel, signalBuffer, *parameters.statistics);
+    }
+    if (parameters.huffman) {
+      HuffmanCompressChannel(huffman, channel, signalBuffer, parameters.huffman, parameters.huffmanTrainingMode,
+			     *parameters.hHuffmanFactor, *parameters.hSignalDiff, parameters.huffmanStatistics);
+    }
+    if (output) {
+      if (nChannels>0) (*output) << std::endl;
+      WriteChannel(*output, channel, signalBuffer, &bunchLength[0], &bunchTime[0]);
+    }
+    if (writer) {
+      writer->AddDenseChannel(channel.index, signalBuffer, mChannelLenght, VOID_SIGNAL);
+    }
+  }
+  if (parameters.applyCommonModeEffect) {
+    (*mLog) << "ApplyCommonModeEffect: ";
+    if (parameters.commonModeGrouping!=kCommonModeGlobal) (*mLog) << groupSize.size() << " group(s), ";
+    if (parameters.commonModeScalingFactor<0 && parameters.commonModeGrouping!=kCommonModeGlobal) (*mLog) << "scaling by group size";
+    else (*mLog) << "scaling " << scalingFactor;
+    (*mLog) << "; " << nUnderflow << " underflow(s) in " << nUnderflowChannels << " channel(s)" << std::endl;
+  }
+
+  if (parameters.statistics) {
+    FinishAnalysis(analysis);
+  }
+  if (output) {
+    output->close();
+    delete output;
+  }
+  if (writer) {
+    int result=writer->FinishFrame();
+    if (result>=0 && writer==&fileWriter) result=fileWriter.Close();
+    if (result<0) return result;
+  }
+  return 0;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  // this function can be used to check whether the ChannelMerger is part
+  // of the Generator library
+  bool __IsChannelMergerIncludedInLibrary() {return true;}
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,34 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ChannelMergerT.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Channel processing specialized on channel length
+
+#include "ChannelMergerT.h"
+
+template<unsigned Length>
+const typename ChannelMergerT<Length>::sample_t ChannelMergerT<Length>::kVoidSample;
+
+template class ChannelMergerT<1024>;
+template class ChannelMergerT<1021>;
+template class ChannelMergerT<0>;
+
+const ChannelKernels& SelectChannelKernels(unsigned length)
+{
+  switch (length) {
+  case 1024: return ChannelMergerT<1024>::GetKernels();
+  case 1021: return ChannelMergerT<1021>::GetKernels();
+  }
+  return ChannelMergerT<0>::GetKernels();
+}
@@ -0,0 +1,238 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ChannelMergerT.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Channel processing specialized on channel length
+
+#ifndef CHANNELMERGERT_H
+#define CHANNELMERGERT_H
+
+/**
+ * @struct ChannelSignalStatistics
+ * Signal statistics of one channel as filled in the analysis tree.
+ */
+struct ChannelSignalStatistics {
+  int MinSignal;
+  int MaxSignal;
+  int MinSignalDiff;
+  int MaxSignalDiff;
+  int AvrgSignal;
+  int MinTimebin;
+  int MaxTimebin;
+  int NFilledTimebins;
+  int NBunches;
+};
+
+/**
+ * @struct ChannelKernels
+ * Processing functions for the dense view of a channel.
+ *
+ * The ChannelMerger selects the functions once for its channel length, see
+ * SelectChannelKernels, and calls them through the table for every
+ * channel.
+ */
+struct ChannelKernels {
+  typedef unsigned short sample_t;
+
+  /// number of timebins the kernels are specialized for, 0 for any length
+  unsigned length;
+
+  /**
+   * Find the bunches of a channel, starting at the highest timebin.
+   * @param data          channel samples
+   * @param size          number of timebins
+   * @param bunchLength   target for the bunch lengths, size timebins
+   * @param bunchTime     target for the start timebins, size timebins
+   * @return number of bunches
+   */
+  unsigned (*FindBunches)(const sample_t* data, unsigned size, unsigned* bunchLength, unsigned* bunchTime);
+
+  /**
+   * Signal statistics of a channel.
+   * @param data          channel samples
+   * @param size          number of timebins
+   * @param statistics    target
+   * @param bunchLength   target for the bunch lengths, size timebins
+   */
+  void (*CalculateStatistics)(const sample_t* data, unsigned size, ChannelSignalStatistics& statistics, unsigned* bunchLength);
+
+  /// add zero suppressed signals of a channel to the wide common mode signal
+  void (*AddCommonMode)(const sample_t* zsSignal, unsigned size, unsigned* cmSignal);
+
+  /**
+   * Subtract the scaled common mode signal, signals saturate at 0.
+   * The contribution of the channel itself is corrected by the caller for
+   * the timebins with zero suppressed signal.
+   * @return number of timebins with underflow
+   */
+  int (*SubtractCommonMode)(sample_t* signal, unsigned size, const unsigned* cmScaled);
+};
+
+/**
+ * @class ChannelMergerT
+ * Core of the channel processing with compile time channel length.
+ *
+ * The loops over the timebins of a channel have a constant trip count for
+ * Length>0 and can be unrolled and vectorized by the compiler. The kernels
+ * are instantiated for the common channel lengths, Length=0 processes any
+ * length given at runtime, e.g. the longer frames of continuous readout.
+ * All instantiations give identical results.
+ *
+ * Only the .cxx files of the merger include this header.
+ */
+template<unsigned Length>
+class ChannelMergerT {
+ public:
+  typedef ChannelKernels::sample_t sample_t;
+
+  /// value of timebins without signal
+  static const sample_t kVoidSample=(sample_t)(~0u);
+
+  /// number of timebins, the compile time length if specified
+  static unsigned Size(unsigned size) {return Length>0?Length:size;}
+
+  /// see ChannelKernels::FindBunches
+  static unsigned FindBunches(const sample_t* data, unsigned size, unsigned* bunchLength, unsigned* bunchTime)
+  {
+    const unsigned n=Size(size);
+    unsigned nBunches=0;
+    unsigned nBunchSamples=0;
+    for (unsigned i=n; i-->0;) {
+      if (data[i]==kVoidSample) {
+	if (nBunchSamples>0) {
+	  // bunch end
+	  bunchLength[nBunches++]=nBunchSamples;
+	  nBunchSamples=0;
+	}
+	continue;
+      }
+      if (nBunchSamples++==0) {
+	// bunch start
+	bunchTime[nBunches]=i;
+      }
+    }
+    if (nBunchSamples>0) {
+      bunchLength[nBunches++]=nBunchSamples;
+    }
+    return nBunches;
+  }
+
+  /// see ChannelKernels::CalculateStatistics
+  static void CalculateStatistics(const sample_t* data, unsigned size, ChannelSignalStatistics& statistics, unsigned* bunchLength)
+  {
+    const unsigned n=Size(size);
+    int MinSignal=-1;
+    int MaxSignal=-1;
+    int MinSignalDiff=-1;
+    int MaxSignalDiff=-1;
+    int AvrgSignal=0;
+    int MinTimebin=-1;
+    int MaxTimebin=n;
+    int NFilledTimebins=0;
+    int NBunches=0;
+    int nBunchSamples=0;
+    for (unsigned i=0; i<n; i++) {
+      int signal=data[i];
+      if (data[i]==kVoidSample) {
+	if (nBunchSamples>0) {
+	  bunchLength[NBunches++]=nBunchSamples;
+	  nBunchSamples=0;
+	}
+	continue;
+      }
+      nBunchSamples++;
+      if (MinTimebin<0) MinTimebin=i;
+      MaxTimebin=i;
+      if (MinSignal<0 || MinSignal>signal) MinSignal=signal;
+      if (MaxSignal<0 || MaxSignal<signal) MaxSignal=signal;
+      AvrgSignal+=signal;
+      NFilledTimebins++;
+      if (i>0 && data[i-1]!=kVoidSample) {
+	signal-=data[i-1];
+	if (MaxSignalDiff<0 || MaxSignalDiff<(signal>=0?signal:-signal))
+	  MaxSignalDiff=signal;
+	if (MinSignalDiff<0 || MinSignalDiff>(signal>=0?signal:-signal))
+	  MinSignalDiff=signal;
+      }
+    }
+    if (nBunchSamples>0) {
+      bunchLength[NBunches++]=nBunchSamples;
+    }
+    if (NFilledTimebins>0) {
+      AvrgSignal/=NFilledTimebins;
+    }
+    statistics.MinSignal=MinSignal;
+    statistics.MaxSignal=MaxSignal;
+    statistics.MinSignalDiff=MinSignalDiff;
+    statistics.MaxSignalDiff=MaxSignalDiff;
+    statistics.AvrgSignal=AvrgSignal;
+    statistics.MinTimebin=MinTimebin;
+    statistics.MaxTimebin=MaxTimebin;
+    statistics.NFilledTimebins=NFilledTimebins;
+    statistics.NBunches=NBunches;
+  }
+
+  /// see ChannelKernels::AddCommonMode
+  static void AddCommonMode(const sample_t* zsSignal, unsigned size, unsigned* cmSignal)
+  {
+    const unsigned n=Size(size);
+    for (unsigned i=0; i<n; ++i) {
+      // branch free, void timebins do not contribute
+      cmSignal[i]+=zsSignal[i]!=kVoidSample?zsSignal[i]:0;
+    }
+  }
+
+  /// see ChannelKernels::SubtractCommonMode
+  static int SubtractCommonMode(sample_t* signal, unsigned size, const unsigned* cmScaled)
+  {
+    const unsigned n=Size(size);
+    int nUnderflow=0;
+    for (unsigned i=0; i<n; ++i) {
+      // branch free, the division is done once per timebin by the caller
+      unsigned value=signal[i];
+      bool underflow=value<cmScaled[i];
+      nUnderflow+=underflow;
+      signal[i]=underflow?0:value-cmScaled[i];
+    }
+    return nUnderflow;
+  }
+
+  /// kernel table of this instantiation
+  static const ChannelKernels& GetKernels()
+  {
+    static const ChannelKernels kernels={
+      Length,
+      &FindBunches,
+      &CalculateStatistics,
+      &AddCommonMode,
+      &SubtractCommonMode
+    };
+    return kernels;
+  }
+
+ private:
+  /// standard constructor prohibited, only static functions
+  ChannelMergerT();
+};
+
+/**
+ * Select the kernels for a channel length.
+ * The specialized instantiations are used for 1024 and 1021 timebins,
+ * the generic kernels otherwise.
+ */
+const ChannelKernels& SelectChannelKernels(unsigned length);
+
+#endif
@@ -0,0 +1,79 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ChannelSource.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Interface for sources of channel data
+
+#include "ChannelSource.h"
+#include "ArchiveChannelSource.h"
+#include "SyntheticChannelSource.h"
+#include "EventArchive.h"
+#include <vector>
+#include <cstring>
+
+namespace {
+  std::vector<ChannelSource::factory_t>& Factories() {
+    // function local static to be independent of initialization order
+    static std::vector<ChannelSource::factory_t> factories;
+    return factories;
+  }
+}
+
+ChannelSource::ChannelSource()
+  : mName()
+{
+}
+
+ChannelSource::~ChannelSource()
+{
+}
+
+void ChannelSource::RegisterFactory(factory_t factory)
+{
+  if (factory==NULL) return;
+  std::vector<factory_t>& factories=Factories();
+  for (std::vector<factory_t>::const_iterator element=factories.begin();
+       element!=factories.end(); element++) {
+    if (*element==factory) return;
+  }
+  factories.push_back(factory);
+}
+
+ChannelSource* ChannelSource::Create(const char* name)
+{
+  if (name==NULL) return NULL;
+  if (EventArchive::IsArchiveFile(name)) {
+    ArchiveChannelSource* source=new ArchiveChannelSource;
+    if (source->Open(name)<0) {
+      delete source;
+      return NULL;
+    }
+    return source;
+  }
+  if (strncmp(name, SyntheticChannelSource::kPrefix, strlen(SyntheticChannelSource::kPrefix))==0) {
+    SyntheticChannelSource* source=new SyntheticChannelSource;
+    if (source->Init(name)<0) {
+      delete source;
+      return NULL;
+    }
+    return source;
+  }
+  const std::vector<factory_t>& factories=Factories();
+  for (std::vector<factory_t>::const_iterator factory=factories.begin();
+       factory!=factories.end(); factory++) {
+    ChannelSource* source=(**factory)(name);
+    if (source) return source;
+  }
+  return NULL;
+}
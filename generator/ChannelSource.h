@@ -0,0 +1,140 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ChannelSource.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Interface for sources of channel data
+
+#ifndef CHANNELSOURCE_H
+#define CHANNELSOURCE_H
+
+#include <string>
+#include <cstddef>
+
+class DecodedEvent;
+
+/**
+ * @class ChannelSource
+ * Interface for reading events channel by channel.
+ *
+ * The interface follows the ALTRO raw stream: the DDLs of the current event
+ * are iterated with NextDDL, the channels of a DDL with NextChannel, and the
+ * bunches of a channel with NextBunch. The first signal of a bunch belongs to
+ * the start timebin, the following signals to decreasing timebins.
+ *
+ * Implementations:
+ * - RawChannelSource: TPC raw data via AliRawReader, requires AliRoot
+ * - ArchiveChannelSource: memory mapped EventArchive files
+ * - SyntheticChannelSource: reproducible random events for benchmarks
+ *
+ * Sources are created from a name by Create: archive files (extension
+ * ".evarc") and synthetic sources ("synthetic:" prefix) are handled directly,
+ * all other names are passed to the registered factories. The raw data
+ * source registers its factory when the library part depending on AliRoot
+ * is loaded.
+ */
+class ChannelSource {
+ public:
+  ChannelSource();
+  virtual ~ChannelSource();
+
+  /**
+   * Move to the next event.
+   * @return 1 if event available, 0 if no more events, negative error code
+   */
+  virtual int NextEvent()=0;
+
+  /**
+   * Move to an event by index.
+   * @return 0 on success, negative error code if failed
+   */
+  virtual int GotoEvent(int eventIndex)=0;
+
+  /// index of the current event
+  virtual int GetEventIndex() const=0;
+
+  /**
+   * Select the range of DDLs and rewind the iteration of the current event.
+   * Must be called after moving to an event before reading the DDLs.
+   * All DDLs are read if min or max are negative.
+   */
+  virtual void SelectDDLRange(int minDDL, int maxDDL)=0;
+
+  /// move to the next DDL of the current event
+  virtual bool NextDDL()=0;
+  /// number of the current DDL
+  virtual unsigned GetDDLNumber() const=0;
+  /// move to the next channel of the current DDL
+  virtual bool NextChannel()=0;
+  /// HW address of the current channel
+  virtual unsigned GetHWAddress() const=0;
+  /// check if the current channel has been marked bad during decoding
+  virtual bool IsChannelBad() const {return false;}
+  /// move to the next bunch of the current channel
+  virtual bool NextBunch()=0;
+  /// timebin of the first signal of the current bunch
+  virtual int GetStartTimeBin() const=0;
+  /// number of signals of the current bunch
+  virtual int GetBunchLength() const=0;
+  /// signals of the current bunch
+  virtual const unsigned short* GetSignals() const=0;
+
+  /**
+   * Get the current event in decoded format.
+   * Sources holding the data already decoded provide the event directly,
+   * the default implementation returns NULL.
+   */
+  virtual const DecodedEvent* GetDecodedEvent() {return NULL;}
+
+  /**
+   * Create an independent source reading the same input.
+   * Used by the worker threads which are positioned by GotoEvent.
+   * @return new source, NULL if not supported
+   */
+  virtual ChannelSource* Clone() const {return NULL;}
+
+  /// name of the input, e.g. the file name
+  const std::string& GetName() const {return mName;}
+
+  /// factory function for sources
+  typedef ChannelSource* (*factory_t)(const char* name);
+
+  /**
+   * Register a factory.
+   * Factories are tried in order of registration, the first source created
+   * is used. A factory returns NULL for names it does not handle.
+   */
+  static void RegisterFactory(factory_t factory);
+
+  /**
+   * Create a source from a name.
+   * @return new source, NULL if no factory is handling the name
+   */
+  static ChannelSource* Create(const char* name);
+
+ protected:
+  /// set the name of the input
+  void SetName(const char* name) {mName=name?name:"";}
+
+ private:
+  /// copy constructor prohibited
+  ChannelSource(const ChannelSource&);
+  /// assignment operator prohibited
+  ChannelSource& operator=(const ChannelSource&);
+
+  /// name of the input
+  std::string mName;
+};
+#endif
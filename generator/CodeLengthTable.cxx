@@ -0,0 +1,160 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   CodeLengthTable.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Table of code lengths for the evaluation of entropy coding
+
+#include "CodeLengthTable.h"
+#include <cerrno>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CODELENGTHTABLE_AVX2
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CODELENGTHTABLE_SSE2
+#endif
+
+CodeLengthTable::CodeLengthTable(unsigned nSymbols, unsigned cutoffLength, unsigned escapeLength)
+  : mCodeLength(nSymbols, 0)
+  , mBitCost(nSymbols, 0)
+  , mCutoffLength(cutoffLength)
+  , mEscapeLength(escapeLength)
+{
+}
+
+CodeLengthTable::~CodeLengthTable()
+{
+}
+
+int CodeLengthTable::SetCodeLength(unsigned symbol, unsigned length)
+{
+  if (symbol>=mCodeLength.size() || length>0xff) return -EINVAL;
+  mCodeLength[symbol]=length;
+  if (mCutoffLength==0 || length<mCutoffLength) {
+    mBitCost[symbol]=length;
+  } else {
+    mBitCost[symbol]=mCutoffLength+mEscapeLength;
+  }
+  return 0;
+}
+
+unsigned CodeLengthTable::BitCount(const sample_t* symbols, unsigned size) const
+{
+  return BitCountSIMD(symbols, size);
+}
+
+unsigned CodeLengthTable::BitCountScalar(const sample_t* symbols, unsigned size) const
+{
+  const unsigned nSymbols=mBitCost.size();
+  const unsigned* cost=nSymbols>0?&mBitCost[0]:NULL;
+  // independent accumulators for overlapping lookups
+  unsigned bitcount[4]={0, 0, 0, 0};
+  unsigned i=0;
+  for (; i+4<=size; i+=4) {
+    for (unsigned k=0; k<4; k++) {
+      if (symbols[i+k]<nSymbols) bitcount[k]+=cost[symbols[i+k]];
+    }
+  }
+  for (; i<size; i++) {
+    if (symbols[i]<nSymbols) bitcount[0]+=cost[symbols[i]];
+  }
+  return bitcount[0]+bitcount[1]+bitcount[2]+bitcount[3];
+}
+
+unsigned CodeLengthTable::BitCountSIMD(const sample_t* symbols, unsigned size) const
+{
+#if defined(CODELENGTHTABLE_AVX2)
+  const unsigned nSymbols=mBitCost.size();
+  if (nSymbols==0) return 0;
+  const int* cost=reinterpret_cast<const int*>(&mBitCost[0]);
+  const __m256i limit=_mm256_set1_epi32(nSymbols);
+  __m256i accumulator=_mm256_setzero_si256();
+  unsigned i=0;
+  for (; i+8<=size; i+=8) {
+    __m256i index=_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(symbols+i)));
+    // symbols outside the alphabet do not contribute, as in the scalar kernel
+    __m256i valid=_mm256_cmpgt_epi32(limit, index);
+    accumulator=_mm256_add_epi32(accumulator, _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), cost, index, valid, 4));
+  }
+  __m128i sum=_mm_add_epi32(_mm256_castsi256_si128(accumulator), _mm256_extracti128_si256(accumulator, 1));
+  sum=_mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum=_mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  unsigned bitcount=_mm_cvtsi128_si32(sum);
+  return bitcount+BitCountScalar(symbols+i, size-i);
+#else
+  return BitCountScalar(symbols, size);
+#endif
+}
+
+int CodeLengthTable::DeltaSymbols(const sample_t* signals, unsigned size, unsigned signalRange, sample_t* symbols)
+{
+#if defined(CODELENGTHTABLE_SSE2)
+  if (signalRange==0 || signalRange>0x8000) return -EINVAL;
+  const __m128i voidSample=_mm_set1_epi16((short)kVoidSample);
+  const __m128i maxSignal=_mm_set1_epi16((short)(signalRange-1));
+  const __m128i offset=_mm_set1_epi16((short)signalRange);
+  sample_t lastSignal=0;
+  unsigned i=0;
+  for (; i+8<=size; i+=8) {
+    __m128i signal=_mm_loadu_si128(reinterpret_cast<const __m128i*>(signals+i));
+    __m128i isVoid=_mm_cmpeq_epi16(signal, voidSample);
+    // min(signal, maxSignal) with unsigned saturation, void signals are 0
+    signal=_mm_sub_epi16(signal, _mm_subs_epu16(signal, maxSignal));
+    signal=_mm_andnot_si128(isVoid, signal);
+    __m128i previous=_mm_or_si128(_mm_slli_si128(signal, 2), _mm_cvtsi32_si128(lastSignal));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(symbols+i), _mm_add_epi16(_mm_sub_epi16(signal, previous), offset));
+    lastSignal=_mm_extract_epi16(signal, 7);
+  }
+  for (; i<size; i++) {
+    sample_t signal=signals[i];
+    if (signal==kVoidSample) signal=0;
+    if (signal>=signalRange) signal=signalRange-1;
+    symbols[i]=signal+signalRange-lastSignal;
+    lastSignal=signal;
+  }
+  return 0;
+#else
+  return DeltaSymbolsScalar(signals, size, signalRange, symbols);
+#endif
+}
+
+int CodeLengthTable::DeltaSymbolsScalar(const sample_t* signals, unsigned size, unsigned signalRange, sample_t* symbols)
+{
+  if (signalRange==0 || signalRange>0x8000) return -EINVAL;
+  unsigned lastSignal=0;
+  for (unsigned i=0; i<size; i++) {
+    unsigned signal=signals[i];
+    if (signal==kVoidSample) {
+      signal=0;
+    }
+    if (signal>=signalRange) {
+      signal=signalRange-1;
+    }
+    symbols[i]=signal+signalRange-lastSignal;
+    lastSignal=signal;
+  }
+  return 0;
+}
+
+const char* CodeLengthTable::GetSIMDKernelName()
+{
+#if defined(CODELENGTHTABLE_AVX2)
+  return "avx2";
+#elif defined(CODELENGTHTABLE_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,136 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   CodeLengthTable.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Table of code lengths for the evaluation of entropy coding
+
+#ifndef CODELENGTHTABLE_H
+#define CODELENGTHTABLE_H
+
+#include <vector>
+
+/**
+ * @class CodeLengthTable
+ * Flat table of the code lengths of all symbols of an alphabet.
+ *
+ * The evaluation of a compression scheme only requires the number of bits
+ * of the encoded data. Instead of encoding every sample, the code length of
+ * each symbol is extracted once from the encoder and the bit count of a
+ * channel is the sum of table lookups. Symbols with code length equal to or
+ * exceeding the cutoff length are stored with an escape marker of cutoff
+ * length followed by the original value, the escape rule is part of the
+ * table.
+ *
+ * The symbols for the encoding of signal differences are calculated by
+ * DeltaSymbols. Both kernels are vectorized, the table lookup uses the
+ * AVX2 gather instruction if compiled with e.g. -mavx2.
+ *
+ * Usage:
+ * <pre>
+ *   CodeLengthTable table(2048, cutoff, 10);
+ *   for (unsigned symbol=0; symbol<2048; symbol++) {
+ *     table.SetCodeLength(symbol, length);
+ *   }
+ *   CodeLengthTable::DeltaSymbols(signals, size, 1024, symbols);
+ *   unsigned bitcount=table.BitCount(symbols, size);
+ * </pre>
+ */
+class CodeLengthTable {
+ public:
+  typedef unsigned short sample_t;
+
+  /// value of timebins without signal
+  static const sample_t kVoidSample=0xffff;
+
+  /**
+   * Constructor
+   * @param nSymbols      size of the alphabet
+   * @param cutoffLength  symbols with length >= cutoff are escaped, 0 - off
+   * @param escapeLength  number of bits of the original value of escaped symbols
+   */
+  CodeLengthTable(unsigned nSymbols, unsigned cutoffLength=0, unsigned escapeLength=0);
+  /// destructor
+  ~CodeLengthTable();
+
+  /**
+   * Set code length of a symbol.
+   * @return 0 on success, -EINVAL if symbol or length out of range
+   */
+  int SetCodeLength(unsigned symbol, unsigned length);
+
+  /// get code length of a symbol
+  unsigned GetCodeLength(unsigned symbol) const {
+    return symbol<mCodeLength.size()?mCodeLength[symbol]:0;
+  }
+
+  /// get number of bits for a symbol including the escape rule
+  unsigned GetBitCost(unsigned symbol) const {
+    return symbol<mBitCost.size()?mBitCost[symbol]:0;
+  }
+
+  /// size of the alphabet
+  unsigned GetNSymbols() const {return mCodeLength.size();}
+
+  /**
+   * Number of bits of a sequence of symbols, best available kernel.
+   * All symbols have to be in the alphabet.
+   */
+  unsigned BitCount(const sample_t* symbols, unsigned size) const;
+
+  /// number of bits of a sequence of symbols, scalar kernel
+  unsigned BitCountScalar(const sample_t* symbols, unsigned size) const;
+
+  /// number of bits of a sequence of symbols, vectorized kernel if available
+  unsigned BitCountSIMD(const sample_t* symbols, unsigned size) const;
+
+  /**
+   * Calculate the symbols for encoding of signal differences.
+   * Void signals are treated as 0, signals exceeding the range are
+   * truncated to the maximum. The difference to the previous signal is
+   * shifted by the signal range, the symbols are in the range
+   * [1, 2*signalRange-1].
+   * @param signals       signal buffer
+   * @param size          number of signals
+   * @param signalRange   range of signals, at most 0x8000
+   * @param symbols       target buffer
+   * @return 0 on success, -EINVAL if signal range not supported
+   */
+  static int DeltaSymbols(const sample_t* signals, unsigned size, unsigned signalRange, sample_t* symbols);
+
+  /// scalar version of DeltaSymbols, reference for the vectorized kernel
+  static int DeltaSymbolsScalar(const sample_t* signals, unsigned size, unsigned signalRange, sample_t* symbols);
+
+  /// name of the vectorized kernel, "scalar" if not available
+  static const char* GetSIMDKernelName();
+
+ private:
+  /// standard constructor prohibited
+  CodeLengthTable();
+  /// copy constructor prohibited
+  CodeLengthTable(const CodeLengthTable&);
+  /// assignment operator prohibited
+  CodeLengthTable& operator=(const CodeLengthTable&);
+
+  /// code length of the symbols
+  std::vector<unsigned char> mCodeLength;
+  /// number of bits per symbol including the escape rule, 32 bit for gather
+  std::vector<unsigned int> mBitCost;
+  /// cutoff length, 0 - off
+  unsigned mCutoffLength;
+  /// length of escaped values
+  unsigned mEscapeLength;
+};
+#endif
@@ -28,7 +28,6 @@ CollisionDistribution::CollisionDistribution(float rate)
   , mCollisionTimes()
   , mSeed(std::chrono::system_clock::now().time_since_epoch().count())
   , mGenerator(mSeed)
-  , mDistribution(mRate)
 {
 }
 
@@ -42,10 +41,10 @@ const std::vector<float>& CollisionDistribution::NextSequence()
   mCollisionTimes.clear();
   // mOffset determines the location of the firt collision in this sequence,
   // optionally take a random value for the very first entry 
-  mCollisionTimes.push_back(mOffset<0.?mDistribution(mGenerator):mOffset);
+  mCollisionTimes.push_back(mOffset<0.?mGenerator.Exponential(mRate):mOffset);
   // fill with collisions until the framesize is exceeded
   while (mCollisionTimes.back()<mFramesize) {
-    float dt=mDistribution(mGenerator);
+    float dt=mGenerator.Exponential(mRate);
     mCollisionTimes.push_back(mCollisionTimes.back() + dt);
   }
   // remove the last collision (which exceeded the framesize) from the
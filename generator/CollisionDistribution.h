@@ -21,7 +21,8 @@
 
 #ifndef COLLISIONDISTRIBUTION_H
 #define COLLISIONDISTRIBUTION_H
-#include <random>
+#include <vector>
+#include "RandomGenerator.h"
 
 /** @class CollisionDistribution
  *  A generator of collision sequences following an exponential distribution
@@ -57,6 +58,12 @@ class CollisionDistribution {
   void SetRate(float rate) {mRate = rate;}
   /// get collision rate
   float GetRate() const {return mRate;}
+  /**
+   * Set seed of the random generator for reproducible sequences.
+   * Generators with the same seed and different streams produce
+   * independent sequences.
+   */
+  void SetSeed(int seed, unsigned stream=0) {mSeed = seed; mGenerator.Seed(seed, stream);}
 
   /**
    * Simulate sequence of collisions within a timeframe
@@ -77,8 +84,6 @@ class CollisionDistribution {
   /// seed for random generator, generated from timestamp
   int mSeed;
   /// random generator
-  std::default_random_engine mGenerator;
-  /// the distribution of times between collisions
-  std::exponential_distribution<float> mDistribution;
+  RandomGenerator mGenerator;
 };
 #endif
@@ -0,0 +1,92 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   CollisionTimeline.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Pre-drawn collision times and events of a sequence of timeframes
+
+#include "CollisionTimeline.h"
+#include <cerrno>
+
+CollisionTimeline::CollisionTimeline()
+  : mCollisionTimes()
+  , mFrameStart()
+  , mInputNames()
+  , mInput()
+  , mEvent()
+  , mNewChannels()
+  , mNewChannelsEnd()
+{
+}
+
+CollisionTimeline::~CollisionTimeline()
+{
+}
+
+void CollisionTimeline::AddFrame(const std::vector<float>& collisionTimes)
+{
+  mFrameStart.push_back(mCollisionTimes.size());
+  mCollisionTimes.insert(mCollisionTimes.end(), collisionTimes.begin(), collisionTimes.end());
+}
+
+std::vector<float> CollisionTimeline::GetCollisionTimes(unsigned frame) const
+{
+  return std::vector<float>(mCollisionTimes.begin()+mFrameStart[frame],
+			    mCollisionTimes.begin()+FrameEnd(frame));
+}
+
+unsigned CollisionTimeline::AddInput(const std::string& name)
+{
+  mInputNames.push_back(name);
+  return mInputNames.size()-1;
+}
+
+int CollisionTimeline::AssignEvent(unsigned input, int event)
+{
+  if (mInput.size()>=mCollisionTimes.size()) return -ENOSPC;
+  mInput.push_back(input);
+  mEvent.push_back(event);
+  mNewChannelsEnd.push_back(mNewChannels.size());
+  return mInput.size()-1;
+}
+
+unsigned CollisionTimeline::GetNAssignedFrames() const
+{
+  unsigned frame=0;
+  while (frame<mFrameStart.size() && FrameEnd(frame)<=mInput.size()) frame++;
+  return frame;
+}
+
+int CollisionTimeline::GetEvent(unsigned frame, unsigned collision, unsigned& input) const
+{
+  unsigned i=mFrameStart[frame]+collision;
+  if (i>=mInput.size()) return -1;
+  input=mInput[i];
+  return mEvent[i];
+}
+
+void CollisionTimeline::AddNewChannel(unsigned index)
+{
+  mNewChannels.push_back(index);
+  if (!mNewChannelsEnd.empty()) mNewChannelsEnd.back()=mNewChannels.size();
+}
+
+void CollisionTimeline::GetChannels(unsigned endFrame, std::vector<unsigned>& channels) const
+{
+  channels.clear();
+  if (endFrame==0 || mFrameStart.empty()) return;
+  unsigned end=endFrame<mFrameStart.size()?mFrameStart[endFrame]:mCollisionTimes.size();
+  if (end>mNewChannelsEnd.size()) end=mNewChannelsEnd.size();
+  if (end==0) return;
+  channels.assign(mNewChannels.begin(), mNewChannels.begin()+mNewChannelsEnd[end-1]);
+}
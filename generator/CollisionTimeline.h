@@ -0,0 +1,134 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   CollisionTimeline.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Pre-drawn collision times and events of a sequence of timeframes
+
+#ifndef COLLISIONTIMELINE_H
+#define COLLISIONTIMELINE_H
+
+#include <vector>
+#include <string>
+
+/**
+ * @class CollisionTimeline
+ * Collision times of all timeframes of a run and the events merged for
+ * the collisions.
+ *
+ * The sequential generation draws the collision times frame by frame and
+ * reads the next event of the input for every collision. The timeline
+ * holds the same collision times and event assignment for all frames up
+ * front, any frame can then be merged independently of the frames before,
+ * see ChannelMerger::MergeCollisions. Samples shifted into a frame from
+ * preceding frames are restored by merging the collisions of the frames
+ * spanned by the drift length before the frame.
+ *
+ * The channels of the timeframes are the channels of all events merged so
+ * far. For every collision, the timeline keeps the channels which appear
+ * the first time, the channel set of any frame can be restored without
+ * reading the preceding events, see ChannelMerger::RegisterChannels.
+ *
+ * The events are assigned by ChannelMerger::AssignEvents, which applies
+ * the channel selection of the merger.
+ */
+class CollisionTimeline {
+ public:
+  CollisionTimeline();
+  ~CollisionTimeline();
+
+  /// add the collision times of the next frame
+  void AddFrame(const std::vector<float>& collisionTimes);
+
+  /// number of frames
+  unsigned GetNFrames() const {return mFrameStart.size();}
+
+  /// number of collisions of a frame
+  unsigned GetNCollisions(unsigned frame) const {
+    return FrameEnd(frame)-mFrameStart[frame];
+  }
+
+  /// collision times of a frame
+  std::vector<float> GetCollisionTimes(unsigned frame) const;
+
+  /// total number of collisions
+  unsigned GetNCollisions() const {return mCollisionTimes.size();}
+
+  /// time of a collision of a frame
+  float GetCollisionTime(unsigned frame, unsigned collision) const {
+    return mCollisionTimes[mFrameStart[frame]+collision];
+  }
+
+  /**
+   * Add an input to the list of inputs.
+   * @return number of the input
+   */
+  unsigned AddInput(const std::string& name);
+
+  /// name of an input
+  const std::string& GetInputName(unsigned input) const {return mInputNames[input];}
+
+  /**
+   * Assign an event to the next collision without event.
+   * @return number of the collision, -ENOSPC if all collisions have events
+   */
+  int AssignEvent(unsigned input, int event);
+
+  /// number of collisions with event, starting from the first collision
+  unsigned GetNAssignedCollisions() const {return mInput.size();}
+
+  /// number of frames with events for all collisions
+  unsigned GetNAssignedFrames() const;
+
+  /**
+   * Event of a collision.
+   * @param input    target to receive the number of the input
+   * @return event number, -1 if no event has been assigned
+   */
+  int GetEvent(unsigned frame, unsigned collision, unsigned& input) const;
+
+  /// add a channel appearing the first time with the last assigned collision
+  void AddNewChannel(unsigned index);
+
+  /**
+   * Channels appearing the first time in the collisions of frames before
+   * a frame.
+   * @param endFrame  first frame not included
+   * @param channels  target to receive the channel indices
+   */
+  void GetChannels(unsigned endFrame, std::vector<unsigned>& channels) const;
+
+ private:
+  /// end of a frame in the collision list
+  unsigned FrameEnd(unsigned frame) const {
+    return frame+1<mFrameStart.size()?mFrameStart[frame+1]:mCollisionTimes.size();
+  }
+
+  /// collision times of all frames
+  std::vector<float> mCollisionTimes;
+  /// first collision of every frame
+  std::vector<unsigned> mFrameStart;
+  /// names of the inputs
+  std::vector<std::string> mInputNames;
+  /// input of every assigned collision
+  std::vector<unsigned> mInput;
+  /// event in the input of every assigned collision
+  std::vector<int> mEvent;
+  /// channels in the order of first appearance
+  std::vector<unsigned> mNewChannels;
+  /// number of new channels up to and including every assigned collision
+  std::vector<unsigned> mNewChannelsEnd;
+};
+#endif
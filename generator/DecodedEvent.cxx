@@ -0,0 +1,87 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   DecodedEvent.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Compact representation of the decoded channels of one event
+
+#include "DecodedEvent.h"
+
+DecodedEvent::DecodedEvent()
+  : mNDDLs(0)
+  , mChannelIndex()
+  , mChannelOffset()
+  , mPayload()
+  , mNChannels(0)
+  , mPayloadSize(0)
+  , mIndexData(NULL)
+  , mOffsetData(NULL)
+  , mPayloadData(NULL)
+{
+}
+
+DecodedEvent::~DecodedEvent()
+{
+}
+
+void DecodedEvent::AddBunch(unsigned startTime, unsigned length, const sample_t* signals)
+{
+  mPayload.push_back(startTime);
+  mPayload.push_back(length);
+  mPayload.insert(mPayload.end(), signals, signals+length);
+  UpdateView();
+}
+
+void DecodedEvent::Attach(unsigned nDDLs, unsigned nChannels, const unsigned* index, const unsigned* offset, unsigned payloadSize, const sample_t* payload)
+{
+  Clear();
+  mNDDLs=nDDLs;
+  mNChannels=nChannels;
+  mPayloadSize=payloadSize;
+  mIndexData=index;
+  mOffsetData=offset;
+  mPayloadData=payload;
+}
+
+void DecodedEvent::UpdateView()
+{
+  mNChannels=mChannelIndex.size();
+  mPayloadSize=mPayload.size();
+  mIndexData=mChannelIndex.empty()?NULL:&mChannelIndex[0];
+  mOffsetData=mChannelOffset.empty()?NULL:&mChannelOffset[0];
+  mPayloadData=mPayload.empty()?NULL:&mPayload[0];
+}
+
+void DecodedEvent::Clear()
+{
+  mNDDLs=0;
+  mChannelIndex.clear();
+  mChannelOffset.clear();
+  mPayload.clear();
+  UpdateView();
+}
+
+void DecodedEvent::Compact()
+{
+  std::vector<unsigned>(mChannelIndex).swap(mChannelIndex);
+  std::vector<unsigned>(mChannelOffset).swap(mChannelOffset);
+  std::vector<sample_t>(mPayload).swap(mPayload);
+  UpdateView();
+}
+
+unsigned long DecodedEvent::GetSize() const
+{
+  return mChannelIndex.capacity()*sizeof(unsigned)
+    + mChannelOffset.capacity()*sizeof(unsigned)
+    + mPayload.capacity()*sizeof(sample_t);
+}
@@ -0,0 +1,142 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   DecodedEvent.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Compact representation of the decoded channels of one event
+
+#ifndef DECODEDEVENT_H
+#define DECODEDEVENT_H
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * @class DecodedEvent
+ * Decoded raw data of one event, stored as bunch lists per channel.
+ *
+ * Channels are identified by the channel index composed out of DDL number
+ * and HW address. The data of all channels is kept in one payload array,
+ * the bunches of a channel are stored consecutively in the order of
+ * decoding:
+ * <pre>
+ * startTime length signal[0] ... signal[length-1]
+ * </pre>
+ * The signals follow the ALTRO convention, the first signal belongs to the
+ * start timebin and the following signals to decreasing timebins.
+ *
+ * The event either owns its data or is attached to external arrays of the
+ * same layout, e.g. a memory mapped EventArchive, without copying.
+ */
+class DecodedEvent {
+ public:
+  typedef unsigned short sample_t;
+
+  DecodedEvent();
+  ~DecodedEvent();
+
+  /// add a DDL, channels of the DDL follow
+  void AddDDL() {mNDDLs++;}
+
+  /**
+   * Add a channel, bunches added afterwards belong to this channel.
+   * @param index    channel index composed out of DDL number and HW address
+   */
+  void AddChannel(unsigned index) {
+    mChannelIndex.push_back(index);
+    mChannelOffset.push_back(mPayload.size());
+    UpdateView();
+  }
+
+  /**
+   * Add a bunch to the current channel.
+   * @param startTime   timebin of the first signal
+   * @param length      number of signals
+   * @param signals     signal array
+   */
+  void AddBunch(unsigned startTime, unsigned length, const sample_t* signals);
+
+  /// number of DDLs
+  unsigned GetNDDLs() const {return mNDDLs;}
+
+  /// number of channels
+  unsigned GetNChannels() const {return mNChannels;}
+
+  /// channel index of a channel
+  unsigned GetChannelIndex(unsigned channel) const {return mIndexData[channel];}
+
+  /// array of channel indices
+  const unsigned* GetChannelIndexArray() const {return mIndexData;}
+
+  /// array of payload offsets of the channels
+  const unsigned* GetChannelOffsetArray() const {return mOffsetData;}
+
+  /// number of payload words
+  unsigned GetPayloadSize() const {return mPayloadSize;}
+
+  /// payload of all channels
+  const sample_t* GetPayload() const {return mPayloadData;}
+
+  /**
+   * Get the bunch data of a channel.
+   * @param channel   channel number
+   * @param size      target to receive the number of payload words
+   * @return pointer to the first bunch
+   */
+  const sample_t* GetChannelData(unsigned channel, unsigned& size) const {
+    unsigned offset=mOffsetData[channel];
+    size=(channel+1<mNChannels?mOffsetData[channel+1]:mPayloadSize)-offset;
+    return mPayloadData?mPayloadData+offset:NULL;
+  }
+
+  /**
+   * Attach to external data, the event does not own the data.
+   * The arrays must stay valid as long as the event is used.
+   */
+  void Attach(unsigned nDDLs, unsigned nChannels, const unsigned* index, const unsigned* offset, unsigned payloadSize, const sample_t* payload);
+
+  /// release all data
+  void Clear();
+
+  /// release unused capacity of the internal arrays, only for owned data
+  void Compact();
+
+  /// memory size of the event data in byte
+  unsigned long GetSize() const;
+
+ private:
+  /// set the data pointers to the owned arrays
+  void UpdateView();
+
+  /// number of DDLs
+  unsigned mNDDLs;
+  /// channel index of every channel
+  std::vector<unsigned> mChannelIndex;
+  /// offset of the bunch data of every channel in the payload
+  std::vector<unsigned> mChannelOffset;
+  /// bunch data of all channels
+  std::vector<sample_t> mPayload;
+  /// number of channels
+  unsigned mNChannels;
+  /// number of payload words
+  unsigned mPayloadSize;
+  /// channel index array, owned or attached
+  const unsigned* mIndexData;
+  /// channel offset array, owned or attached
+  const unsigned* mOffsetData;
+  /// payload, owned or attached
+  const sample_t* mPayloadData;
+};
+#endif
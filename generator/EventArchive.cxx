@@ -0,0 +1,221 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   EventArchive.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Binary archive of decoded events
+
+#include "EventArchive.h"
+#include "DecodedEvent.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+const char* EventArchive::kMagic="TPCEVARC";
+const unsigned EventArchive::kVersion;
+
+namespace {
+  /// size of the file header
+  const unsigned kHeaderSize=24;
+  /// size of the header of an event record
+  const unsigned kEventHeaderSize=16;
+
+  /// order channels of an event by channel index
+  struct ChannelOrder {
+    ChannelOrder(const DecodedEvent& event) : mEvent(event) {}
+    bool operator()(unsigned a, unsigned b) const {
+      return mEvent.GetChannelIndex(a) < mEvent.GetChannelIndex(b);
+    }
+    const DecodedEvent& mEvent;
+  };
+}
+
+EventArchive::EventArchive()
+  : mData(NULL)
+  , mSize(0)
+  , mNEvents(0)
+  , mEventTable(NULL)
+{
+}
+
+EventArchive::~EventArchive()
+{
+  Close();
+}
+
+int EventArchive::Open(const char* filename)
+{
+  Close();
+  int fd=open(filename, O_RDONLY);
+  if (fd<0) return -errno;
+  struct stat fileStat;
+  if (fstat(fd, &fileStat)<0 || fileStat.st_size<(off_t)kHeaderSize) {
+    close(fd);
+    return -EINVAL;
+  }
+  void* data=mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping keeps a reference to the file
+  close(fd);
+  if (data==MAP_FAILED) return -errno;
+  mData=(const char*)data;
+  mSize=fileStat.st_size;
+
+  unsigned version=0;
+  unsigned long long tableOffset=0;
+  memcpy(&version, mData+8, sizeof(version));
+  memcpy(&mNEvents, mData+12, sizeof(mNEvents));
+  memcpy(&tableOffset, mData+16, sizeof(tableOffset));
+  if (memcmp(mData, kMagic, 8)!=0 || version!=kVersion ||
+      tableOffset%8!=0 || tableOffset>mSize ||
+      (mSize-tableOffset)/sizeof(unsigned long long)<mNEvents) {
+    Close();
+    return -EINVAL;
+  }
+  mEventTable=(const unsigned long long*)(mData+tableOffset);
+  return 0;
+}
+
+void EventArchive::Close()
+{
+  if (mData) munmap((void*)mData, mSize);
+  mData=NULL;
+  mSize=0;
+  mNEvents=0;
+  mEventTable=NULL;
+}
+
+int EventArchive::GetEvent(unsigned eventNo, DecodedEvent& event) const
+{
+  if (eventNo>=mNEvents) return -ENOENT;
+  unsigned long long offset=mEventTable[eventNo];
+  if (offset%8!=0 || offset+kEventHeaderSize>mSize) return -EINVAL;
+  const unsigned* header=(const unsigned*)(mData+offset);
+  unsigned nDDLs=header[0];
+  unsigned nChannels=header[1];
+  unsigned payloadSize=header[2];
+  unsigned long long recordSize=kEventHeaderSize
+    + 2*(unsigned long long)nChannels*sizeof(unsigned)
+    + (unsigned long long)payloadSize*sizeof(DecodedEvent::sample_t);
+  if (recordSize>mSize-offset) return -EINVAL;
+  const unsigned* index=header+kEventHeaderSize/sizeof(unsigned);
+  const unsigned* channelOffset=index+nChannels;
+  const DecodedEvent::sample_t* payload=(const DecodedEvent::sample_t*)(channelOffset+nChannels);
+  // the size of a channel is given by the offset of the next channel,
+  // the bunches of every channel have to end at the channel end
+  for (unsigned i=0; i<nChannels; i++) {
+    unsigned end=i+1<nChannels?channelOffset[i+1]:payloadSize;
+    if (channelOffset[i]>end || end>payloadSize) return -EINVAL;
+    for (unsigned position=channelOffset[i]; position<end; position+=2+payload[position+1]) {
+      if (end-position<2 || payload[position+1]>end-position-2) return -EINVAL;
+    }
+  }
+  event.Attach(nDDLs, nChannels, index, channelOffset, payloadSize, payload);
+  return 0;
+}
+
+bool EventArchive::IsArchiveFile(const char* filename)
+{
+  if (filename==NULL) return false;
+  const char* extension=".evarc";
+  unsigned length=strlen(filename);
+  return length>strlen(extension) &&
+    strcmp(filename+length-strlen(extension), extension)==0;
+}
+
+EventArchiveWriter::EventArchiveWriter()
+  : mFile()
+  , mEventTable()
+{
+}
+
+EventArchiveWriter::~EventArchiveWriter()
+{
+  if (mFile.is_open()) Close();
+}
+
+int EventArchiveWriter::Open(const char* filename)
+{
+  if (mFile.is_open()) Close();
+  mEventTable.clear();
+  mFile.open(filename, std::ios::binary | std::ios::trunc);
+  if (!mFile.good()) return -ENOENT;
+  // header is written with the final event count in Close
+  char header[kHeaderSize];
+  memset(header, 0, kHeaderSize);
+  mFile.write(header, kHeaderSize);
+  return mFile.good()?0:-EIO;
+}
+
+int EventArchiveWriter::AddEvent(const DecodedEvent& event)
+{
+  if (!mFile.is_open()) return -EBADF;
+  unsigned nChannels=event.GetNChannels();
+  std::vector<unsigned> order(nChannels);
+  for (unsigned i=0; i<nChannels; i++) order[i]=i;
+  std::stable_sort(order.begin(), order.end(), ChannelOrder(event));
+
+  std::vector<unsigned> index(nChannels);
+  std::vector<unsigned> offset(nChannels);
+  std::vector<DecodedEvent::sample_t> payload;
+  payload.reserve(event.GetPayloadSize());
+  for (unsigned i=0; i<nChannels; i++) {
+    unsigned size=0;
+    const DecodedEvent::sample_t* data=event.GetChannelData(order[i], size);
+    index[i]=event.GetChannelIndex(order[i]);
+    offset[i]=payload.size();
+    if (size>0) payload.insert(payload.end(), data, data+size);
+  }
+
+  mEventTable.push_back(mFile.tellp());
+  unsigned header[kEventHeaderSize/sizeof(unsigned)]={event.GetNDDLs(), nChannels, (unsigned)payload.size(), 0};
+  mFile.write((const char*)header, kEventHeaderSize);
+  if (nChannels>0) {
+    mFile.write((const char*)&index[0], nChannels*sizeof(unsigned));
+    mFile.write((const char*)&offset[0], nChannels*sizeof(unsigned));
+  }
+  if (payload.size()>0) {
+    mFile.write((const char*)&payload[0], payload.size()*sizeof(DecodedEvent::sample_t));
+  }
+  Align();
+  return mFile.good()?0:-EIO;
+}
+
+void EventArchiveWriter::Align()
+{
+  static const char padding[8]={0};
+  unsigned long long position=mFile.tellp();
+  if (position%8) mFile.write(padding, 8-position%8);
+}
+
+int EventArchiveWriter::Close()
+{
+  if (!mFile.is_open()) return -EBADF;
+  unsigned long long tableOffset=mFile.tellp();
+  if (mEventTable.size()>0) {
+    mFile.write((const char*)&mEventTable[0], mEventTable.size()*sizeof(unsigned long long));
+  }
+  unsigned version=EventArchive::kVersion;
+  unsigned nEvents=mEventTable.size();
+  mFile.seekp(0);
+  mFile.write(EventArchive::kMagic, 8);
+  mFile.write((const char*)&version, sizeof(version));
+  mFile.write((const char*)&nEvents, sizeof(nEvents));
+  mFile.write((const char*)&tableOffset, sizeof(tableOffset));
+  bool good=mFile.good();
+  mFile.close();
+  return good?(int)nEvents:-EIO;
+}
@@ -0,0 +1,149 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   EventArchive.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Binary archive of decoded events
+
+#ifndef EVENTARCHIVE_H
+#define EVENTARCHIVE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+
+class DecodedEvent;
+
+/**
+ * @class EventArchive
+ * Memory mapped archive of decoded events.
+ *
+ * The archive stores the events in the layout of DecodedEvent, the reader
+ * maps the file into memory and attaches DecodedEvent objects directly to
+ * the mapped data without copying. Multiple processes reading the same
+ * archive share the pages of the file cache.
+ *
+ * File layout, all numbers in native byte order, records aligned to 8 byte:
+ * <pre>
+ * header:       char magic[8] "TPCEVARC"
+ *               uint32 version, uint32 number of events
+ *               uint64 offset of the event table
+ * event record: uint32 nDDLs, uint32 nChannels, uint32 payloadSize, uint32 reserved
+ *               uint32 channelIndex[nChannels]  ordered by channel index
+ *               uint32 channelOffset[nChannels] payload offset of the channel
+ *               uint16 payload[payloadSize]     bunch data, see DecodedEvent
+ * event table:  uint64 offset[nEvents]          file offset of event records
+ * </pre>
+ *
+ * Archives are written by EventArchiveWriter, e.g. with the macro
+ * convert-raw-to-archive.C.
+ */
+class EventArchive {
+ public:
+  EventArchive();
+  ~EventArchive();
+
+  /**
+   * Open and map an archive file.
+   * @return 0 on success, negative error code if failed
+   */
+  int Open(const char* filename);
+
+  /// unmap the archive
+  void Close();
+
+  /// check if an archive is open
+  bool IsOpen() const {return mData!=NULL;}
+
+  /// number of events in the archive
+  unsigned GetNEvents() const {return mNEvents;}
+
+  /**
+   * Attach an event object to the data of an event in the archive.
+   * The data stays valid until the archive is closed. The channel offsets
+   * and the bunches of every channel are checked against the record size.
+   * @return 0 on success, -ENOENT if out of range, -EINVAL if corrupted
+   */
+  int GetEvent(unsigned eventNo, DecodedEvent& event) const;
+
+  /// check file name for archive extension ".evarc"
+  static bool IsArchiveFile(const char* filename);
+
+  static const char* kMagic;
+  static const unsigned kVersion=1;
+
+ private:
+  /// copy constructor prohibited
+  EventArchive(const EventArchive&);
+  /// assignment operator prohibited
+  EventArchive& operator=(const EventArchive&);
+
+  /// mapped file
+  const char* mData;
+  /// size of the mapped file
+  unsigned long mSize;
+  /// number of events
+  unsigned mNEvents;
+  /// event table in the mapped file
+  const unsigned long long* mEventTable;
+};
+
+/**
+ * @class EventArchiveWriter
+ * Writer for EventArchive files.
+ *
+ * Channels of an event are written ordered by channel index.
+ */
+class EventArchiveWriter {
+ public:
+  EventArchiveWriter();
+  ~EventArchiveWriter();
+
+  /**
+   * Create archive file.
+   * @return 0 on success, negative error code if failed
+   */
+  int Open(const char* filename);
+
+  /**
+   * Write an event.
+   * @return 0 on success, negative error code if failed
+   */
+  int AddEvent(const DecodedEvent& event);
+
+  /**
+   * Write event table and header and close the file.
+   * @return number of events, negative error code if failed
+   */
+  int Close();
+
+  /// number of written events
+  unsigned GetNEvents() const {return mEventTable.size();}
+
+ private:
+  /// copy constructor prohibited
+  EventArchiveWriter(const EventArchiveWriter&);
+  /// assignment operator prohibited
+  EventArchiveWriter& operator=(const EventArchiveWriter&);
+
+  /// pad the file to 8 byte alignment
+  void Align();
+
+  /// output file
+  std::ofstream mFile;
+  /// file offsets of the events
+  std::vector<unsigned long long> mEventTable;
+};
+#endif
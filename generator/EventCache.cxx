@@ -0,0 +1,109 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   EventCache.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Memory bounded cache of decoded events
+//  @note   requires C++11 standard
+
+#include "EventCache.h"
+#include "DecodedEvent.h"
+
+EventCache::EventCache(unsigned long maxSize)
+  : mEntries()
+  , mIndex()
+  , mSlots()
+  , mMaxSize(maxSize)
+  , mSize(0)
+  , mNHits(0)
+  , mNMisses(0)
+  , mNEvictions(0)
+  , mGenerator()
+{
+}
+
+EventCache::~EventCache()
+{
+  for (auto& entry : mEntries) {
+    delete entry.event;
+  }
+}
+
+const DecodedEvent* EventCache::Find(const std::string& key)
+{
+  auto element=mIndex.find(key);
+  if (element==mIndex.end()) {
+    mNMisses++;
+    return nullptr;
+  }
+  mNHits++;
+  Touch(element->second);
+  return element->second->event;
+}
+
+const DecodedEvent* EventCache::Insert(const std::string& key, DecodedEvent* event)
+{
+  if (event==nullptr) return nullptr;
+  auto element=mIndex.find(key);
+  if (element!=mIndex.end()) {
+    // replace existing entry
+    entries_t::iterator entry=element->second;
+    mSize-=entry->size;
+    delete entry->event;
+    entry->event=event;
+    entry->size=event->GetSize();
+    mSize+=entry->size;
+    Touch(entry);
+  } else {
+    Entry entry={key, event, event->GetSize(), (unsigned)mSlots.size()};
+    mEntries.push_front(entry);
+    mIndex[key]=mEntries.begin();
+    mSlots.push_back(mEntries.begin());
+    mSize+=entry.size;
+  }
+  // the new event is at the front and never evicted
+  while (mSize>mMaxSize && mEntries.size()>1) {
+    Evict();
+  }
+  return event;
+}
+
+const DecodedEvent* EventCache::Draw()
+{
+  if (mSlots.empty()) return nullptr;
+  std::uniform_int_distribution<unsigned> distribution(0, mSlots.size()-1);
+  entries_t::iterator entry=mSlots[distribution(mGenerator)];
+  Touch(entry);
+  return entry->event;
+}
+
+void EventCache::Touch(entries_t::iterator entry)
+{
+  // splice keeps the iterators valid
+  mEntries.splice(mEntries.begin(), mEntries, entry);
+}
+
+void EventCache::Evict()
+{
+  entries_t::iterator entry=--mEntries.end();
+  // fill the slot of the removed entry with the last slot
+  unsigned slot=entry->slot;
+  mSlots[slot]=mSlots.back();
+  mSlots[slot]->slot=slot;
+  mSlots.pop_back();
+  mIndex.erase(entry->key);
+  mSize-=entry->size;
+  delete entry->event;
+  mEntries.erase(entry);
+  mNEvictions++;
+}
@@ -0,0 +1,123 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   EventCache.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Memory bounded cache of decoded events
+//  @note   requires C++11 standard
+
+#ifndef EVENTCACHE_H
+#define EVENTCACHE_H
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <random>
+
+class DecodedEvent;
+
+/** @class EventCache
+ *  Cache of decoded events with an upper bound on the memory size.
+ *
+ *  Events are identified by a key, e.g. composed out of file name and event
+ *  number. When inserting a new event, the least recently used events are
+ *  removed until the total size fits into the limit. The last inserted
+ *  event is always kept.
+ *
+ *  Events can be drawn randomly from the cache to replay them as pileup
+ *  without decoding the raw data again.
+ *
+ *  The header uses C++11 features and must not be included in headers
+ *  parsed by root cint, see GeneratorTF.
+ */
+class EventCache {
+ public:
+  /** standard constructor
+   *  @param maxSize   maximum size of all cached events in byte
+   */
+  EventCache(unsigned long maxSize);
+  /// destructor
+  ~EventCache();
+
+  /**
+   * Find event, the event is marked most recently used.
+   * @return pointer to event, NULL if not in the cache
+   */
+  const DecodedEvent* Find(const std::string& key);
+
+  /**
+   * Insert an event, the cache takes ownership.
+   * @return pointer to the cached event
+   */
+  const DecodedEvent* Insert(const std::string& key, DecodedEvent* event);
+
+  /**
+   * Draw a random event out of the cache.
+   * All cached events have equal probability, the event is marked most
+   * recently used.
+   * @return pointer to event, NULL if cache is empty
+   */
+  const DecodedEvent* Draw();
+
+  /// seed of the random generator for drawing events
+  void SetSeed(unsigned seed) {mGenerator.seed(seed);}
+
+  /// number of cached events
+  unsigned GetNEvents() const {return mSlots.size();}
+  /// total size of cached events in byte
+  unsigned long GetSize() const {return mSize;}
+  /// limit for the total size
+  unsigned long GetMaxSize() const {return mMaxSize;}
+  /// number of successful lookups
+  unsigned long GetNHits() const {return mNHits;}
+  /// number of failed lookups
+  unsigned long GetNMisses() const {return mNMisses;}
+  /// number of removed events
+  unsigned long GetNEvictions() const {return mNEvictions;}
+
+ private:
+  /// copy constructor prohibited
+  EventCache(const EventCache&);
+  /// assignment operator prohibited
+  EventCache& operator=(const EventCache&);
+
+  struct Entry {
+    std::string key;
+    DecodedEvent* event;
+    unsigned long size;
+    /// position in the list of slots
+    unsigned slot;
+  };
+  typedef std::list<Entry> entries_t;
+
+  /// move entry to front of the usage list
+  void Touch(entries_t::iterator entry);
+  /// remove least recently used entry
+  void Evict();
+
+  /// entries ordered by usage, most recently used first
+  entries_t mEntries;
+  /// lookup of entries by key
+  std::unordered_map<std::string, entries_t::iterator> mIndex;
+  /// all entries, random access for drawing
+  std::vector<entries_t::iterator> mSlots;
+  unsigned long mMaxSize;
+  unsigned long mSize;
+  unsigned long mNHits;
+  unsigned long mNMisses;
+  unsigned long mNEvictions;
+  std::default_random_engine mGenerator;
+};
+#endif
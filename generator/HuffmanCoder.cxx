@@ -0,0 +1,294 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   HuffmanCoder.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Canonical Huffman encoder and decoder for channel data
+
+#include "HuffmanCoder.h"
+#include "CodeLengthTable.h"
+#include <queue>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <cerrno>
+
+namespace {
+  /// bits of the ALTRO word, the bitstream is aligned to
+  const unsigned kAlignmentBits=40;
+
+  /// MSB first bit writer appending to a byte vector
+  class BitWriter {
+  public:
+    BitWriter(std::vector<unsigned char>& target)
+      : mTarget(target), mAccumulator(0), mNBits(0), mTotalBits(0) {}
+
+    /// write code of length <= 32
+    void Write(unsigned code, unsigned length) {
+      mAccumulator=(mAccumulator<<length)|code;
+      mNBits+=length;
+      mTotalBits+=length;
+      while (mNBits>=8) {
+	mNBits-=8;
+	mTarget.push_back((mAccumulator>>mNBits)&0xff);
+      }
+    }
+
+    /// pad with zeros to the alignment, return number of aligned words
+    unsigned Align() {
+      unsigned padding=(kAlignmentBits-mTotalBits%kAlignmentBits)%kAlignmentBits;
+      for (; padding>0; padding-=padding>8?8:padding) {
+	Write(0, padding>8?8:padding);
+      }
+      return mTotalBits/kAlignmentBits;
+    }
+
+  private:
+    std::vector<unsigned char>& mTarget;
+    unsigned long long mAccumulator;
+    unsigned mNBits;
+    unsigned long long mTotalBits;
+  };
+
+  void WriteWord32(std::vector<unsigned char>& target, unsigned position, unsigned value)
+  {
+    for (unsigned i=0; i<4; i++, value>>=8) target[position+i]=value&0xff;
+  }
+
+  unsigned ReadWord32(const unsigned char* source)
+  {
+    return source[0] | (source[1]<<8) | (source[2]<<16) | ((unsigned)source[3]<<24);
+  }
+}
+
+HuffmanCoder::HuffmanCoder(unsigned nSymbols)
+  : mFrequencies(nSymbols, 0)
+  , mCodeLength(nSymbols, 0)
+  , mCode(nSymbols, 0)
+  , mSortedSymbols()
+  , mFirstCode(kMaxCodeLength+1, 0)
+  , mFirstSymbol(kMaxCodeLength+1, 0)
+  , mNCodes(kMaxCodeLength+1, 0)
+  , mLookup()
+  , mMaxCodeLength(0)
+{
+}
+
+HuffmanCoder::~HuffmanCoder()
+{
+}
+
+void HuffmanCoder::AddTrainingValues(const sample_t* symbols, unsigned size)
+{
+  const unsigned nSymbols=mFrequencies.size();
+  for (unsigned i=0; i<size; i++) {
+    if (symbols[i]<nSymbols) mFrequencies[symbols[i]]++;
+  }
+}
+
+int HuffmanCoder::GenerateCode()
+{
+  const unsigned nSymbols=mFrequencies.size();
+  if (nSymbols==0) return -EINVAL;
+  // every symbol gets a code
+  std::vector<unsigned long long> frequencies(mFrequencies);
+  for (unsigned i=0; i<nSymbols; i++) frequencies[i]++;
+
+  typedef std::pair<unsigned long long, unsigned> node_t;
+  std::vector<unsigned> parent(2*nSymbols, 0);
+  std::vector<unsigned> depth(2*nSymbols, 0);
+  unsigned maxLength=0;
+  do {
+    std::priority_queue<node_t, std::vector<node_t>, std::greater<node_t> > nodes;
+    for (unsigned i=0; i<nSymbols; i++) {
+      nodes.push(node_t(frequencies[i], i));
+    }
+    unsigned nNodes=nSymbols;
+    while (nodes.size()>1) {
+      node_t first=nodes.top(); nodes.pop();
+      node_t second=nodes.top(); nodes.pop();
+      parent[first.second]=nNodes;
+      parent[second.second]=nNodes;
+      nodes.push(node_t(first.first+second.first, nNodes++));
+    }
+    // parents are created after their children, the root is the last node
+    maxLength=0;
+    depth[nNodes-1]=0;
+    for (unsigned node=nNodes-1; node-->0;) {
+      depth[node]=depth[parent[node]]+1;
+    }
+    if (nSymbols==1) depth[0]=1;
+    for (unsigned i=0; i<nSymbols; i++) {
+      if (maxLength<depth[i]) maxLength=depth[i];
+    }
+    if (maxLength>kMaxCodeLength) {
+      // flatten the distribution until the code lengths are within the limit
+      for (unsigned i=0; i<nSymbols; i++) frequencies[i]=(frequencies[i]+1)/2;
+    }
+  } while (maxLength>kMaxCodeLength);
+  for (unsigned i=0; i<nSymbols; i++) mCodeLength[i]=depth[i];
+
+  return AssignCodes();
+}
+
+int HuffmanCoder::InitCode(const CodeLengthTable& table)
+{
+  const unsigned nSymbols=mCodeLength.size();
+  for (unsigned i=0; i<nSymbols; i++) {
+    unsigned length=table.GetCodeLength(i);
+    if (length>kMaxCodeLength) return -EINVAL;
+    mCodeLength[i]=length;
+  }
+  return AssignCodes();
+}
+
+int HuffmanCoder::AssignCodes()
+{
+  const unsigned nSymbols=mCodeLength.size();
+  mMaxCodeLength=0;
+  std::fill(mNCodes.begin(), mNCodes.end(), 0);
+  for (unsigned i=0; i<nSymbols; i++) {
+    mNCodes[mCodeLength[i]]++;
+    if (mMaxCodeLength<mCodeLength[i]) mMaxCodeLength=mCodeLength[i];
+  }
+  mNCodes[0]=0;
+
+  // canonical code, shorter codes first, in order of the symbol value
+  unsigned long long code=0;
+  unsigned nCodes=0;
+  for (unsigned length=1; length<=kMaxCodeLength; length++) {
+    code=(code+mNCodes[length-1])<<1;
+    mFirstCode[length]=code;
+    mFirstSymbol[length]=nCodes;
+    nCodes+=mNCodes[length];
+    if (code+mNCodes[length]>(1ull<<length)) {
+      // not a prefix code
+      mMaxCodeLength=0;
+      return -EINVAL;
+    }
+  }
+  if (mMaxCodeLength==0) return -EINVAL;
+
+  mSortedSymbols.resize(nCodes);
+  std::vector<unsigned> nAssigned(kMaxCodeLength+1, 0);
+  for (unsigned i=0; i<nSymbols; i++) {
+    unsigned length=mCodeLength[i];
+    if (length==0) continue;
+    mCode[i]=mFirstCode[length]+nAssigned[length];
+    mSortedSymbols[mFirstSymbol[length]+nAssigned[length]]=i;
+    nAssigned[length]++;
+  }
+
+  // lookup of all symbols completely contained in the first bits
+  mLookup.resize(1<<kLookupBits);
+  for (unsigned prefix=0; prefix<mLookup.size(); prefix++) {
+    LookupEntry& entry=mLookup[prefix];
+    entry.nSymbols=0;
+    unsigned long long window=(unsigned long long)prefix<<(64-kLookupBits);
+    unsigned nBits=0;
+    while (entry.nSymbols<kMaxLookupSymbols) {
+      sample_t symbol=0;
+      unsigned length=DecodeSymbol(window, kLookupBits-nBits, symbol);
+      if (length==0) break;
+      window<<=length;
+      nBits+=length;
+      entry.symbol[entry.nSymbols]=symbol;
+      entry.nBits[entry.nSymbols]=nBits;
+      entry.nSymbols++;
+    }
+  }
+  return 0;
+}
+
+unsigned HuffmanCoder::DecodeSymbol(unsigned long long bits, unsigned nBits, sample_t& symbol) const
+{
+  if (nBits>mMaxCodeLength) nBits=mMaxCodeLength;
+  for (unsigned length=1; length<=nBits; length++) {
+    unsigned code=bits>>(64-length);
+    if (code>=mFirstCode[length] && code-mFirstCode[length]<mNCodes[length]) {
+      symbol=mSortedSymbols[mFirstSymbol[length]+code-mFirstCode[length]];
+      return length;
+    }
+  }
+  return 0;
+}
+
+int HuffmanCoder::Encode(const sample_t* symbols, unsigned size, std::vector<unsigned char>& target) const
+{
+  const unsigned nSymbols=mCodeLength.size();
+  BitWriter writer(target);
+  for (unsigned i=0; i<size; i++) {
+    unsigned symbol=symbols[i];
+    if (symbol>=nSymbols || mCodeLength[symbol]==0) return -EINVAL;
+    writer.Write(mCode[symbol], mCodeLength[symbol]);
+  }
+  return writer.Align();
+}
+
+int HuffmanCoder::Decode(const unsigned char* source, unsigned sourceSize, sample_t* symbols, unsigned size) const
+{
+  if (!IsReady()) return -EINVAL;
+  // the window holds the next bits MSB aligned, bits beyond the end of
+  // the source are zero and detected from the number of consumed bits
+  unsigned long long window=0;
+  int nAvailable=0;
+  unsigned position=0;
+  unsigned long long nConsumed=0;
+  for (unsigned i=0; i<size;) {
+    for (; nAvailable<=56 && position<sourceSize; nAvailable+=8) {
+      window|=(unsigned long long)source[position++]<<(56-nAvailable);
+    }
+    const LookupEntry& entry=mLookup[window>>(64-kLookupBits)];
+    unsigned nBits=0;
+    if (entry.nSymbols>0) {
+      unsigned n=size-i<entry.nSymbols?size-i:entry.nSymbols;
+      for (unsigned k=0; k<n; k++) symbols[i++]=entry.symbol[k];
+      nBits=entry.nBits[n-1];
+    } else {
+      nBits=DecodeSymbol(window, kMaxCodeLength, symbols[i++]);
+      if (nBits==0) return -EBADMSG;
+    }
+    window<<=nBits;
+    nAvailable-=nBits;
+    nConsumed+=nBits;
+  }
+  unsigned long long nBytes=(nConsumed+kAlignmentBits-1)/kAlignmentBits*(kAlignmentBits/8);
+  if (nBytes>sourceSize) return -ENODATA;
+  return nBytes;
+}
+
+int HuffmanCoder::EncodeChannel(unsigned index, const sample_t* symbols, unsigned size, std::vector<unsigned char>& target) const
+{
+  unsigned position=target.size();
+  target.resize(position+kChannelHeaderSize, 0);
+  int nWords=Encode(symbols, size, target);
+  if (nWords<0) {
+    target.resize(position);
+    return nWords;
+  }
+  WriteWord32(target, position, index);
+  WriteWord32(target, position+4, nWords);
+  return target.size()-position;
+}
+
+int HuffmanCoder::DecodeChannel(const unsigned char* source, unsigned sourceSize, unsigned& index, sample_t* symbols, unsigned size) const
+{
+  if (sourceSize<kChannelHeaderSize) return -ENODATA;
+  index=ReadWord32(source);
+  unsigned long long payloadSize=(unsigned long long)ReadWord32(source+4)*(kAlignmentBits/8);
+  if (payloadSize>sourceSize-kChannelHeaderSize) return -ENODATA;
+  int result=Decode(source+kChannelHeaderSize, payloadSize, symbols, size);
+  if (result<0) return result;
+  if ((unsigned)result!=payloadSize) return -EBADMSG;
+  return kChannelHeaderSize+payloadSize;
+}
@@ -0,0 +1,171 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   HuffmanCoder.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Canonical Huffman encoder and decoder for channel data
+
+#ifndef HUFFMANCODER_H
+#define HUFFMANCODER_H
+
+#include <vector>
+
+class CodeLengthTable;
+
+/**
+ * @class HuffmanCoder
+ * Canonical Huffman code with bitstream encoder and table driven decoder.
+ *
+ * The code is generated from symbol frequencies collected in training mode
+ * or from the code lengths of a CodeLengthTable, e.g. extracted from an
+ * existing Huffman table. Only the code lengths are relevant, the code
+ * words are assigned canonically in the order of length and symbol value.
+ * Code lengths are limited to kMaxCodeLength bits, the frequencies are
+ * scaled down if the generated code exceeds the limit.
+ *
+ * The bitstream is written MSB first, the encoded data of a channel is
+ * padded with zeros to a multiple of 40 bit as in the ALTRO format. A
+ * channel record consists of a header of two 32 bit little endian words,
+ * the channel index and the number of 40 bit words, followed by the
+ * bitstream.
+ *
+ * The decoder looks up kLookupBits bits of the bitstream in a table which
+ * provides up to kMaxLookupSymbols symbols completely contained in the
+ * bits. Codes exceeding the lookup width are decoded bit by bit from the
+ * canonical code.
+ *
+ * Usage:
+ * <pre>
+ *   HuffmanCoder coder;
+ *   coder.AddTrainingValues(symbols, size);
+ *   coder.GenerateCode();
+ *   coder.EncodeChannel(index, symbols, size, stream);
+ *   coder.DecodeChannel(&stream[0], stream.size(), index, symbols, size);
+ * </pre>
+ */
+class HuffmanCoder {
+ public:
+  typedef unsigned short sample_t;
+
+  /// maximum code length
+  static const unsigned kMaxCodeLength=32;
+  /// number of bits of the decoder lookup
+  static const unsigned kLookupBits=11;
+  /// maximum number of symbols decoded in one lookup
+  static const unsigned kMaxLookupSymbols=4;
+  /// size of the channel header in bytes
+  static const unsigned kChannelHeaderSize=8;
+
+  /// constructor
+  HuffmanCoder(unsigned nSymbols=2048);
+  /// destructor
+  ~HuffmanCoder();
+
+  /// add symbols to the training frequencies, symbols outside the alphabet are ignored
+  void AddTrainingValues(const sample_t* symbols, unsigned size);
+
+  /**
+   * Generate the code from the training frequencies.
+   * Every symbol of the alphabet gets a code, symbols not seen in training
+   * mode are treated as occurring once.
+   * @return 0 on success, negative error code if failed
+   */
+  int GenerateCode();
+
+  /**
+   * Init the code from the code lengths of a table.
+   * Symbols with code length 0 can not be encoded.
+   * @return 0 on success, -EINVAL if the lengths do not form a prefix code
+   */
+  int InitCode(const CodeLengthTable& table);
+
+  /// check if a code is available
+  bool IsReady() const {return mMaxCodeLength>0;}
+
+  /// size of the alphabet
+  unsigned GetNSymbols() const {return mCodeLength.size();}
+
+  /// code length of a symbol, 0 if not encodable
+  unsigned GetCodeLength(unsigned symbol) const {
+    return symbol<mCodeLength.size()?mCodeLength[symbol]:0;
+  }
+
+  /**
+   * Encode symbols and append the bitstream, padded to 40 bit words.
+   * @return number of 40 bit words, -EINVAL if a symbol has no code
+   */
+  int Encode(const sample_t* symbols, unsigned size, std::vector<unsigned char>& target) const;
+
+  /**
+   * Decode a number of symbols from the bitstream.
+   * @return number of bytes consumed, multiple of 5,
+   *         -ENODATA if the bitstream is too short,
+   *         -EBADMSG if the bitstream contains an invalid code
+   */
+  int Decode(const unsigned char* source, unsigned sourceSize, sample_t* symbols, unsigned size) const;
+
+  /**
+   * Encode symbols of a channel and append the channel record.
+   * @return number of bytes appended, negative error code if failed
+   */
+  int EncodeChannel(unsigned index, const sample_t* symbols, unsigned size, std::vector<unsigned char>& target) const;
+
+  /**
+   * Decode a channel record.
+   * @return number of bytes consumed, negative error code if failed
+   */
+  int DecodeChannel(const unsigned char* source, unsigned sourceSize, unsigned& index, sample_t* symbols, unsigned size) const;
+
+ private:
+  /// copy constructor prohibited
+  HuffmanCoder(const HuffmanCoder&);
+  /// assignment operator prohibited
+  HuffmanCoder& operator=(const HuffmanCoder&);
+
+  /// assign canonical code words from the code lengths and build the decoder tables
+  int AssignCodes();
+  /// decode one symbol bit by bit, return code length or 0 if invalid
+  unsigned DecodeSymbol(unsigned long long bits, unsigned nBits, sample_t& symbol) const;
+
+  /// entry of the decoder lookup table
+  struct LookupEntry {
+    /// decoded symbols
+    sample_t symbol[kMaxLookupSymbols];
+    /// number of bits consumed after each symbol
+    unsigned char nBits[kMaxLookupSymbols];
+    /// number of symbols
+    unsigned char nSymbols;
+  };
+
+  /// training frequencies
+  std::vector<unsigned long long> mFrequencies;
+  /// code length of the symbols
+  std::vector<unsigned char> mCodeLength;
+  /// code words of the symbols
+  std::vector<unsigned int> mCode;
+  /// symbols sorted by code length and value
+  std::vector<sample_t> mSortedSymbols;
+  /// first code word of each length
+  std::vector<unsigned int> mFirstCode;
+  /// index of the first symbol of each length in the sorted symbols
+  std::vector<unsigned int> mFirstSymbol;
+  /// number of symbols of each length
+  std::vector<unsigned int> mNCodes;
+  /// decoder lookup table
+  std::vector<LookupEntry> mLookup;
+  /// maximum code length, 0 if no code available
+  unsigned mMaxCodeLength;
+};
+#endif
@@ -0,0 +1,129 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   InputPrefetcher.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Opening of input files in a background thread
+//  @note   requires C++11 standard
+
+#include "InputPrefetcher.h"
+#include "ChannelSource.h"
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cerrno>
+
+struct InputPrefetcher::Context {
+  /// prefetched input
+  struct Entry {
+    std::string name;
+    ChannelSource* source;
+    int eventResult;
+  };
+
+  Context(std::istream& _inputfiles, unsigned _depth, bool _readAhead)
+    : inputfiles(_inputfiles), depth(_depth>0?_depth:1), readAhead(_readAhead)
+    , queue(), thread(), mutex(), changed(), finished(false), stop(false)
+  {}
+
+  /// stream of file names
+  std::istream& inputfiles;
+  /// max number of prefetched inputs
+  unsigned depth;
+  /// read the first event
+  bool readAhead;
+  /// prefetched inputs
+  std::deque<Entry> queue;
+  /// the background thread
+  std::thread thread;
+  /// protection of queue and state
+  std::mutex mutex;
+  /// signals change of queue or state
+  std::condition_variable changed;
+  /// end of the file list reached
+  bool finished;
+  /// stop the background thread
+  bool stop;
+};
+
+InputPrefetcher::InputPrefetcher(std::istream& inputfiles, unsigned depth, bool readAhead)
+  : mContext(new Context(inputfiles, depth, readAhead))
+{
+  mContext->thread=std::thread(&InputPrefetcher::Prefetch, this);
+}
+
+InputPrefetcher::~InputPrefetcher()
+{
+  {
+    std::lock_guard<std::mutex> lock(mContext->mutex);
+    mContext->stop=true;
+  }
+  mContext->changed.notify_all();
+  mContext->thread.join();
+  for (std::deque<Context::Entry>::iterator entry=mContext->queue.begin();
+       entry!=mContext->queue.end(); entry++) {
+    if (entry->source) delete entry->source;
+  }
+  delete mContext;
+  mContext=NULL;
+}
+
+const std::istream& InputPrefetcher::GetStream() const
+{
+  return mContext->inputfiles;
+}
+
+int InputPrefetcher::Next(std::string& name, ChannelSource*& source, int& eventResult)
+{
+  std::unique_lock<std::mutex> lock(mContext->mutex);
+  mContext->changed.wait(lock, [this] {return !mContext->queue.empty() || mContext->finished;});
+  if (mContext->queue.empty()) return 0;
+  name=mContext->queue.front().name;
+  source=mContext->queue.front().source;
+  eventResult=mContext->queue.front().eventResult;
+  mContext->queue.pop_front();
+  lock.unlock();
+  mContext->changed.notify_all();
+  return 1;
+}
+
+void InputPrefetcher::Prefetch()
+{
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mContext->mutex);
+      mContext->changed.wait(lock, [this] {return mContext->queue.size()<mContext->depth || mContext->stop;});
+      if (mContext->stop) break;
+    }
+    // the stream is only accessed by this thread
+    Context::Entry entry;
+    std::getline(mContext->inputfiles, entry.name);
+    if (!mContext->inputfiles.good()) break;
+    entry.source=ChannelSource::Create(entry.name.c_str());
+    entry.eventResult=-ENODATA;
+    if (entry.source && mContext->readAhead) {
+      entry.eventResult=entry.source->NextEvent();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mContext->mutex);
+      mContext->queue.push_back(entry);
+    }
+    mContext->changed.notify_all();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mContext->mutex);
+    mContext->finished=true;
+  }
+  mContext->changed.notify_all();
+}
@@ -0,0 +1,88 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   InputPrefetcher.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Opening of input files in a background thread
+
+#ifndef INPUTPREFETCHER_H
+#define INPUTPREFETCHER_H
+
+#include <iostream>
+#include <string>
+
+class ChannelSource;
+
+/**
+ * @class InputPrefetcher
+ * Open the next input files of a file list in a background thread.
+ *
+ * The file names are read from the stream by the background thread, which
+ * creates the channel sources and optionally reads the first event. Up to
+ * a configurable number of opened sources are kept ready, opening the next
+ * file does not stall the merging. From the creation of the prefetcher on,
+ * the stream is only read by the background thread.
+ *
+ * The stream has to provide an end, e.g. a file, the thread keeps waiting
+ * for input otherwise and the destructor blocks.
+ *
+ * The class does not use C++11 features in the header and can be used in
+ * macros, the thread is created in the implementation.
+ */
+class InputPrefetcher {
+ public:
+  /**
+   * Constructor
+   * @param inputfiles  stream with one file name per line
+   * @param depth       number of files opened in advance, at least 1
+   * @param readAhead   read the first event of the prefetched files
+   */
+  InputPrefetcher(std::istream& inputfiles, unsigned depth=1, bool readAhead=true);
+  /// destructor, the prefetched sources not yet taken are deleted
+  ~InputPrefetcher();
+
+  /// the stream of file names
+  const std::istream& GetStream() const;
+
+  /**
+   * Get the next prefetched source, waits for the background thread.
+   * The first event has been read if readAhead is set, i.e. the source
+   * is positioned at the first event.
+   * @param name        receives the name of the input
+   * @param source      receives the source, NULL if it could not be opened,
+   *                    ownership is passed to the caller
+   * @param eventResult receives the result of NextEvent if read ahead,
+   *                    -ENODATA if not read
+   * @return 1 if an input is available, 0 if no more input
+   */
+  int Next(std::string& name, ChannelSource*& source, int& eventResult);
+
+ private:
+  /// standard constructor prohibited
+  InputPrefetcher();
+  /// copy constructor prohibited
+  InputPrefetcher(const InputPrefetcher&);
+  /// assignment operator prohibited
+  InputPrefetcher& operator=(const InputPrefetcher&);
+
+  /// thread and queue, implementation uses C++11
+  struct Context;
+
+  /// loop of the background thread
+  void Prefetch();
+
+  Context* mContext;
+};
+#endif
@@ -0,0 +1,287 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   PedestalEstimator.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Online estimation of pedestal and noise per channel
+
+#include "PedestalEstimator.h"
+#include "ChannelSource.h"
+#include "DecodedEvent.h"
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+
+PedestalEstimator::PedestalEstimator(unsigned medianRange)
+  : mMedianRange(medianRange)
+  , mDDLs()
+  , mHistograms()
+  , mNEvents(0)
+{
+}
+
+PedestalEstimator::~PedestalEstimator()
+{
+  for (std::vector<ChannelStatistics*>::iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl) delete [] *ddl;
+  }
+  for (std::vector<unsigned*>::iterator histogram=mHistograms.begin();
+       histogram!=mHistograms.end(); histogram++) {
+    if (*histogram) delete [] *histogram;
+  }
+}
+
+PedestalEstimator::ChannelStatistics* PedestalEstimator::GetStatistics(unsigned index)
+{
+  unsigned DDLNumber=index>>16;
+  unsigned HWAddress=index&0xffff;
+  if (HWAddress>=kNChannelsPerDDL) return NULL;
+  if (DDLNumber>=mDDLs.size()) {
+    mDDLs.resize(DDLNumber+1, NULL);
+    mHistograms.resize(DDLNumber+1, NULL);
+  }
+  if (mDDLs[DDLNumber]==NULL) {
+    mDDLs[DDLNumber]=new ChannelStatistics[kNChannelsPerDDL];
+    memset(mDDLs[DDLNumber], 0, kNChannelsPerDDL*sizeof(ChannelStatistics));
+    if (mMedianRange>0) {
+      mHistograms[DDLNumber]=new unsigned[kNChannelsPerDDL*mMedianRange];
+      memset(mHistograms[DDLNumber], 0, kNChannelsPerDDL*mMedianRange*sizeof(unsigned));
+    }
+  }
+  return mDDLs[DDLNumber]+HWAddress;
+}
+
+const PedestalEstimator::ChannelStatistics* PedestalEstimator::FindStatistics(unsigned index) const
+{
+  unsigned DDLNumber=index>>16;
+  unsigned HWAddress=index&0xffff;
+  if (HWAddress>=kNChannelsPerDDL || DDLNumber>=mDDLs.size() || mDDLs[DDLNumber]==NULL) return NULL;
+  const ChannelStatistics* statistics=mDDLs[DDLNumber]+HWAddress;
+  return statistics->nSamples>0?statistics:NULL;
+}
+
+void PedestalEstimator::Add(unsigned index, const unsigned short* signals, unsigned size)
+{
+  if (size==0 || signals==NULL) return;
+  ChannelStatistics* statistics=GetStatistics(index);
+  if (statistics==NULL) return;
+
+  // exact integer sums of the bunch, combined with the running statistics
+  // of the channel by the pairwise update
+  unsigned long long sum=0;
+  unsigned long long sumOfSquares=0;
+  unsigned short minSignal=signals[0];
+  unsigned short maxSignal=signals[0];
+  for (unsigned i=0; i<size; i++) {
+    unsigned signal=signals[i];
+    sum+=signal;
+    sumOfSquares+=signal*signal;
+    if (minSignal>signal) minSignal=signal;
+    if (maxSignal<signal) maxSignal=signal;
+  }
+  double bunchMean=(double)sum/size;
+  double bunchM2=(double)(size*sumOfSquares-sum*sum)/size;
+  if (statistics->nSamples==0) {
+    statistics->minSignal=minSignal;
+    statistics->maxSignal=maxSignal;
+    statistics->mean=bunchMean;
+    statistics->m2=bunchM2;
+  } else {
+    if (statistics->minSignal>minSignal) statistics->minSignal=minSignal;
+    if (statistics->maxSignal<maxSignal) statistics->maxSignal=maxSignal;
+    double n=statistics->nSamples+size;
+    double delta=bunchMean-statistics->mean;
+    statistics->mean+=delta*size/n;
+    statistics->m2+=bunchM2+delta*delta*statistics->nSamples*size/n;
+  }
+  statistics->nSamples+=size;
+  statistics->nBunches++;
+
+  if (mMedianRange>0) {
+    unsigned* histogram=mHistograms[index>>16]+(index&0xffff)*mMedianRange;
+    for (unsigned i=0; i<size; i++) {
+      histogram[signals[i]<mMedianRange?signals[i]:mMedianRange-1]++;
+    }
+  }
+}
+
+int PedestalEstimator::AddEvent(ChannelSource& source)
+{
+  int nChannels=0;
+  while (source.NextDDL()) {
+    unsigned DDLNumber=source.GetDDLNumber();
+    while (source.NextChannel()) {
+      if (source.IsChannelBad()) continue;
+      unsigned HWAddress=source.GetHWAddress();
+      if (HWAddress>=kNChannelsPerDDL) continue;
+      unsigned index=DDLNumber<<16 | HWAddress;
+      while (source.NextBunch()) {
+	Add(index, source.GetSignals(), source.GetBunchLength());
+      }
+      nChannels++;
+    }
+  }
+  mNEvents++;
+  return nChannels;
+}
+
+int PedestalEstimator::AddEvent(const DecodedEvent& event, unsigned minDDL, unsigned maxDDL)
+{
+  int nChannels=0;
+  for (unsigned channel=0; channel<event.GetNChannels(); channel++) {
+    unsigned index=event.GetChannelIndex(channel);
+    if ((index>>16)<minDDL || (index>>16)>maxDDL) continue;
+    unsigned size=0;
+    const DecodedEvent::sample_t* data=event.GetChannelData(channel, size);
+    // bunches: startTime length signal[0] ... signal[length-1]
+    for (unsigned position=0; position+2<=size; position+=2+data[position+1]) {
+      Add(index, data+position+2, data[position+1]);
+    }
+    nChannels++;
+  }
+  mNEvents++;
+  return nChannels;
+}
+
+unsigned PedestalEstimator::GetNChannels() const
+{
+  unsigned nChannels=0;
+  for (std::vector<ChannelStatistics*>::const_iterator ddl=mDDLs.begin();
+       ddl!=mDDLs.end(); ddl++) {
+    if (*ddl==NULL) continue;
+    for (unsigned i=0; i<kNChannelsPerDDL; i++) {
+      if ((*ddl)[i].nSamples>0) nChannels++;
+    }
+  }
+  return nChannels;
+}
+
+unsigned PedestalEstimator::GetNSamples(unsigned index) const
+{
+  const ChannelStatistics* statistics=FindStatistics(index);
+  return statistics?statistics->nSamples:0;
+}
+
+double PedestalEstimator::GetMean(unsigned index) const
+{
+  const ChannelStatistics* statistics=FindStatistics(index);
+  return statistics?statistics->mean:0.;
+}
+
+double PedestalEstimator::GetRMS(unsigned index) const
+{
+  const ChannelStatistics* statistics=FindStatistics(index);
+  if (statistics==NULL || statistics->m2<=0.) return 0.;
+  return sqrt(statistics->m2/statistics->nSamples);
+}
+
+int PedestalEstimator::GetMedian(unsigned index) const
+{
+  if (mMedianRange==0) return -1;
+  const ChannelStatistics* statistics=FindStatistics(index);
+  if (statistics==NULL) return -1;
+  const unsigned* histogram=mHistograms[index>>16]+(index&0xffff)*mMedianRange;
+  unsigned long count=0;
+  for (unsigned bin=0; bin<mMedianRange; bin++) {
+    count+=histogram[bin];
+    if (2*count>=statistics->nSamples) return bin;
+  }
+  return mMedianRange-1;
+}
+
+int PedestalEstimator::GetPedestal(unsigned index) const
+{
+  if (FindStatistics(index)==NULL) return -1;
+  if (mMedianRange>0) return GetMedian(index);
+  return (int)floor(GetMean(index)+.5);
+}
+
+int PedestalEstimator::Write(const char* filename) const
+{
+  std::ofstream output(filename);
+  if (!output.good()) {
+    std::cerr << "can not open file '" << filename << "' for writing" << std::endl;
+    return -EIO;
+  }
+  int result=Write(output);
+  if (result>=0) {
+    std::cout << "wrote pedestal configuration of " << result << " channel(s) to file " << filename << std::endl;
+  }
+  return result;
+}
+
+int PedestalEstimator::Write(std::ostream& out) const
+{
+  int nChannels=0;
+  for (unsigned DDLNumber=0; DDLNumber<mDDLs.size(); DDLNumber++) {
+    if (mDDLs[DDLNumber]==NULL) continue;
+    for (unsigned HWAddress=0; HWAddress<kNChannelsPerDDL; HWAddress++) {
+      const ChannelStatistics& statistics=mDDLs[DDLNumber][HWAddress];
+      if (statistics.nSamples==0) continue;
+      unsigned index=DDLNumber<<16 | HWAddress;
+      // the columns are separated explicitly, the number of samples and
+      // bunches of many events exceeds the field width
+      out << std::setw(3) << DDLNumber
+	  << " " << std::setw(5) << HWAddress
+	  << " " << std::setw(5) << GetPedestal(index)
+	  << " " << std::setw(5) << statistics.minSignal
+	  << " " << std::setw(5) << statistics.maxSignal
+	  << " " << std::setw(9) << statistics.nSamples
+	  << " " << std::setw(7) << statistics.nBunches
+	  << " " << std::setw(7) << std::fixed << std::setprecision(2) << GetRMS(index)
+	  << std::endl;
+      nChannels++;
+    }
+  }
+  if (!out.good()) return -EIO;
+  return nChannels;
+}
+
+void PedestalEstimator::Print() const
+{
+  unsigned nChannels=0;
+  double sumOfRMS=0.;
+  for (unsigned DDLNumber=0; DDLNumber<mDDLs.size(); DDLNumber++) {
+    if (mDDLs[DDLNumber]==NULL) continue;
+    for (unsigned HWAddress=0; HWAddress<kNChannelsPerDDL; HWAddress++) {
+      if (mDDLs[DDLNumber][HWAddress].nSamples==0) continue;
+      nChannels++;
+      sumOfRMS+=GetRMS(DDLNumber<<16 | HWAddress);
+    }
+  }
+  std::cout << "pedestal estimation: " << mNEvents << " event(s), "
+	    << nChannels << " channel(s)";
+  if (nChannels>0) {
+    std::cout << ", avrg noise " << sumOfRMS/nChannels;
+  }
+  if (mMedianRange>0) {
+    std::cout << ", pedestal from median of " << mMedianRange << " bins";
+  }
+  std::cout << std::endl;
+}
+
+void PedestalEstimator::Reset()
+{
+  for (unsigned DDLNumber=0; DDLNumber<mDDLs.size(); DDLNumber++) {
+    if (mDDLs[DDLNumber]) {
+      memset(mDDLs[DDLNumber], 0, kNChannelsPerDDL*sizeof(ChannelStatistics));
+    }
+    if (mHistograms[DDLNumber]) {
+      memset(mHistograms[DDLNumber], 0, kNChannelsPerDDL*mMedianRange*sizeof(unsigned));
+    }
+  }
+  mNEvents=0;
+}
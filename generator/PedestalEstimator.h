@@ -0,0 +1,169 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   PedestalEstimator.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Online estimation of pedestal and noise per channel
+
+#ifndef PEDESTALESTIMATOR_H
+#define PEDESTALESTIMATOR_H
+#include <vector>
+#include <iostream>
+
+class ChannelSource;
+class DecodedEvent;
+
+/**
+ * @class PedestalEstimator
+ * Streaming estimation of pedestal and noise of the TPC channels.
+ *
+ * The signals of black events are added bunch by bunch while reading the
+ * events, no sample buffers are required. For every channel the mean and
+ * the variance are updated online with Welford's algorithm, the bunches
+ * are combined with the running statistics by the pairwise update of Chan
+ * et al. Optionally, the signals are filled in a histogram per channel
+ * to provide the median, which is less sensitive to remaining signals of
+ * particles. Signals above the histogram range are counted in the last
+ * bin.
+ *
+ * The memory is allocated per DDL when the first channel of the DDL is
+ * added and does not depend on the number of events. Without median,
+ * one DDL requires 128 kB, the histogram adds 4 byte per bin and
+ * channel, i.e. 16 MB per DDL for the 10 bit ADC range.
+ *
+ * The result is written in the format of the pedestal configuration, see
+ * ChannelMerger::InitChannelBaseline:
+ * <pre>
+ * <ddlno> <hwaddress> <pedestal> <min> <max> <#samples> <#bunches> <rms>
+ * </pre>
+ */
+class PedestalEstimator {
+ public:
+  /**
+   * Constructor
+   * @param medianRange   number of histogram bins for the median, 0 to
+   *                      disable, e.g. 1024 for the 10 bit ADC range
+   */
+  PedestalEstimator(unsigned medianRange=0);
+  /// destructor
+  ~PedestalEstimator();
+
+  enum {
+    kNChannelsPerDDL=4096
+  };
+
+  /**
+   * Add signals of a channel.
+   * @param index     channel index composed out of DDL number and HW address
+   * @param signals   signal array
+   * @param size      number of signals
+   */
+  void Add(unsigned index, const unsigned short* signals, unsigned size);
+
+  /**
+   * Add all bunches of the current event of a source.
+   * The event has to be positioned by NextEvent, the DDL range is applied
+   * as selected in the source.
+   * @return number of channels
+   */
+  int AddEvent(ChannelSource& source);
+
+  /**
+   * Add all bunches of a decoded event.
+   * @param event    decoded event
+   * @param minDDL   first DDL to be added
+   * @param maxDDL   last DDL to be added
+   * @return number of channels
+   */
+  int AddEvent(const DecodedEvent& event, unsigned minDDL=0, unsigned maxDDL=~0u);
+
+  /// number of added events
+  unsigned GetNEvents() const {return mNEvents;}
+
+  /// number of channels with signals
+  unsigned GetNChannels() const;
+
+  /// number of samples of a channel
+  unsigned GetNSamples(unsigned index) const;
+
+  /// mean signal of a channel, 0 if no signals
+  double GetMean(unsigned index) const;
+
+  /// standard deviation of the signals of a channel, 0 if no signals
+  double GetRMS(unsigned index) const;
+
+  /// median of the signals of a channel, -1 if median disabled or no signals
+  int GetMedian(unsigned index) const;
+
+  /**
+   * Pedestal of a channel, the median if enabled, the rounded mean
+   * otherwise.
+   * @return pedestal, -1 if no signals
+   */
+  int GetPedestal(unsigned index) const;
+
+  /**
+   * Write the pedestal configuration.
+   * @return number of channels, negative error code if failed
+   */
+  int Write(const char* filename) const;
+
+  /// write the pedestal configuration to a stream
+  int Write(std::ostream& out) const;
+
+  /// print a summary
+  void Print() const;
+
+  /// reset all statistics, the memory is kept
+  void Reset();
+
+ private:
+  /// copy constructor prohibited
+  PedestalEstimator(const PedestalEstimator&);
+  /// assignment operator prohibited
+  PedestalEstimator& operator=(const PedestalEstimator&);
+
+  /// running statistics of a channel
+  struct ChannelStatistics {
+    /// number of samples
+    unsigned nSamples;
+    /// number of bunches
+    unsigned nBunches;
+    /// minimum signal
+    unsigned short minSignal;
+    /// maximum signal
+    unsigned short maxSignal;
+    /// mean of the signals
+    double mean;
+    /// sum of squared differences from the mean
+    double m2;
+  };
+
+  /// statistics of a channel, allocated for the DDL if not existing
+  ChannelStatistics* GetStatistics(unsigned index);
+
+  /// statistics of a channel, NULL if not existing
+  const ChannelStatistics* FindStatistics(unsigned index) const;
+
+  /// number of histogram bins
+  unsigned mMedianRange;
+  /// statistics of all channels, indexed by DDL number
+  std::vector<ChannelStatistics*> mDDLs;
+  /// histograms of all channels, indexed by DDL number
+  std::vector<unsigned*> mHistograms;
+  /// number of added events
+  unsigned mNEvents;
+};
+#endif
@@ -0,0 +1,65 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   RandomGenerator.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Fast random generator with explicit seeding and independent streams
+
+#include "RandomGenerator.h"
+#include <cmath>
+
+RandomGenerator::RandomGenerator(unsigned long long seed, unsigned stream)
+{
+  Seed(seed, stream);
+}
+
+RandomGenerator::~RandomGenerator()
+{
+}
+
+void RandomGenerator::Seed(unsigned long long seed, unsigned stream)
+{
+  // SplitMix64 fills the state, never all zero
+  unsigned long long x=seed;
+  for (int i=0; i<4; i++) {
+    unsigned long long z=(x+=0x9e3779b97f4a7c15ULL);
+    z=(z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+    z=(z^(z>>27))*0x94d049bb133111ebULL;
+    mState[i]=z^(z>>31);
+  }
+  for (unsigned i=0; i<stream; i++) Jump();
+}
+
+void RandomGenerator::Jump()
+{
+  static const unsigned long long kJump[]={
+    0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+    0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+  };
+  unsigned long long state[4]={0, 0, 0, 0};
+  for (int i=0; i<4; i++) {
+    for (int b=0; b<64; b++) {
+      if (kJump[i] & 1ULL<<b) {
+	for (int k=0; k<4; k++) state[k]^=mState[k];
+      }
+      Next();
+    }
+  }
+  for (int k=0; k<4; k++) mState[k]=state[k];
+}
+
+float RandomGenerator::Exponential(float rate)
+{
+  // inversion of the distribution, 1-u is in the range (0,1]
+  return -std::log(1.f-UniformFloat())/rate;
+}
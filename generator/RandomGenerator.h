@@ -0,0 +1,92 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   RandomGenerator.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Fast random generator with explicit seeding and independent streams
+
+#ifndef RANDOMGENERATOR_H
+#define RANDOMGENERATOR_H
+
+/**
+ * @class RandomGenerator
+ * Pseudo random generator xoshiro256** by Blackman and Vigna.
+ *
+ * The state of 256 bit is initialized from a 64 bit seed with SplitMix64.
+ * A generator is seeded with a seed and a stream number, the streams of one
+ * seed are separated by 2^128 numbers by the jump function of the
+ * algorithm and do not overlap. Every thread, or every unit of work which
+ * has to be reproducible independently of the thread processing it, uses
+ * its own generator and no locking is required.
+ *
+ * The generator has no global state, the sequence only depends on seed and
+ * stream.
+ */
+class RandomGenerator {
+ public:
+  /**
+   * Constructor
+   * @param seed      seed of the sequence
+   * @param stream    number of the independent stream of the seed
+   */
+  RandomGenerator(unsigned long long seed=0, unsigned stream=0);
+  /// destructor
+  ~RandomGenerator();
+
+  /**
+   * Seed the generator.
+   * The stream is selected by jumping from the start of the sequence, the
+   * cost scales with the stream number.
+   */
+  void Seed(unsigned long long seed, unsigned stream=0);
+
+  /// advance by 2^128 numbers, i.e. to the start of the next stream
+  void Jump();
+
+  /// next 64 bit random number
+  unsigned long long Next() {
+    const unsigned long long result=Rotl(mState[1]*5, 7)*9;
+    const unsigned long long t=mState[1]<<17;
+    mState[2]^=mState[0];
+    mState[3]^=mState[1];
+    mState[1]^=mState[2];
+    mState[0]^=mState[3];
+    mState[2]^=t;
+    mState[3]=Rotl(mState[3], 45);
+    return result;
+  }
+
+  /// random number in the range 0 <= number < range, multiply-shift method
+  unsigned Uniform(unsigned range) {
+    return (unsigned)(((Next()>>32)*range)>>32);
+  }
+
+  /// random number in the range 0 <= number < 1 with 24 bit precision
+  float UniformFloat() {
+    return (Next()>>40)*(1.f/16777216.f);
+  }
+
+  /// random number following the exponential distribution with mean 1/rate
+  float Exponential(float rate);
+
+ private:
+  static unsigned long long Rotl(unsigned long long x, int k) {
+    return (x<<k) | (x>>(64-k));
+  }
+
+  /// state of the generator
+  unsigned long long mState[4];
+};
+#endif
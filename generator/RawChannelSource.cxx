@@ -0,0 +1,180 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   RawChannelSource.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Channel source reading TPC raw data
+//  @note   requires AliRoot
+
+#include "RawChannelSource.h"
+#include "AliAltroRawStreamV3.h"
+#include "AliRawReader.h"
+#include "TString.h"
+#include "TGrid.h"
+#include "TROOT.h"
+#include "RVersion.h"
+#include <cerrno>
+#ifndef __CINT__
+#include <mutex>
+#endif
+
+namespace {
+  // register the factory when the library is loaded
+  struct RawChannelSourceRegistration {
+    RawChannelSourceRegistration() {
+      ChannelSource::RegisterFactory(RawChannelSource::Create);
+    }
+  } gRawChannelSourceRegistration;
+
+#ifndef __CINT__
+  // sources are opened by the input prefetcher and the merging threads, the
+  // grid connection and the creation of the ROOT objects are serialized
+  std::mutex gOpenMutex;
+#endif
+}
+
+RawChannelSource::RawChannelSource()
+  : ChannelSource()
+  , mRawReader(NULL)
+  , mInputStream(NULL)
+  , mMinDDL(-1)
+  , mMaxDDL(-1)
+{
+}
+
+RawChannelSource::~RawChannelSource()
+{
+  if (mInputStream) delete mInputStream;
+  if (mRawReader) delete mRawReader;
+}
+
+ChannelSource* RawChannelSource::Create(const char* name)
+{
+  RawChannelSource* source=new RawChannelSource;
+  if (source->Open(name)<0) {
+    delete source;
+    return NULL;
+  }
+  return source;
+}
+
+int RawChannelSource::Open(const char* filename)
+{
+  if (mInputStream) delete mInputStream;
+  if (mRawReader) delete mRawReader;
+  mInputStream=NULL;
+  mRawReader=NULL;
+  TString line(filename);
+#ifndef __CINT__
+  std::lock_guard<std::mutex> lock(gOpenMutex);
+#endif
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+  // the readers of different sources are used concurrently
+  static bool bThreadSafety=false;
+  if (!bThreadSafety) {
+    ROOT::EnableThreadSafety();
+    bThreadSafety=true;
+  }
+#endif
+  static TGrid* pGrid=NULL;
+  if (pGrid==NULL && line.BeginsWith("alien://")) {
+    pGrid=TGrid::Connect("alien");
+    if (!pGrid) return -ENOENT;
+  }
+  mRawReader=AliRawReader::Create(line);
+  if (!mRawReader) return -ENOENT;
+  mInputStream=new AliAltroRawStreamV3(mRawReader);
+  if (!mInputStream) return -ENOMEM;
+  SetName(filename);
+  mRawReader->RewindEvents();
+  return 0;
+}
+
+int RawChannelSource::NextEvent()
+{
+  if (mRawReader==NULL || !mRawReader->NextEvent()) return 0;
+  return 1;
+}
+
+int RawChannelSource::GotoEvent(int eventIndex)
+{
+  if (mRawReader==NULL || !mRawReader->GotoEvent(eventIndex)) return -ENODATA;
+  return 0;
+}
+
+int RawChannelSource::GetEventIndex() const
+{
+  return mRawReader?mRawReader->GetEventIndex():-1;
+}
+
+void RawChannelSource::SelectDDLRange(int minDDL, int maxDDL)
+{
+  mMinDDL=minDDL;
+  mMaxDDL=maxDDL;
+  mInputStream->Reset();
+  if (mMinDDL>=0 && mMaxDDL>=0) {
+    mRawReader->Select("TPC", mMinDDL, mMaxDDL);
+  } else {
+    mInputStream->SelectRawData("TPC");
+  }
+}
+
+bool RawChannelSource::NextDDL()
+{
+  return mInputStream->NextDDL();
+}
+
+unsigned RawChannelSource::GetDDLNumber() const
+{
+  return mInputStream->GetDDLNumber();
+}
+
+bool RawChannelSource::NextChannel()
+{
+  return mInputStream->NextChannel();
+}
+
+unsigned RawChannelSource::GetHWAddress() const
+{
+  return mInputStream->GetHWAddress();
+}
+
+bool RawChannelSource::IsChannelBad() const
+{
+  return mInputStream->IsChannelBad();
+}
+
+bool RawChannelSource::NextBunch()
+{
+  return mInputStream->NextBunch();
+}
+
+int RawChannelSource::GetStartTimeBin() const
+{
+  return mInputStream->GetStartTimeBin();
+}
+
+int RawChannelSource::GetBunchLength() const
+{
+  return mInputStream->GetBunchLength();
+}
+
+const unsigned short* RawChannelSource::GetSignals() const
+{
+  return mInputStream->GetSignals();
+}
+
+ChannelSource* RawChannelSource::Clone() const
+{
+  return Create(GetName().c_str());
+}
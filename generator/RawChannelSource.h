@@ -0,0 +1,78 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   RawChannelSource.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Channel source reading TPC raw data
+//  @note   requires AliRoot
+
+#ifndef RAWCHANNELSOURCE_H
+#define RAWCHANNELSOURCE_H
+
+#include "ChannelSource.h"
+
+class AliRawReader;
+class AliAltroRawStreamV3;
+
+/**
+ * @class RawChannelSource
+ * Channel source for TPC raw data files read with AliRawReader and
+ * decoded by AliAltroRawStreamV3.
+ *
+ * Files on alien are supported, the grid connection is opened when the
+ * first alien file is accessed. The factory for this source is registered
+ * in ChannelSource when the library is loaded, it handles all names not
+ * handled by other sources.
+ */
+class RawChannelSource : public ChannelSource {
+ public:
+  RawChannelSource();
+  ~RawChannelSource();
+
+  /**
+   * Open raw data file and rewind to before first event.
+   * @return 0 on success, negative error code if failed
+   */
+  int Open(const char* filename);
+
+  int NextEvent();
+  int GotoEvent(int eventIndex);
+  int GetEventIndex() const;
+  void SelectDDLRange(int minDDL, int maxDDL);
+  bool NextDDL();
+  unsigned GetDDLNumber() const;
+  bool NextChannel();
+  unsigned GetHWAddress() const;
+  bool IsChannelBad() const;
+  bool NextBunch();
+  int GetStartTimeBin() const;
+  int GetBunchLength() const;
+  const unsigned short* GetSignals() const;
+  ChannelSource* Clone() const;
+
+  /// factory function registered in ChannelSource
+  static ChannelSource* Create(const char* name);
+
+ private:
+  /// general interface to data
+  AliRawReader* mRawReader;
+  /// interface to TPC data
+  AliAltroRawStreamV3* mInputStream;
+  /// min DDL number
+  int mMinDDL;
+  /// max DDL number
+  int mMaxDDL;
+};
+#endif
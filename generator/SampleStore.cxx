@@ -0,0 +1,162 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   SampleStore.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Sparse storage of channel samples
+
+#include "SampleStore.h"
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+template<typename SampleT> const typename SampleStoreT<SampleT>::sample_t SampleStoreT<SampleT>::kVoidSample;
+template<typename SampleT> const unsigned SampleStoreT<SampleT>::kBlockLength;
+template<typename SampleT> const unsigned SampleStoreT<SampleT>::kBlocksPerChunk;
+template<typename SampleT> const unsigned SampleStoreT<SampleT>::kNoBlock;
+
+template<typename SampleT>
+SampleStoreT<SampleT>::SampleStoreT(unsigned channelLength)
+  : mChannelLength(channelLength)
+  , mNBlocksPerChannel((channelLength+kBlockLength-1)/kBlockLength)
+  , mNChannels(0)
+  , mBlockIndex()
+  , mChunks()
+  , mReserved(NULL)
+  , mNReservedSlots(0)
+  , mNReservedChunks(0)
+  , mNextBlock(0)
+  , mNUsedBlocks(0)
+  , mDirtyFlags()
+  , mDirtyChannels()
+{
+}
+
+template<typename SampleT>
+SampleStoreT<SampleT>::~SampleStoreT()
+{
+  // the leading chunks point into the reserved memory
+  for (typename std::vector<sample_t*>::iterator chunk=mChunks.begin()+mNReservedChunks;
+       chunk!=mChunks.end(); chunk++) {
+    delete [] *chunk;
+  }
+  mChunks.clear();
+  if (mReserved) delete [] mReserved;
+  mReserved=NULL;
+}
+
+template<typename SampleT>
+int SampleStoreT<SampleT>::ReserveSlots(unsigned nSlots)
+{
+  if (mNUsedBlocks>0 || mReserved) return -EBUSY;
+  if (nSlots==0) return 0;
+  // the reserved range is rounded up to complete chunks, block ids of the
+  // arena follow and the lookup of the block data is the same for both
+  unsigned nChunks=(nSlots*mNBlocksPerChannel+kBlocksPerChunk-1)/kBlocksPerChunk;
+  mReserved=new sample_t[(unsigned long)nChunks*kBlocksPerChunk*kBlockLength];
+  std::vector<sample_t*> chunks(nChunks);
+  for (unsigned i=0; i<nChunks; i++) {
+    chunks[i]=mReserved+(unsigned long)i*kBlocksPerChunk*kBlockLength;
+  }
+  mChunks.insert(mChunks.begin(), chunks.begin(), chunks.end());
+  mNReservedSlots=nSlots;
+  mNReservedChunks=nChunks;
+  mNextBlock=nChunks*kBlocksPerChunk;
+  return 0;
+}
+
+template<typename SampleT>
+unsigned SampleStoreT<SampleT>::AddChannel()
+{
+  mBlockIndex.resize(mBlockIndex.size()+mNBlocksPerChannel, kNoBlock);
+  mDirtyFlags.push_back(false);
+  return mNChannels++;
+}
+
+template<typename SampleT>
+unsigned SampleStoreT<SampleT>::AllocateBlock(unsigned slot, unsigned block)
+{
+  if (!mDirtyFlags[slot]) {
+    mDirtyFlags[slot]=true;
+    mDirtyChannels.push_back(slot);
+  }
+  mNUsedBlocks++;
+  unsigned id=0;
+  if (slot<mNReservedSlots) {
+    id=slot*mNBlocksPerChannel+block;
+  } else {
+    id=mNextBlock++;
+    if (id/kBlocksPerChunk >= mChunks.size()) {
+      mChunks.push_back(new sample_t[kBlocksPerChunk*kBlockLength]);
+    }
+  }
+  // initialize to void signal to indicate timebins without signals
+  memset(BlockData(id), 0xff, kBlockLength*sizeof(sample_t));
+  return id;
+}
+
+template<typename SampleT>
+int SampleStoreT<SampleT>::GetDenseChannel(unsigned slot, sample_t* target) const
+{
+  if (!target || slot>=mNChannels) return -1;
+  int nBlocks=0;
+  for (unsigned block=0; block<mNBlocksPerChannel; block++) {
+    unsigned offset=block*kBlockLength;
+    unsigned length=std::min(kBlockLength, mChannelLength-offset);
+    const sample_t* data=FindBlock(slot, block);
+    if (data) {
+      memcpy(target+offset, data, length*sizeof(sample_t));
+      nBlocks++;
+    } else {
+      memset(target+offset, 0xff, length*sizeof(sample_t));
+    }
+  }
+  return nBlocks;
+}
+
+template<typename SampleT>
+int SampleStoreT<SampleT>::SetDenseChannel(unsigned slot, const sample_t* source)
+{
+  if (!source || slot>=mNChannels) return -1;
+  for (unsigned block=0; block<mNBlocksPerChannel; block++) {
+    unsigned offset=block*kBlockLength;
+    unsigned length=std::min(kBlockLength, mChannelLength-offset);
+    sample_t* data=FindBlock(slot, block);
+    if (!data) {
+      unsigned i=0;
+      for (; i<length && source[offset+i]==kVoidSample; i++) {/* skip */}
+      if (i==length) continue;
+      data=GetBlock(slot, block);
+    }
+    memcpy(data, source+offset, length*sizeof(sample_t));
+  }
+  return 0;
+}
+
+template<typename SampleT>
+void SampleStoreT<SampleT>::Clear()
+{
+  for (std::vector<unsigned>::const_iterator slot=mDirtyChannels.begin();
+       slot!=mDirtyChannels.end(); slot++) {
+    std::vector<unsigned>::iterator first=mBlockIndex.begin()+(*slot)*mNBlocksPerChannel;
+    std::fill(first, first+mNBlocksPerChannel, kNoBlock);
+    mDirtyFlags[*slot]=false;
+  }
+  mDirtyChannels.clear();
+  mNUsedBlocks=0;
+  mNextBlock=mNReservedChunks*kBlocksPerChunk;
+}
+
+// the implementation is instantiated for the types in use
+template class SampleStoreT<unsigned short>;
+template class SampleStoreT<unsigned>;
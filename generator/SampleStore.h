@@ -0,0 +1,216 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   SampleStore.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Sparse storage of channel samples
+
+#ifndef SAMPLESTORE_H
+#define SAMPLESTORE_H
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * @class SampleStoreT
+ * Sparse storage of the samples of a number of channels.
+ *
+ * Channels are identified by a slot number. The timebins of a channel are
+ * organized in blocks of kBlockLength samples, a block is only allocated
+ * when a sample inside its range is accessed for writing. Timebins of
+ * blocks which have not been allocated hold the void signal. Memory
+ * consumption thus scales with the occupancy rather than with the number
+ * of channels.
+ *
+ * Blocks are taken from a pooled arena which is allocated in chunks and
+ * kept when the store is cleared, a store can be reused for consecutive
+ * timeframes without further allocations. Channels which received a block
+ * are kept in a list of dirty channels, clearing the store only touches
+ * those channels.
+ *
+ * The blocks of a number of leading slots can be reserved in slot order,
+ * see ReserveSlots. The blocks of neighbouring slots are then adjacent in
+ * memory independently of the order of writing.
+ *
+ * Algorithms requiring the full channel can retrieve a dense view of the
+ * channel and write back the modified data.
+ *
+ * The store is used with 16 bit samples, see SampleStore, and with 32 bit
+ * samples for the accumulation of signals exceeding the 16 bit range, see
+ * WideSampleStore. The implementation is instantiated for those types.
+ */
+template<typename SampleT>
+class SampleStoreT {
+ public:
+  typedef SampleT sample_t;
+
+  /// value of timebins without signal, all bits set
+  static const sample_t kVoidSample=(SampleT)(~0u);
+  /// number of timebins in one block, power of two
+  static const unsigned kBlockLength=32;
+  /// number of blocks allocated at once in the arena
+  static const unsigned kBlocksPerChunk=4096;
+
+  /** standard constructor
+   *  @param channelLength  number of timebins per channel
+   */
+  SampleStoreT(unsigned channelLength);
+  /// destructor
+  ~SampleStoreT();
+
+  /// number of timebins per channel
+  unsigned GetChannelLength() const {return mChannelLength;}
+
+  /// number of channel slots
+  unsigned GetNChannels() const {return mNChannels;}
+
+  /**
+   * Add a channel slot.
+   * @return slot number of the new channel
+   */
+  unsigned AddChannel();
+
+  /**
+   * Reserve contiguous memory for the blocks of the first slots.
+   * The blocks of slot s are placed at position s*GetNBlocksPerChannel()
+   * in one range of memory, the blocks of the other slots are taken from
+   * the arena in the order of allocation. Blocks are still only assigned
+   * when written, the reservation is kept when the store is cleared. Has
+   * to be called before any block is allocated.
+   * @param nSlots   number of slots, need not exist yet
+   * @return 0 on success, -EBUSY if blocks are in use or already reserved
+   */
+  int ReserveSlots(unsigned nSlots);
+
+  /// number of slots with reserved blocks
+  unsigned GetNReservedSlots() const {return mNReservedSlots;}
+
+  /**
+   * Get reference to the sample of a timebin.
+   * The block of the timebin is allocated if not yet existing.
+   */
+  sample_t& GetSample(unsigned slot, unsigned timebin) {
+    return GetBlock(slot, timebin/kBlockLength)[timebin%kBlockLength];
+  }
+
+  /**
+   * Get block of a channel, allocated if not yet existing.
+   * @param slot     channel slot
+   * @param block    block number within the channel
+   */
+  sample_t* GetBlock(unsigned slot, unsigned block) {
+    unsigned& id=mBlockIndex[slot*mNBlocksPerChannel+block];
+    if (id==kNoBlock) id=AllocateBlock(slot, block);
+    return BlockData(id);
+  }
+
+  /**
+   * Find block of a channel.
+   * @return pointer to block data, NULL if block is not allocated
+   */
+  sample_t* FindBlock(unsigned slot, unsigned block) {
+    unsigned id=mBlockIndex[slot*mNBlocksPerChannel+block];
+    return id==kNoBlock?NULL:BlockData(id);
+  }
+  const sample_t* FindBlock(unsigned slot, unsigned block) const {
+    unsigned id=mBlockIndex[slot*mNBlocksPerChannel+block];
+    return id==kNoBlock?NULL:BlockData(id);
+  }
+
+  /// number of blocks per channel
+  unsigned GetNBlocksPerChannel() const {return mNBlocksPerChannel;}
+
+  /**
+   * Fill dense view of a channel.
+   * Timebins without allocated block are set to the void signal.
+   * @param slot     channel slot
+   * @param target   target buffer of at least channel length
+   * @return number of allocated blocks
+   */
+  int GetDenseChannel(unsigned slot, sample_t* target) const;
+
+  /**
+   * Write back a dense view of a channel.
+   * Blocks are only allocated if they contain at least one signal.
+   * @param slot     channel slot
+   * @param source   channel data of channel length
+   */
+  int SetDenseChannel(unsigned slot, const sample_t* source);
+
+  /**
+   * Release all blocks.
+   * Channel slots are kept, the memory of the arena stays allocated
+   * for reuse. Only the dirty channels are reset, the cost scales with
+   * the number of channels which have been written.
+   */
+  void Clear();
+
+  /// number of channels holding at least one block
+  unsigned GetNDirtyChannels() const {return mDirtyChannels.size();}
+
+  /// number of blocks currently in use
+  unsigned GetNUsedBlocks() const {return mNUsedBlocks;}
+
+  /// size of the allocated arena in bytes
+  unsigned long GetArenaSize() const {
+    return mChunks.size()*kBlocksPerChunk*kBlockLength*sizeof(sample_t);
+  }
+
+ private:
+  /// copy constructor prohibited
+  SampleStoreT(const SampleStoreT&);
+  /// assignment operator prohibited
+  SampleStoreT& operator=(const SampleStoreT&);
+
+  static const unsigned kNoBlock=~0u;
+
+  /// allocate a block initialized to void signal, channel is marked dirty
+  unsigned AllocateBlock(unsigned slot, unsigned block);
+
+  sample_t* BlockData(unsigned id) const {
+    return mChunks[id/kBlocksPerChunk]+(id%kBlocksPerChunk)*kBlockLength;
+  }
+
+  /// number of timebins per channel
+  unsigned mChannelLength;
+  /// number of blocks per channel
+  unsigned mNBlocksPerChannel;
+  /// number of channel slots
+  unsigned mNChannels;
+  /// block id for every block of every channel
+  std::vector<unsigned> mBlockIndex;
+  /// memory chunks of the arena, the leading chunks hold the reserved blocks
+  std::vector<sample_t*> mChunks;
+  /// memory of the reserved blocks, split into the leading chunks
+  sample_t* mReserved;
+  /// number of slots with reserved blocks
+  unsigned mNReservedSlots;
+  /// number of leading chunks holding the reserved blocks
+  unsigned mNReservedChunks;
+  /// id of the next block allocated from the arena
+  unsigned mNextBlock;
+  /// number of blocks in use
+  unsigned mNUsedBlocks;
+  /// flag for every channel slot, set if holding blocks
+  std::vector<bool> mDirtyFlags;
+  /// list of channel slots holding blocks
+  std::vector<unsigned> mDirtyChannels;
+};
+
+/// sample store of the signal buffers
+typedef SampleStoreT<unsigned short> SampleStore;
+/// sample store with 32 bit samples for the accumulation of signals
+typedef SampleStoreT<unsigned> WideSampleStore;
+#endif
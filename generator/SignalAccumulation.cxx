@@ -0,0 +1,237 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   SignalAccumulation.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Saturating accumulation kernels for the sample buffers
+
+#include "SignalAccumulation.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIGNALACCUMULATION_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIGNALACCUMULATION_SSE2
+#endif
+
+const SignalAccumulation::sample_t SignalAccumulation::kVoidSample;
+const SignalAccumulation::sample_t SignalAccumulation::kMaxSignal;
+const SignalAccumulation::wide_sample_t SignalAccumulation::kWideVoidSample;
+const SignalAccumulation::wide_sample_t SignalAccumulation::kWideMaxSignal;
+
+namespace {
+  typedef SignalAccumulation::sample_t sample_t;
+  typedef SignalAccumulation::wide_sample_t wide_sample_t;
+
+  /// accumulate the samples from begin to size sample by sample
+  template<typename T>
+  unsigned AddSamples(T* target, const sample_t* signals, const sample_t* first, unsigned begin, unsigned size, T voidSample)
+  {
+    const T maxSignal=voidSample-1;
+    unsigned nOverflows=0;
+    for (unsigned i=begin; i<size; i++) {
+      if (target[i]==voidSample) {
+	target[i]=first[i];
+      } else if (target[i]>maxSignal-signals[i]) {
+	target[i]=maxSignal;
+	nOverflows++;
+      } else {
+	target[i]+=signals[i];
+      }
+    }
+    return nOverflows;
+  }
+
+#if defined(SIGNALACCUMULATION_AVX2)
+  const unsigned kSIMDWidth=16;
+  const unsigned kWideSIMDWidth=8;
+
+  /**
+   * Accumulate full vectors of samples.
+   * The saturating addition gives the void signal for sums exceeding the
+   * maximum, those lanes are reduced by one to the maximum signal.
+   * @return number of processed samples
+   */
+  unsigned AddSIMD16(sample_t* target, const sample_t* signals, const sample_t* first, unsigned size, unsigned& nOverflows)
+  {
+    const __m256i voidSignal=_mm256_set1_epi16((short)SignalAccumulation::kVoidSample);
+    const __m256i one=_mm256_set1_epi16(1);
+    unsigned i=0;
+    for (; i+kSIMDWidth<=size; i+=kSIMDWidth) {
+      __m256i samples=_mm256_loadu_si256((const __m256i*)(target+i));
+      __m256i sum=_mm256_adds_epu16(samples, _mm256_loadu_si256((const __m256i*)(signals+i)));
+      __m256i isVoid=_mm256_cmpeq_epi16(samples, voidSignal);
+      __m256i overflow=_mm256_andnot_si256(isVoid, _mm256_cmpeq_epi16(sum, voidSignal));
+      sum=_mm256_sub_epi16(sum, _mm256_and_si256(overflow, one));
+      sum=_mm256_blendv_epi8(sum, _mm256_loadu_si256((const __m256i*)(first+i)), isVoid);
+      _mm256_storeu_si256((__m256i*)(target+i), sum);
+      nOverflows+=__builtin_popcount(_mm256_movemask_epi8(overflow))/2;
+    }
+    return i;
+  }
+
+  /// accumulate full vectors of 32 bit samples, @return number of processed samples
+  unsigned AddSIMD32(wide_sample_t* target, const sample_t* signals, const sample_t* first, unsigned size, unsigned& nOverflows)
+  {
+    const __m256i voidSignal=_mm256_set1_epi32((int)SignalAccumulation::kWideVoidSample);
+    const __m256i maxSignal=_mm256_set1_epi32((int)SignalAccumulation::kWideMaxSignal);
+    const __m256i allOnes=_mm256_set1_epi32(-1);
+    unsigned i=0;
+    for (; i+kWideSIMDWidth<=size; i+=kWideSIMDWidth) {
+      __m256i samples=_mm256_loadu_si256((const __m256i*)(target+i));
+      __m256i added=_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(signals+i)));
+      __m256i isVoid=_mm256_cmpeq_epi32(samples, voidSignal);
+      // overflow if sample > max-signal, unsigned comparison by the maximum
+      __m256i limit=_mm256_sub_epi32(maxSignal, added);
+      __m256i inRange=_mm256_cmpeq_epi32(_mm256_max_epu32(samples, limit), limit);
+      __m256i overflow=_mm256_andnot_si256(_mm256_or_si256(isVoid, inRange), allOnes);
+      __m256i sum=_mm256_add_epi32(samples, added);
+      sum=_mm256_blendv_epi8(sum, maxSignal, overflow);
+      sum=_mm256_blendv_epi8(sum, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(first+i))), isVoid);
+      _mm256_storeu_si256((__m256i*)(target+i), sum);
+      nOverflows+=__builtin_popcount(_mm256_movemask_epi8(overflow))/4;
+    }
+    return i;
+  }
+#elif defined(SIGNALACCUMULATION_SSE2)
+  const unsigned kSIMDWidth=8;
+  const unsigned kWideSIMDWidth=4;
+
+  /// select a where mask is set, b otherwise
+  __m128i Select(__m128i mask, __m128i a, __m128i b)
+  {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+
+  /**
+   * Accumulate full vectors of samples.
+   * The saturating addition gives the void signal for sums exceeding the
+   * maximum, those lanes are reduced by one to the maximum signal.
+   * @return number of processed samples
+   */
+  unsigned AddSIMD16(sample_t* target, const sample_t* signals, const sample_t* first, unsigned size, unsigned& nOverflows)
+  {
+    const __m128i voidSignal=_mm_set1_epi16((short)SignalAccumulation::kVoidSample);
+    const __m128i one=_mm_set1_epi16(1);
+    unsigned i=0;
+    for (; i+kSIMDWidth<=size; i+=kSIMDWidth) {
+      __m128i samples=_mm_loadu_si128((const __m128i*)(target+i));
+      __m128i sum=_mm_adds_epu16(samples, _mm_loadu_si128((const __m128i*)(signals+i)));
+      __m128i isVoid=_mm_cmpeq_epi16(samples, voidSignal);
+      __m128i overflow=_mm_andnot_si128(isVoid, _mm_cmpeq_epi16(sum, voidSignal));
+      sum=_mm_sub_epi16(sum, _mm_and_si128(overflow, one));
+      sum=Select(isVoid, _mm_loadu_si128((const __m128i*)(first+i)), sum);
+      _mm_storeu_si128((__m128i*)(target+i), sum);
+      nOverflows+=__builtin_popcount(_mm_movemask_epi8(overflow))/2;
+    }
+    return i;
+  }
+
+  /// accumulate full vectors of 32 bit samples, @return number of processed samples
+  unsigned AddSIMD32(wide_sample_t* target, const sample_t* signals, const sample_t* first, unsigned size, unsigned& nOverflows)
+  {
+    const __m128i voidSignal=_mm_set1_epi32((int)SignalAccumulation::kWideVoidSample);
+    const __m128i maxSignal=_mm_set1_epi32((int)SignalAccumulation::kWideMaxSignal);
+    const __m128i signBit=_mm_set1_epi32((int)0x80000000);
+    const __m128i zero=_mm_setzero_si128();
+    unsigned i=0;
+    for (; i+kWideSIMDWidth<=size; i+=kWideSIMDWidth) {
+      __m128i samples=_mm_loadu_si128((const __m128i*)(target+i));
+      __m128i added=_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(signals+i)), zero);
+      __m128i isVoid=_mm_cmpeq_epi32(samples, voidSignal);
+      // overflow if sample > max-signal, unsigned comparison with flipped sign bit
+      __m128i limit=_mm_sub_epi32(maxSignal, added);
+      __m128i overflow=_mm_cmpgt_epi32(_mm_xor_si128(samples, signBit), _mm_xor_si128(limit, signBit));
+      overflow=_mm_andnot_si128(isVoid, overflow);
+      __m128i sum=Select(overflow, maxSignal, _mm_add_epi32(samples, added));
+      sum=Select(isVoid, _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(first+i)), zero), sum);
+      _mm_storeu_si128((__m128i*)(target+i), sum);
+      nOverflows+=__builtin_popcount(_mm_movemask_epi8(overflow))/4;
+    }
+    return i;
+  }
+#endif
+}
+
+unsigned SignalAccumulation::Add(sample_t* target, const sample_t* signals, const sample_t* first, unsigned size)
+{
+  return AddSIMD(target, signals, first, size);
+}
+
+unsigned SignalAccumulation::AddScalar(sample_t* target, const sample_t* signals, const sample_t* first, unsigned size)
+{
+  return AddSamples(target, signals, first, 0, size, kVoidSample);
+}
+
+unsigned SignalAccumulation::AddSIMD(sample_t* target, const sample_t* signals, const sample_t* first, unsigned size)
+{
+#if defined(SIGNALACCUMULATION_AVX2) || defined(SIGNALACCUMULATION_SSE2)
+  unsigned nOverflows=0;
+  unsigned i=AddSIMD16(target, signals, first, size, nOverflows);
+  return nOverflows+AddSamples(target, signals, first, i, size, kVoidSample);
+#else
+  return AddScalar(target, signals, first, size);
+#endif
+}
+
+unsigned SignalAccumulation::Add(wide_sample_t* target, const sample_t* signals, const sample_t* first, unsigned size)
+{
+  return AddSIMD(target, signals, first, size);
+}
+
+unsigned SignalAccumulation::AddScalar(wide_sample_t* target, const sample_t* signals, const sample_t* first, unsigned size)
+{
+  return AddSamples(target, signals, first, 0, size, kWideVoidSample);
+}
+
+unsigned SignalAccumulation::AddSIMD(wide_sample_t* target, const sample_t* signals, const sample_t* first, unsigned size)
+{
+#if defined(SIGNALACCUMULATION_AVX2) || defined(SIGNALACCUMULATION_SSE2)
+  unsigned nOverflows=0;
+  unsigned i=AddSIMD32(target, signals, first, size, nOverflows);
+  return nOverflows+AddSamples(target, signals, first, i, size, kWideVoidSample);
+#else
+  return AddScalar(target, signals, first, size);
+#endif
+}
+
+unsigned SignalAccumulation::Narrow(const wide_sample_t* source, unsigned size, unsigned scalingFactor, sample_t* target)
+{
+  if (scalingFactor==0) scalingFactor=1;
+  unsigned nOverflows=0;
+  for (unsigned i=0; i<size; i++) {
+    wide_sample_t signal=source[i];
+    if (signal==kWideVoidSample) {
+      target[i]=kVoidSample;
+      continue;
+    }
+    signal/=scalingFactor;
+    if (signal>kMaxSignal) {
+      signal=kMaxSignal;
+      nOverflows++;
+    }
+    target[i]=signal;
+  }
+  return nOverflows;
+}
+
+const char* SignalAccumulation::GetSIMDKernelName()
+{
+#if defined(SIGNALACCUMULATION_AVX2)
+  return "avx2";
+#elif defined(SIGNALACCUMULATION_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,98 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   SignalAccumulation.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Saturating accumulation kernels for the sample buffers
+
+#ifndef SIGNALACCUMULATION_H
+#define SIGNALACCUMULATION_H
+
+/**
+ * @class SignalAccumulation
+ * Accumulation of signals into a range of timebins of a sample buffer.
+ *
+ * Timebins holding the void signal receive the first value of the timebin,
+ * the signal is added to all other timebins. The sum saturates at the
+ * maximum accumulated signal, which is one below the void signal, and
+ * the saturated timebins are counted. The kernels use SSE2 or AVX2
+ * instructions depending on the compiler flags, e.g. -mavx2, the scalar
+ * kernel is used on other architectures. All kernels give identical
+ * results.
+ *
+ * Besides the 16 bit samples of the sample buffers, the signals can be
+ * accumulated into 32 bit samples, e.g. for the accumulation of a high
+ * number of collisions which are normalized afterwards. The wide samples
+ * are converted to 16 bit samples by Narrow.
+ */
+class SignalAccumulation {
+ public:
+  typedef unsigned short sample_t;
+  typedef unsigned wide_sample_t;
+
+  /// value of timebins without signal
+  static const sample_t kVoidSample=0xffff;
+  /// maximum accumulated signal
+  static const sample_t kMaxSignal=kVoidSample-1;
+  /// value of timebins without signal for 32 bit samples
+  static const wide_sample_t kWideVoidSample=0xffffffff;
+  /// maximum accumulated signal for 32 bit samples
+  static const wide_sample_t kWideMaxSignal=kWideVoidSample-1;
+
+  /**
+   * Accumulation with the best available kernel.
+   * @param target   samples
+   * @param signals  signals to be added to non-void samples
+   * @param first    values for void samples
+   * @param size     number of samples
+   * @return number of saturated samples
+   */
+  static unsigned Add(sample_t* target, const sample_t* signals, const sample_t* first, unsigned size);
+
+  /// accumulation sample by sample, reference for the kernels
+  static unsigned AddScalar(sample_t* target, const sample_t* signals, const sample_t* first, unsigned size);
+
+  /// accumulation with the vectorized kernel, scalar kernel if not available
+  static unsigned AddSIMD(sample_t* target, const sample_t* signals, const sample_t* first, unsigned size);
+
+  /// accumulation into 32 bit samples with the best available kernel
+  static unsigned Add(wide_sample_t* target, const sample_t* signals, const sample_t* first, unsigned size);
+
+  /// accumulation into 32 bit samples sample by sample
+  static unsigned AddScalar(wide_sample_t* target, const sample_t* signals, const sample_t* first, unsigned size);
+
+  /// accumulation into 32 bit samples with the vectorized kernel
+  static unsigned AddSIMD(wide_sample_t* target, const sample_t* signals, const sample_t* first, unsigned size);
+
+  /**
+   * Convert 32 bit samples to 16 bit samples.
+   * Signals are divided by the scaling factor and saturate at kMaxSignal,
+   * void samples stay void.
+   * @param source         32 bit samples
+   * @param size           number of samples
+   * @param scalingFactor  divisor of the signals, 0 and 1 keep the signals
+   * @param target         16 bit samples
+   * @return number of saturated samples
+   */
+  static unsigned Narrow(const wide_sample_t* source, unsigned size, unsigned scalingFactor, sample_t* target);
+
+  /// name of the vectorized kernel, "scalar" if not available
+  static const char* GetSIMDKernelName();
+
+ private:
+  /// standard constructor prohibited, only static functions
+  SignalAccumulation();
+};
+#endif
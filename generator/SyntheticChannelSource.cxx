@@ -0,0 +1,179 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   SyntheticChannelSource.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Channel source generating synthetic events
+
+#include "SyntheticChannelSource.h"
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <sstream>
+#include <iostream>
+
+const char* SyntheticChannelSource::kPrefix="synthetic:";
+
+namespace {
+  /// number of timebins of a channel
+  const int kNTimebins=1024;
+  /// range of the 12 bit ALTRO HW address
+  const unsigned kMaxChannels=0x1000;
+}
+
+SyntheticChannelSource::SyntheticChannelSource()
+  : ChannelSource()
+  , mNEvents(100)
+  , mNDDLs(216)
+  , mNChannels(2500)
+  , mMaxBunches(4)
+  , mMaxLength(40)
+  , mSeed(1)
+  , mEventIndex(-1)
+  , mMinDDL(-1)
+  , mMaxDDL(-1)
+  , mDDLNumber(~0u)
+  , mChannel(~0u)
+  , mNBunches(0)
+  , mLastTime(0)
+  , mStartTime(0)
+  , mState(0)
+  , mSignals()
+{
+}
+
+SyntheticChannelSource::~SyntheticChannelSource()
+{
+}
+
+int SyntheticChannelSource::Init(const char* name)
+{
+  if (name==NULL || strncmp(name, kPrefix, strlen(kPrefix))!=0) return -EINVAL;
+  SetName(name);
+  std::stringstream configuration(name+strlen(kPrefix));
+  std::string parameter;
+  while (std::getline(configuration, parameter, ',')) {
+    if (parameter.empty()) continue;
+    size_t separator=parameter.find('=');
+    if (separator==std::string::npos) {
+      std::cerr << "invalid parameter '" << parameter << "' for synthetic source" << std::endl;
+      return -EINVAL;
+    }
+    std::string key=parameter.substr(0, separator);
+    int value=atoi(parameter.c_str()+separator+1);
+    if (key=="events") mNEvents=value;
+    else if (key=="ddls") mNDDLs=value;
+    else if (key=="channels") mNChannels=value;
+    else if (key=="bunches") mMaxBunches=value;
+    else if (key=="length") mMaxLength=value;
+    else if (key=="seed") mSeed=value;
+    else {
+      std::cerr << "unknown key '" << key << "' for synthetic source" << std::endl;
+      return -EINVAL;
+    }
+  }
+  if (mNChannels>kMaxChannels || mMaxLength<1 || mMaxLength>(unsigned)kNTimebins) return -EINVAL;
+  mEventIndex=-1;
+  return 0;
+}
+
+int SyntheticChannelSource::NextEvent()
+{
+  if (mEventIndex+1>=mNEvents) return 0;
+  GotoEvent(mEventIndex+1);
+  return 1;
+}
+
+int SyntheticChannelSource::GotoEvent(int eventIndex)
+{
+  if (eventIndex<0 || eventIndex>=mNEvents) return -EINVAL;
+  mEventIndex=eventIndex;
+  SelectDDLRange(mMinDDL, mMaxDDL);
+  return 0;
+}
+
+void SyntheticChannelSource::SelectDDLRange(int minDDL, int maxDDL)
+{
+  mMinDDL=minDDL;
+  mMaxDDL=maxDDL;
+  mDDLNumber=~0u;
+  mChannel=~0u;
+  mNBunches=0;
+}
+
+bool SyntheticChannelSource::NextDDL()
+{
+  unsigned first=0;
+  unsigned last=mNDDLs;
+  if (mMinDDL>=0 && mMaxDDL>=0) {
+    first=mMinDDL;
+    if ((unsigned)mMaxDDL+1<last) last=mMaxDDL+1;
+  }
+  mDDLNumber=mDDLNumber==~0u?first:mDDLNumber+1;
+  mChannel=~0u;
+  mNBunches=0;
+  return mDDLNumber<last;
+}
+
+bool SyntheticChannelSource::NextChannel()
+{
+  if (++mChannel>=mNChannels) return false;
+  // the random state of a channel only depends on the channel coordinates
+  mState=((unsigned long long)mSeed<<40 ^ (unsigned long long)mEventIndex<<24 ^ mDDLNumber<<12 ^ mChannel);
+  mState=mState*0x9e3779b97f4a7c15ULL+1;
+  mNBunches=Random()%(mMaxBunches+1);
+  mLastTime=kNTimebins-1;
+  return true;
+}
+
+bool SyntheticChannelSource::NextBunch()
+{
+  if (mNBunches==0) return false;
+  mNBunches--;
+  int length=1+Random()%mMaxLength;
+  int start=mLastTime-Random()%(kNTimebins/(mMaxBunches+1));
+  if (start-length<0) {
+    mNBunches=0;
+    return false;
+  }
+  mStartTime=start;
+  // leave at least two timebins between bunches
+  mLastTime=start-length-2;
+  mSignals.resize(length);
+  // every third bunch is pure pedestal, the others carry a signal peak
+  int peak=Random()%3==0?0:100+Random()%400;
+  for (int i=0; i<length; i++) {
+    int signal=40+Random()%12;
+    int distance=i-length/2;
+    if (peak && distance*distance<16) signal+=peak/(1+distance*distance);
+    mSignals[i]=signal>1023?1023:signal;
+  }
+  return true;
+}
+
+unsigned SyntheticChannelSource::Random()
+{
+  // linear congruential generator, upper bits are used
+  mState=mState*6364136223846793005ULL+1442695040888963407ULL;
+  return (unsigned)(mState>>33);
+}
+
+ChannelSource* SyntheticChannelSource::Clone() const
+{
+  SyntheticChannelSource* source=new SyntheticChannelSource;
+  if (source->Init(GetName().c_str())<0) {
+    delete source;
+    return NULL;
+  }
+  return source;
+}
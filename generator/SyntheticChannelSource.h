@@ -0,0 +1,113 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   SyntheticChannelSource.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Channel source generating synthetic events
+
+#ifndef SYNTHETICCHANNELSOURCE_H
+#define SYNTHETICCHANNELSOURCE_H
+
+#include "ChannelSource.h"
+#include <vector>
+
+/**
+ * @class SyntheticChannelSource
+ * Channel source generating reproducible random events.
+ *
+ * The data of every channel is derived from the seed, the event index, the
+ * DDL number and the HW address, an event reads the same independently of
+ * the order of access. Every channel carries pedestal bunches with a
+ * fraction of bunches holding a signal peak. The source is intended for
+ * benchmarks and tests without access to raw data.
+ *
+ * The source is configured by a name of the format
+ * <pre>
+ * synthetic:key=value,key=value,...
+ * </pre>
+ * with the keys
+ * - events   number of events, default 100
+ * - ddls     number of DDLs, default 216
+ * - channels number of channels per DDL, default 2500, max 4096
+ * - bunches  maximum number of bunches per channel, default 4
+ * - length   maximum bunch length, default 40
+ * - seed     seed of the random generation, default 1
+ */
+class SyntheticChannelSource : public ChannelSource {
+ public:
+  SyntheticChannelSource();
+  ~SyntheticChannelSource();
+
+  /// prefix of the source name
+  static const char* kPrefix;
+
+  /**
+   * Init from name.
+   * @return 0 on success, -EINVAL if the configuration is invalid
+   */
+  int Init(const char* name);
+
+  int NextEvent();
+  int GotoEvent(int eventIndex);
+  int GetEventIndex() const {return mEventIndex;}
+  void SelectDDLRange(int minDDL, int maxDDL);
+  bool NextDDL();
+  unsigned GetDDLNumber() const {return mDDLNumber;}
+  bool NextChannel();
+  unsigned GetHWAddress() const {return mChannel;}
+  bool NextBunch();
+  int GetStartTimeBin() const {return mStartTime;}
+  int GetBunchLength() const {return mSignals.size();}
+  const unsigned short* GetSignals() const {return mSignals.empty()?NULL:&mSignals[0];}
+  ChannelSource* Clone() const;
+
+ private:
+  /// next random number of the current channel
+  unsigned Random();
+
+  /// number of events
+  int mNEvents;
+  /// number of DDLs
+  unsigned mNDDLs;
+  /// number of channels per DDL
+  unsigned mNChannels;
+  /// maximum number of bunches per channel
+  unsigned mMaxBunches;
+  /// maximum bunch length
+  unsigned mMaxLength;
+  /// seed
+  unsigned mSeed;
+  /// current event
+  int mEventIndex;
+  /// min DDL of the selection
+  int mMinDDL;
+  /// max DDL of the selection
+  int mMaxDDL;
+  /// current DDL, ~0 before first DDL
+  unsigned mDDLNumber;
+  /// current channel, ~0 before first channel
+  unsigned mChannel;
+  /// remaining bunches of the current channel
+  unsigned mNBunches;
+  /// last timebin available for the next bunch
+  int mLastTime;
+  /// start timebin of the current bunch
+  int mStartTime;
+  /// random state of the current channel
+  unsigned long long mState;
+  /// signals of the current bunch
+  std::vector<unsigned short> mSignals;
+};
+#endif
@@ -0,0 +1,82 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ThreadPool.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Simple pool of worker threads
+//  @note   requires C++11 standard
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned nThreads)
+  : mThreads()
+  , mMutex()
+  , mStart()
+  , mDone()
+  , mTask(nullptr)
+  , mNTasks(0)
+  , mNextTask(0)
+  , mNCompleted(0)
+  , mGeneration(0)
+  , mStop(false)
+{
+  for (unsigned i=0; i<nThreads; i++) {
+    mThreads.push_back(std::thread(&ThreadPool::Work, this));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop=true;
+  }
+  mStart.notify_all();
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+}
+
+void ThreadPool::Run(unsigned nTasks, const task_t& task)
+{
+  if (nTasks==0) return;
+  std::unique_lock<std::mutex> lock(mMutex);
+  mTask=&task;
+  mNTasks=nTasks;
+  mNextTask=0;
+  mNCompleted=0;
+  mGeneration++;
+  mStart.notify_all();
+  mDone.wait(lock, [this] {return mNCompleted==mNTasks;});
+  mTask=nullptr;
+}
+
+void ThreadPool::Work()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  unsigned long generation=0;
+  while (true) {
+    mStart.wait(lock, [this, &generation] {return mStop || mGeneration!=generation;});
+    if (mStop) return;
+    generation=mGeneration;
+    // a worker waking up late finds all tasks of the set taken
+    while (mNextTask<mNTasks) {
+      unsigned task=mNextTask++;
+      const task_t& function=*mTask;
+      lock.unlock();
+      function(task);
+      lock.lock();
+      if (++mNCompleted==mNTasks) mDone.notify_all();
+    }
+  }
+}
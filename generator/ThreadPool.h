@@ -0,0 +1,91 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ThreadPool.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Simple pool of worker threads
+//  @note   requires C++11 standard
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/** @class ThreadPool
+ *  A fixed number of worker threads processing a set of tasks.
+ *
+ *  The tasks of one call to Run are identified by a task number, every
+ *  task number is processed exactly once by one of the threads. Run
+ *  returns after all tasks are processed, the threads are kept waiting
+ *  for the next set of tasks.
+ *
+ *  The header uses C++11 features and must not be included in headers
+ *  parsed by root cint, see GeneratorTF.
+ */
+class ThreadPool {
+ public:
+  typedef std::function<void(unsigned)> task_t;
+
+  /** standard constructor
+   *  @param nThreads   number of worker threads
+   */
+  ThreadPool(unsigned nThreads);
+  /// destructor, threads are joined
+  ~ThreadPool();
+
+  /// number of worker threads
+  unsigned GetNThreads() const {return mThreads.size();}
+
+  /**
+   * Process tasks and wait for completion.
+   * @param nTasks     number of tasks
+   * @param task       function called with the task number
+   */
+  void Run(unsigned nTasks, const task_t& task);
+
+ private:
+  /// copy constructor prohibited
+  ThreadPool(const ThreadPool&);
+  /// assignment operator prohibited
+  ThreadPool& operator=(const ThreadPool&);
+
+  /// loop of the worker threads
+  void Work();
+
+  /// the worker threads
+  std::vector<std::thread> mThreads;
+  /// protection of the task state
+  std::mutex mMutex;
+  /// signals new set of tasks or stop
+  std::condition_variable mStart;
+  /// signals completion of all tasks
+  std::condition_variable mDone;
+  /// current task function
+  const task_t* mTask;
+  /// number of tasks in the current set
+  unsigned mNTasks;
+  /// next task to be processed
+  unsigned mNextTask;
+  /// number of completed tasks
+  unsigned mNCompleted;
+  /// counter for sets of tasks
+  unsigned long mGeneration;
+  /// stop the workers
+  bool mStop;
+};
+#endif
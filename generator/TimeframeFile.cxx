@@ -0,0 +1,300 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   TimeframeFile.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Binary file format for merged timeframes
+
+#include "TimeframeFile.h"
+#include <cstring>
+#include <cerrno>
+
+const char* TimeframeFile::kMagic="TPCTFBIN";
+const unsigned TimeframeFile::kVersion;
+const unsigned TimeframeFile::kHeaderSize;
+const unsigned TimeframeFile::kFrameHeaderSize;
+
+namespace {
+  /// padding of a record to 8 byte alignment
+  unsigned Padding(unsigned long long size) {return (8-size%8)%8;}
+}
+
+bool TimeframeFile::IsTimeframeFile(const char* filename)
+{
+  if (filename==NULL) return false;
+  const char* extension=".tfbin";
+  unsigned length=strlen(filename);
+  return length>strlen(extension) &&
+    strcmp(filename+length-strlen(extension), extension)==0;
+}
+
+TimeframeWriter::TimeframeWriter()
+  : mFile()
+  , mFlags(0)
+  , mFrameNumber(0)
+  , mNFrames(0)
+  , mChannelIndex()
+  , mChannelOffset()
+  , mPayload()
+  , mCompressed()
+{
+}
+
+TimeframeWriter::~TimeframeWriter()
+{
+  if (mFile.is_open()) Close();
+}
+
+int TimeframeWriter::Open(const char* filename, unsigned channelLength, unsigned flags)
+{
+  if (mFile.is_open()) Close();
+  mFlags=flags;
+  mNFrames=0;
+  mFile.open(filename, std::ios::binary | std::ios::trunc);
+  if (!mFile.good()) return -ENOENT;
+  unsigned version=kVersion;
+  mFile.write(kMagic, 8);
+  mFile.write((const char*)&version, sizeof(version));
+  mFile.write((const char*)&channelLength, sizeof(channelLength));
+  return mFile.good()?0:-EIO;
+}
+
+int TimeframeWriter::StartFrame(unsigned frameNumber)
+{
+  if (!mFile.is_open()) return -EBADF;
+  mFrameNumber=frameNumber;
+  mChannelIndex.clear();
+  mChannelOffset.clear();
+  mPayload.clear();
+  return 0;
+}
+
+void TimeframeWriter::AddChannel(unsigned index, const unsigned short* data, unsigned size)
+{
+  mChannelIndex.push_back(index);
+  mChannelOffset.push_back(mPayload.size());
+  if (size>0) mPayload.insert(mPayload.end(), data, data+size);
+}
+
+void TimeframeWriter::AddDenseChannel(unsigned index, const unsigned short* samples, unsigned size,
+				      unsigned short voidSample)
+{
+  mChannelIndex.push_back(index);
+  mChannelOffset.push_back(mPayload.size());
+  // bunches in order of descending timebins, the length is filled at the
+  // end of the bunch
+  unsigned lengthPosition=0;
+  unsigned length=0;
+  for (unsigned i=size; i-->0;) {
+    if (samples[i]==voidSample) {
+      if (length>0) mPayload[lengthPosition]=length;
+      length=0;
+      continue;
+    }
+    if (length++==0) {
+      mPayload.push_back(i);
+      lengthPosition=mPayload.size();
+      mPayload.push_back(0);
+    }
+    mPayload.push_back(samples[i]);
+  }
+  if (length>0) mPayload[lengthPosition]=length;
+}
+
+int TimeframeWriter::FinishFrame()
+{
+  if (!mFile.is_open()) return -EBADF;
+  unsigned nChannels=mChannelIndex.size();
+  unsigned payloadSize=mPayload.size();
+  const char* stored=(const char*)(payloadSize>0?&mPayload[0]:NULL);
+  unsigned long long storedSize=payloadSize*sizeof(unsigned short);
+  if (mFlags&kCompressed) {
+    // difference to the previous word, zigzag and 7 bit variable length
+    mCompressed.resize(3*payloadSize);
+    unsigned char* target=mCompressed.empty()?NULL:&mCompressed[0];
+    unsigned previous=0;
+    for (unsigned i=0; i<payloadSize; i++) {
+      int difference=(int)mPayload[i]-(int)previous;
+      unsigned value=difference<0?(unsigned)(-2*difference-1):(unsigned)(2*difference);
+      previous=mPayload[i];
+      while (value>=0x80) {
+	*target++=(value&0x7f)|0x80;
+	value>>=7;
+      }
+      *target++=value;
+    }
+    storedSize=target-(mCompressed.empty()?NULL:&mCompressed[0]);
+    stored=(const char*)(storedSize>0?&mCompressed[0]:NULL);
+  }
+
+  unsigned header[kFrameHeaderSize/sizeof(unsigned)]={mFrameNumber, nChannels, payloadSize, mFlags, 0, 0};
+  memcpy(header+4, &storedSize, sizeof(storedSize));
+  mFile.write((const char*)header, kFrameHeaderSize);
+  if (nChannels>0) {
+    mFile.write((const char*)&mChannelIndex[0], nChannels*sizeof(unsigned));
+    mFile.write((const char*)&mChannelOffset[0], nChannels*sizeof(unsigned));
+  }
+  if (storedSize>0) mFile.write(stored, storedSize);
+  unsigned long long recordSize=kFrameHeaderSize+2*nChannels*sizeof(unsigned)+storedSize;
+  static const char padding[8]={0};
+  mFile.write(padding, Padding(recordSize));
+  if (!mFile.good()) return -EIO;
+  mNFrames++;
+  return 0;
+}
+
+int TimeframeWriter::Close()
+{
+  if (!mFile.is_open()) return -EBADF;
+  bool good=mFile.good();
+  mFile.close();
+  return good?(int)mNFrames:-EIO;
+}
+
+TimeframeReader::TimeframeReader()
+  : mFile()
+  , mFileSize(0)
+  , mChannelLength(0)
+  , mFrameNumber(0)
+  , mChannelIndex()
+  , mChannelOffset()
+  , mPayload()
+  , mStored()
+{
+}
+
+TimeframeReader::~TimeframeReader()
+{
+  Close();
+}
+
+int TimeframeReader::Open(const char* filename)
+{
+  Close();
+  mFile.open(filename, std::ios::binary);
+  if (!mFile.good()) return -ENOENT;
+  mFile.seekg(0, std::ios::end);
+  mFileSize=mFile.tellg();
+  mFile.seekg(0, std::ios::beg);
+  char header[kHeaderSize];
+  mFile.read(header, kHeaderSize);
+  unsigned version=0;
+  memcpy(&version, header+8, sizeof(version));
+  memcpy(&mChannelLength, header+12, sizeof(mChannelLength));
+  if (!mFile.good() || memcmp(header, kMagic, 8)!=0 || version!=kVersion) {
+    Close();
+    return -EINVAL;
+  }
+  return 0;
+}
+
+void TimeframeReader::Close()
+{
+  if (mFile.is_open()) mFile.close();
+  mFile.clear();
+  mFileSize=0;
+  mChannelLength=0;
+  mFrameNumber=0;
+  mChannelIndex.clear();
+  mChannelOffset.clear();
+  mPayload.clear();
+}
+
+int TimeframeReader::NextFrame()
+{
+  if (!mFile.is_open()) return -EBADF;
+  unsigned header[kFrameHeaderSize/sizeof(unsigned)];
+  mFile.read((char*)header, kFrameHeaderSize);
+  if (mFile.gcount()==0 && mFile.eof()) return 0;
+  if (!mFile.good()) return -EIO;
+  unsigned nChannels=header[1];
+  unsigned payloadSize=header[2];
+  unsigned flags=header[3];
+  unsigned long long storedSize=0;
+  memcpy(&storedSize, header+4, sizeof(storedSize));
+  if ((flags&~kCompressed)!=0 ||
+      (!(flags&kCompressed) && storedSize!=payloadSize*sizeof(unsigned short))) {
+    return -EINVAL;
+  }
+  // the sizes are bound by the rest of the file and the channel length, a
+  // bunch of one sample takes three words
+  unsigned long long position=mFile.tellg();
+  unsigned long long available=position<mFileSize?mFileSize-position:0;
+  if (2*(unsigned long long)nChannels*sizeof(unsigned)+storedSize>available ||
+      payloadSize>2*(unsigned long long)nChannels*mChannelLength) {
+    return -EINVAL;
+  }
+  mFrameNumber=header[0];
+  mChannelIndex.resize(nChannels);
+  mChannelOffset.resize(nChannels);
+  mPayload.resize(payloadSize);
+  if (nChannels>0) {
+    mFile.read((char*)&mChannelIndex[0], nChannels*sizeof(unsigned));
+    mFile.read((char*)&mChannelOffset[0], nChannels*sizeof(unsigned));
+  }
+  if (flags&kCompressed) {
+    mStored.resize(storedSize);
+    if (storedSize>0) mFile.read((char*)&mStored[0], storedSize);
+    const unsigned char* source=mStored.empty()?NULL:&mStored[0];
+    const unsigned char* end=source+storedSize;
+    unsigned previous=0;
+    for (unsigned i=0; i<payloadSize; i++) {
+      unsigned value=0;
+      for (unsigned shift=0; ; shift+=7) {
+	if (source>=end || shift>28) return -EINVAL;
+	value|=(unsigned)(*source&0x7f)<<shift;
+	if ((*source++&0x80)==0) break;
+      }
+      int difference=(value&1)?-(int)((value+1)/2):(int)(value/2);
+      previous=(unsigned short)(previous+difference);
+      mPayload[i]=previous;
+    }
+  } else if (payloadSize>0) {
+    mFile.read((char*)&mPayload[0], storedSize);
+  }
+  unsigned long long recordSize=kFrameHeaderSize+2*nChannels*sizeof(unsigned)+storedSize;
+  mFile.ignore(Padding(recordSize));
+  if (!mFile.good()) return -EIO;
+  for (unsigned i=0; i<nChannels; i++) {
+    if (mChannelOffset[i]>payloadSize) return -EINVAL;
+  }
+  return 1;
+}
+
+const unsigned short* TimeframeReader::GetChannelData(unsigned channel, unsigned& size) const
+{
+  size=0;
+  if (channel>=mChannelIndex.size()) return NULL;
+  unsigned end=channel+1<mChannelOffset.size()?mChannelOffset[channel+1]:mPayload.size();
+  if (end<mChannelOffset[channel]) return NULL;
+  size=end-mChannelOffset[channel];
+  return size>0?&mPayload[mChannelOffset[channel]]:NULL;
+}
+
+int TimeframeReader::GetDenseChannel(unsigned channel, unsigned short* samples, unsigned short voidSample) const
+{
+  for (unsigned i=0; i<mChannelLength; i++) samples[i]=voidSample;
+  unsigned size=0;
+  const unsigned short* data=GetChannelData(channel, size);
+  int nFilled=0;
+  for (unsigned position=0; position+2<=size; position+=2+data[position+1]) {
+    unsigned startTime=data[position];
+    unsigned length=data[position+1];
+    if (position+2+length>size || length>startTime+1 || startTime>=mChannelLength) return -EINVAL;
+    for (unsigned i=0; i<length; i++) {
+      samples[startTime-i]=data[position+2+i];
+    }
+    nFilled+=length;
+  }
+  return nFilled;
+}
@@ -0,0 +1,242 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   TimeframeFile.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Binary file format for merged timeframes
+
+#ifndef TIMEFRAMEFILE_H
+#define TIMEFRAMEFILE_H
+
+#include <vector>
+#include <fstream>
+
+/**
+ * @class TimeframeFile
+ * Binary format of a sequence of timeframes.
+ *
+ * A file holds any number of frames, written and read sequentially. Every
+ * frame starts with the channel index header followed by the bunch encoded
+ * payload of all channels. The bunches of a channel are stored as in
+ * DecodedEvent, the first signal belongs to the start timebin and the
+ * following signals to decreasing timebins:
+ * <pre>
+ * startTime length signal[0] ... signal[length-1]
+ * </pre>
+ *
+ * File layout, all numbers in native byte order, records aligned to 8 byte:
+ * <pre>
+ * header:       char magic[8] "TPCTFBIN"
+ *               uint32 version, uint32 channel length
+ * frame record: uint32 frame number, uint32 nChannels, uint32 payloadSize, uint32 flags
+ *               uint64 size of the stored payload in byte
+ *               uint32 channelIndex[nChannels]  DDL number << 16 | HW address
+ *               uint32 channelOffset[nChannels] payload offset of the channel
+ *               stored payload, payloadSize uint16 words or compressed
+ * </pre>
+ *
+ * With flag kCompressed, the payload words are stored as difference to the
+ * previous word, zigzag and variable length encoded with 7 bit per byte.
+ * Signals of a bunch differ little and mostly require one byte.
+ */
+class TimeframeFile {
+ public:
+  static const char* kMagic;
+  static const unsigned kVersion=1;
+
+  enum {
+    /// payload compressed by difference and variable length encoding
+    kCompressed=0x1
+  };
+
+  /// check file name for timeframe file extension ".tfbin"
+  static bool IsTimeframeFile(const char* filename);
+
+ protected:
+  /// size of the file header
+  static const unsigned kHeaderSize=16;
+  /// size of the header of a frame record
+  static const unsigned kFrameHeaderSize=24;
+};
+
+/**
+ * @class TimeframeWriter
+ * Writer for TimeframeFile files.
+ *
+ * The channels of a frame are added between StartFrame and FinishFrame,
+ * the frame is encoded in memory and written with a few large writes.
+ */
+class TimeframeWriter : public TimeframeFile {
+ public:
+  TimeframeWriter();
+  ~TimeframeWriter();
+
+  /**
+   * Create the file.
+   * @param filename       file name
+   * @param channelLength  number of timebins of the channels
+   * @param flags          kCompressed to compress the frames
+   * @return 0 on success, negative error code if failed
+   */
+  int Open(const char* filename, unsigned channelLength, unsigned flags=0);
+
+  /// check if a file is open
+  bool IsOpen() const {return mFile.is_open();}
+
+  /**
+   * Start a new frame.
+   * @param frameNumber    number of the frame stored in the record
+   * @return 0 on success, negative error code if failed
+   */
+  int StartFrame(unsigned frameNumber);
+
+  /**
+   * Add a channel to the current frame.
+   * @param index    channel index composed out of DDL number and HW address
+   * @param data     bunch encoded channel data
+   * @param size     number of words
+   */
+  void AddChannel(unsigned index, const unsigned short* data, unsigned size);
+
+  /**
+   * Add a channel to the current frame from dense samples.
+   * Timebins with the void value are not stored.
+   * @param index    channel index composed out of DDL number and HW address
+   * @param samples  samples of all timebins of the channel
+   * @param size     number of timebins
+   * @param voidSample value of timebins without signal
+   */
+  void AddDenseChannel(unsigned index, const unsigned short* samples, unsigned size,
+		       unsigned short voidSample=0xffff);
+
+  /**
+   * Write the current frame.
+   * @return 0 on success, negative error code if failed
+   */
+  int FinishFrame();
+
+  /**
+   * Close the file.
+   * @return number of written frames, negative error code if failed
+   */
+  int Close();
+
+  /// number of written frames
+  unsigned GetNFrames() const {return mNFrames;}
+
+ private:
+  /// copy constructor prohibited
+  TimeframeWriter(const TimeframeWriter&);
+  /// assignment operator prohibited
+  TimeframeWriter& operator=(const TimeframeWriter&);
+
+  /// output file
+  std::ofstream mFile;
+  /// flags of the frames
+  unsigned mFlags;
+  /// number of the current frame
+  unsigned mFrameNumber;
+  /// number of written frames
+  unsigned mNFrames;
+  /// channel indices of the current frame
+  std::vector<unsigned> mChannelIndex;
+  /// payload offsets of the channels of the current frame
+  std::vector<unsigned> mChannelOffset;
+  /// payload of the current frame
+  std::vector<unsigned short> mPayload;
+  /// compressed payload
+  std::vector<unsigned char> mCompressed;
+};
+
+/**
+ * @class TimeframeReader
+ * Sequential reader for TimeframeFile files.
+ *
+ * NextFrame reads the next frame into the buffers of the reader, the
+ * channel data stays valid until the next frame is read.
+ */
+class TimeframeReader : public TimeframeFile {
+ public:
+  TimeframeReader();
+  ~TimeframeReader();
+
+  /**
+   * Open a file and read the header.
+   * @return 0 on success, negative error code if failed
+   */
+  int Open(const char* filename);
+
+  /// close the file
+  void Close();
+
+  /**
+   * Read the next frame.
+   * @return 1 if a frame was read, 0 at the end of the file, negative
+   *         error code if failed
+   */
+  int NextFrame();
+
+  /// number of timebins of the channels
+  unsigned GetChannelLength() const {return mChannelLength;}
+
+  /// number of the current frame
+  unsigned GetFrameNumber() const {return mFrameNumber;}
+
+  /// number of channels of the current frame
+  unsigned GetNChannels() const {return mChannelIndex.size();}
+
+  /// channel index of a channel
+  unsigned GetChannelIndex(unsigned channel) const {return mChannelIndex[channel];}
+
+  /**
+   * Bunch encoded data of a channel.
+   * @param channel  channel number in the frame
+   * @param size     target to receive the number of words
+   */
+  const unsigned short* GetChannelData(unsigned channel, unsigned& size) const;
+
+  /**
+   * Fill the samples of all timebins of a channel.
+   * @param channel    channel number in the frame
+   * @param samples    target array of GetChannelLength timebins
+   * @param voidSample value of timebins without signal
+   * @return number of timebins with signal
+   */
+  int GetDenseChannel(unsigned channel, unsigned short* samples, unsigned short voidSample=0xffff) const;
+
+ private:
+  /// copy constructor prohibited
+  TimeframeReader(const TimeframeReader&);
+  /// assignment operator prohibited
+  TimeframeReader& operator=(const TimeframeReader&);
+
+  /// input file
+  std::ifstream mFile;
+  /// size of the input file
+  unsigned long long mFileSize;
+  /// number of timebins of the channels
+  unsigned mChannelLength;
+  /// number of the current frame
+  unsigned mFrameNumber;
+  /// channel indices of the current frame
+  std::vector<unsigned> mChannelIndex;
+  /// payload offsets of the channels of the current frame
+  std::vector<unsigned> mChannelOffset;
+  /// payload of the current frame
+  std::vector<unsigned short> mPayload;
+  /// stored payload
+  std::vector<unsigned char> mStored;
+};
+#endif
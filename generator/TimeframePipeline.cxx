@@ -0,0 +1,153 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   TimeframePipeline.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Pipeline for merging and processing of timeframes in parallel
+//  @note   requires C++11 standard
+
+#include "TimeframePipeline.h"
+#include "ChannelMerger.h"
+#include <vector>
+#include <deque>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct TimeframePipeline::Context {
+  Context(processor_t _processor, void* _parameter)
+    : processor(_processor), parameter(_parameter), slots(), freeSlots(), queue()
+    , processing(), thread(), mutex(), changed(), error(0), busy(false), stop(false)
+  {}
+
+  /// processing function
+  processor_t processor;
+  /// parameter of the processing function
+  void* parameter;
+  /// buffer slots holding timeframes waiting for processing
+  std::vector<ChannelMerger*> slots;
+  /// slots available for the next timeframe
+  std::vector<ChannelMerger*> freeSlots;
+  /// timeframes waiting for processing
+  std::deque<std::pair<ChannelMerger*, void*> > queue;
+  /// merger processing the timeframes
+  ChannelMerger processing;
+  /// the processing thread
+  std::thread thread;
+  /// protection of queue and state
+  std::mutex mutex;
+  /// signals change of queue or state
+  std::condition_variable changed;
+  /// first error
+  int error;
+  /// a timeframe is being processed
+  bool busy;
+  /// stop the processing thread
+  bool stop;
+};
+
+TimeframePipeline::TimeframePipeline(processor_t processor, void* parameter, unsigned nSlots)
+  : mContext(new Context(processor, parameter))
+{
+  if (nSlots==0) nSlots=1;
+  for (unsigned i=0; i<nSlots; i++) {
+    mContext->slots.push_back(new ChannelMerger);
+  }
+  mContext->freeSlots=mContext->slots;
+  mContext->thread=std::thread(&TimeframePipeline::Process, this);
+}
+
+TimeframePipeline::~TimeframePipeline()
+{
+  Flush();
+  {
+    std::lock_guard<std::mutex> lock(mContext->mutex);
+    mContext->stop=true;
+  }
+  mContext->changed.notify_all();
+  mContext->thread.join();
+  for (std::vector<ChannelMerger*>::iterator slot=mContext->slots.begin();
+       slot!=mContext->slots.end(); slot++) {
+    delete *slot;
+  }
+  delete mContext;
+  mContext=NULL;
+}
+
+int TimeframePipeline::Push(ChannelMerger& merger, void* timeframe)
+{
+  ChannelMerger* slot=NULL;
+  {
+    std::unique_lock<std::mutex> lock(mContext->mutex);
+    mContext->changed.wait(lock, [this] {return !mContext->freeSlots.empty() || mContext->error<0;});
+    if (mContext->error<0) return mContext->error;
+    slot=mContext->freeSlots.back();
+    mContext->freeSlots.pop_back();
+  }
+  // the slot is not accessed by the processing thread until queued
+  int result=merger.MoveTimeframe(*slot);
+  {
+    std::lock_guard<std::mutex> lock(mContext->mutex);
+    if (result<0) {
+      mContext->freeSlots.push_back(slot);
+      return result;
+    }
+    mContext->queue.push_back(std::make_pair(slot, timeframe));
+  }
+  mContext->changed.notify_all();
+  return 0;
+}
+
+int TimeframePipeline::Flush()
+{
+  std::unique_lock<std::mutex> lock(mContext->mutex);
+  mContext->changed.wait(lock, [this] {return mContext->queue.empty() && !mContext->busy;});
+  return mContext->error;
+}
+
+ChannelMerger& TimeframePipeline::GetProcessingMerger()
+{
+  return mContext->processing;
+}
+
+void TimeframePipeline::Process()
+{
+  while (true) {
+    std::pair<ChannelMerger*, void*> item;
+    {
+      std::unique_lock<std::mutex> lock(mContext->mutex);
+      mContext->changed.wait(lock, [this] {return !mContext->queue.empty() || mContext->stop;});
+      if (mContext->queue.empty()) return;
+      item=mContext->queue.front();
+      mContext->queue.pop_front();
+      mContext->busy=true;
+    }
+    int result=item.first->MoveTimeframe(mContext->processing);
+    {
+      std::lock_guard<std::mutex> lock(mContext->mutex);
+      mContext->freeSlots.push_back(item.first);
+    }
+    mContext->changed.notify_all();
+    // the processing function is called for every timeframe, it might
+    // own the timeframe parameter
+    int processed=(*mContext->processor)(mContext->processing, mContext->parameter, item.second);
+    if (result>=0) result=processed;
+    {
+      std::lock_guard<std::mutex> lock(mContext->mutex);
+      if (result<0 && mContext->error==0) mContext->error=result;
+      mContext->busy=false;
+    }
+    mContext->changed.notify_all();
+  }
+}
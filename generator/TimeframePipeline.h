@@ -0,0 +1,112 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   TimeframePipeline.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Pipeline for merging and processing of timeframes in parallel
+
+#ifndef TIMEFRAMEPIPELINE_H
+#define TIMEFRAMEPIPELINE_H
+
+class ChannelMerger;
+
+/**
+ * @class TimeframePipeline
+ * Overlap of merging and processing of timeframes.
+ *
+ * Merged timeframes are handed over to the pipeline by Push, the data is
+ * moved out of the merger into a free buffer slot and the merger can
+ * continue with the next timeframe immediately, see
+ * ChannelMerger::MoveTimeframe. A background thread processes the
+ * timeframes in order of pushing by calling the processor function with a
+ * merger holding the timeframe. All timeframes are processed by the same
+ * ChannelMerger instance, processing steps like Analyze or the output of
+ * data are serialized in the processing thread.
+ *
+ * The number of buffer slots defines how far merging can run ahead of
+ * processing: one slot gives double buffering, two slots triple buffering.
+ * Push blocks while all slots are occupied.
+ *
+ * The class does not use C++11 features in the header and can be used in
+ * macros, the thread is created in the implementation.
+ *
+ * Usage:
+ * <pre>
+ *   int Process(ChannelMerger& merger, void* parameter, void* timeframe);
+ *   TimeframePipeline pipeline(Process, &setup, 2);
+ *   while (...) {
+ *     merger.StartTimeframe();
+ *     merger.MergeCollisions(...);
+ *     pipeline.Push(merger, timeframeInfo);
+ *   }
+ *   pipeline.Flush();
+ * </pre>
+ */
+class TimeframePipeline {
+ public:
+  /**
+   * Processing function.
+   * @param merger     merger holding the timeframe
+   * @param parameter  parameter set in the constructor
+   * @param timeframe  timeframe specific parameter passed to Push
+   * @return 0 on success, negative error code stops the pipeline
+   */
+  typedef int (*processor_t)(ChannelMerger& merger, void* parameter, void* timeframe);
+
+  /**
+   * Constructor
+   * @param processor  processing function called in the processing thread
+   * @param parameter  parameter for all calls of the processing function
+   * @param nSlots     number of buffer slots, at least 1
+   */
+  TimeframePipeline(processor_t processor, void* parameter, unsigned nSlots=1);
+  /// destructor, waits for the processing of all pushed timeframes
+  ~TimeframePipeline();
+
+  /**
+   * Hand over the current timeframe of a merger for processing.
+   * Blocks until a buffer slot is available.
+   * @param merger     merger holding the timeframe, continues with the next one
+   * @param timeframe  parameter passed to the processing function
+   * @return 0 on success, error code of a failed processing or move
+   */
+  int Push(ChannelMerger& merger, void* timeframe=0);
+
+  /**
+   * Wait until all pushed timeframes are processed.
+   * @return 0 on success, error code of the first failed processing
+   */
+  int Flush();
+
+  /// the merger processing the timeframes, e.g. for final output
+  ChannelMerger& GetProcessingMerger();
+
+ private:
+  /// standard constructor prohibited
+  TimeframePipeline();
+  /// copy constructor prohibited
+  TimeframePipeline(const TimeframePipeline&);
+  /// assignment operator prohibited
+  TimeframePipeline& operator=(const TimeframePipeline&);
+
+  /// thread and queue, implementation uses C++11
+  struct Context;
+
+  /// loop of the processing thread
+  void Process();
+
+  Context* mContext;
+};
+#endif
@@ -0,0 +1,400 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ZeroSuppression.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Zero suppression kernels for the signal buffer of a channel
+
+#include "ZeroSuppression.h"
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ZEROSUPPRESSION_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ZEROSUPPRESSION_SSE2
+#endif
+
+namespace {
+  typedef uint64_t mask_t;
+  const unsigned kMaskBits=64;
+  /// masks of channels up to 4096 timebins are kept on the stack
+  const unsigned kStackWords=3*64;
+
+  /**
+   * Bit masks of one channel.
+   * Bit g corresponds to sample size-1-g, i.e. the bits are in processing
+   * order and the next signal to be processed is at bit g+1. Bits beyond
+   * the channel size are zero.
+   */
+  class ChannelMasks {
+  public:
+    ChannelMasks(unsigned size)
+      : mNWords((size+kMaskBits-1)/kMaskBits)
+      , mOver(mStack)
+      , mNonVoid(NULL)
+      , mKept(NULL)
+      , mHeap()
+    {
+      if (3*mNWords>kStackWords) {
+	mHeap.resize(3*mNWords);
+	mOver=&mHeap[0];
+      }
+      mNonVoid=mOver+mNWords;
+      mKept=mNonVoid+mNWords;
+      std::fill(mOver, mOver+3*mNWords, 0);
+    }
+
+    unsigned mNWords;
+    /// signals over threshold
+    mask_t* mOver;
+    /// signals different from the void signal
+    mask_t* mNonVoid;
+    /// signals kept by the zero suppression
+    mask_t* mKept;
+
+  private:
+    mask_t mStack[kStackWords];
+    std::vector<mask_t> mHeap;
+  };
+
+  /// the vectorized kernels support the baseline shift in the 16 bit range
+  bool IsBaselineShiftSupported(int baselineshift)
+  {
+    return baselineshift>=-0xffff && baselineshift<=0xffff;
+  }
+
+  /// threshold in the 16 bit range, no signal can be over 0xffff
+  unsigned short GetThreshold16(unsigned threshold)
+  {
+    return threshold<ZeroSuppression::kVoidSample?threshold:ZeroSuppression::kVoidSample;
+  }
+
+  /// baseline shift applied to a kept signal, truncated to the sample type
+  ZeroSuppression::sample_t ShiftSignal(unsigned signal, int baselineshift)
+  {
+    if (baselineshift<0) {
+      if ((int)signal>-baselineshift) signal-=-baselineshift;
+      else signal=0;
+    } else {
+      signal+=baselineshift;
+    }
+    return signal;
+  }
+
+  /// get n<=16 bits of a mask starting at bit
+  unsigned GetBits(const mask_t* mask, unsigned bit, unsigned n)
+  {
+    unsigned word=bit/kMaskBits;
+    unsigned offset=bit%kMaskBits;
+    mask_t bits=mask[word]>>offset;
+    if (offset+n>kMaskBits) bits|=mask[word+1]<<(kMaskBits-offset);
+    return bits&((1u<<n)-1);
+  }
+
+  /// set the masks for the samples from bit first to the end of the channel
+  void SetMasks(const ZeroSuppression::sample_t* buffer, unsigned size, unsigned threshold, unsigned first, ChannelMasks& masks)
+  {
+    for (unsigned g=first; g<size; g++) {
+      unsigned signal=buffer[size-1-g];
+      if (signal==ZeroSuppression::kVoidSample) continue;
+      mask_t bit=(mask_t)1<<(g%kMaskBits);
+      masks.mNonVoid[g/kMaskBits]|=bit;
+      if (signal>threshold) masks.mOver[g/kMaskBits]|=bit;
+    }
+  }
+
+  /**
+   * Apply the peak rules to the masks and set the mask of kept signals.
+   * A peak is active at bit g if it starts at g or if it was active at g-1
+   * and continues at g:
+   * <pre>
+   * peak[g] = start[g] | (continue[g] & peak[g-1])
+   * </pre>
+   * This is the carry of the addition continue+start, start is a subset
+   * of continue, so the peaks of a word are calculated from the carry bits
+   * of one addition. The carry into the next word is the peak state of the
+   * last bit.
+   * @return number of kept signals
+   */
+  int PropagatePeaks(ChannelMasks& masks)
+  {
+    int nKept=0;
+    mask_t carry=0;
+    for (unsigned w=0; w<masks.mNWords; w++) {
+      mask_t over=masks.mOver[w];
+      mask_t nonvoid=masks.mNonVoid[w];
+      mask_t nextOver=w+1<masks.mNWords?masks.mOver[w+1]:0;
+      mask_t nextNonVoid=w+1<masks.mNWords?masks.mNonVoid[w+1]:0;
+      // next and next to next signal in processing order
+      mask_t over1=(over>>1) | (nextOver<<(kMaskBits-1));
+      mask_t over2=(over>>2) | (nextOver<<(kMaskBits-2));
+      mask_t nonvoid1=(nonvoid>>1) | (nextNonVoid<<(kMaskBits-1));
+      // signal peak starts at two consecutive signals over threshold
+      mask_t start=over & over1;
+      // active peak continues at signals over threshold and at signals
+      // below threshold if next or next to next signal is over threshold
+      mask_t cont=over | over1 | (nonvoid1 & over2);
+      mask_t carries=(cont+start+carry)^cont^start;
+      mask_t peak=start | (cont & carries);
+      carry=peak>>(kMaskBits-1);
+      masks.mKept[w]=peak & nonvoid;
+      nKept+=__builtin_popcountll(masks.mKept[w]);
+    }
+    return nKept;
+  }
+
+  /**
+   * Write the kept signals of samples from first to the end of the channel.
+   * @return number of kept signals shifted to the void signal
+   */
+  int WriteSignals(const ZeroSuppression::sample_t* buffer, unsigned size, int baselineshift, const ChannelMasks& masks, unsigned first, ZeroSuppression::sample_t* target)
+  {
+    int nVoid=0;
+    for (unsigned i=first; i<size; i++) {
+      unsigned g=size-1-i;
+      if (((masks.mKept[g/kMaskBits]>>(g%kMaskBits))&1)==0) {
+	if (target) target[i]=ZeroSuppression::kVoidSample;
+	continue;
+      }
+      ZeroSuppression::sample_t signal=ShiftSignal(buffer[i], baselineshift);
+      if (signal==ZeroSuppression::kVoidSample) nVoid++;
+      if (target) target[i]=signal;
+    }
+    return nVoid;
+  }
+
+#if defined(ZEROSUPPRESSION_AVX2)
+  const unsigned kSIMDWidth=16;
+
+  /// set the masks for full vectors of samples
+  unsigned SetMasksSIMD(const ZeroSuppression::sample_t* buffer, unsigned size, unsigned threshold, ChannelMasks& masks)
+  {
+    const __m256i reverse=_mm256_setr_epi8(14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1,
+					   14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1);
+    const __m256i voidSignal=_mm256_set1_epi16((short)ZeroSuppression::kVoidSample);
+    const __m256i thresholdSignal=_mm256_set1_epi16((short)GetThreshold16(threshold));
+    const __m256i zero=_mm256_setzero_si256();
+    unsigned g=0;
+    for (; g+kSIMDWidth<=size; g+=kSIMDWidth) {
+      // load in processing order, lane l corresponds to bit g+l
+      __m256i signals=_mm256_loadu_si256((const __m256i*)(buffer+size-kSIMDWidth-g));
+      signals=_mm256_shuffle_epi8(signals, reverse);
+      signals=_mm256_permute4x64_epi64(signals, 0x4e);
+      __m256i isVoid=_mm256_cmpeq_epi16(signals, voidSignal);
+      __m256i notOver=_mm256_or_si256(isVoid, _mm256_cmpeq_epi16(_mm256_subs_epu16(signals, thresholdSignal), zero));
+      // bytes per 128 bit lane: signals not over threshold 0-7, void signals 0-7
+      unsigned bits=_mm256_movemask_epi8(_mm256_packs_epi16(notOver, isVoid));
+      unsigned notOverBits=(bits&0xff) | ((bits>>8)&0xff00);
+      unsigned voidBits=((bits>>8)&0xff) | ((bits>>16)&0xff00);
+      masks.mOver[g/kMaskBits]|=(mask_t)(~notOverBits&0xffff)<<(g%kMaskBits);
+      masks.mNonVoid[g/kMaskBits]|=(mask_t)(~voidBits&0xffff)<<(g%kMaskBits);
+    }
+    return g;
+  }
+
+  /// write full vectors of samples, return number of kept signals shifted to void
+  unsigned WriteSignalsSIMD(const ZeroSuppression::sample_t* buffer, unsigned size, int baselineshift, const ChannelMasks& masks, ZeroSuppression::sample_t* target, int& nVoid)
+  {
+    // lane l of a vector corresponds to bit 15-l of the mask section
+    const __m256i laneBits=_mm256_setr_epi16((short)0x8000,0x4000,0x2000,0x1000,0x800,0x400,0x200,0x100,
+					     0x80,0x40,0x20,0x10,0x8,0x4,0x2,0x1);
+    const __m256i voidSignal=_mm256_set1_epi16((short)ZeroSuppression::kVoidSample);
+    const __m256i shift=_mm256_set1_epi16((short)(baselineshift<0?-baselineshift:baselineshift));
+    unsigned i=0;
+    for (; i+kSIMDWidth<=size; i+=kSIMDWidth) {
+      unsigned bits=GetBits(masks.mKept, size-kSIMDWidth-i, kSIMDWidth);
+      __m256i kept=_mm256_and_si256(_mm256_set1_epi16((short)bits), laneBits);
+      kept=_mm256_cmpeq_epi16(kept, laneBits);
+      __m256i signals=_mm256_loadu_si256((const __m256i*)(buffer+i));
+      signals=baselineshift<0?_mm256_subs_epu16(signals, shift):_mm256_add_epi16(signals, shift);
+      if (baselineshift>0) {
+	__m256i shiftedToVoid=_mm256_and_si256(kept, _mm256_cmpeq_epi16(signals, voidSignal));
+	nVoid+=__builtin_popcount(_mm256_movemask_epi8(shiftedToVoid))/2;
+      }
+      if (target) {
+	signals=_mm256_or_si256(_mm256_and_si256(kept, signals), _mm256_andnot_si256(kept, voidSignal));
+	_mm256_storeu_si256((__m256i*)(target+i), signals);
+      }
+    }
+    return i;
+  }
+#elif defined(ZEROSUPPRESSION_SSE2)
+  const unsigned kSIMDWidth=8;
+
+  /// set the masks for full vectors of samples
+  unsigned SetMasksSIMD(const ZeroSuppression::sample_t* buffer, unsigned size, unsigned threshold, ChannelMasks& masks)
+  {
+    const __m128i voidSignal=_mm_set1_epi16((short)ZeroSuppression::kVoidSample);
+    const __m128i thresholdSignal=_mm_set1_epi16((short)GetThreshold16(threshold));
+    const __m128i zero=_mm_setzero_si128();
+    unsigned g=0;
+    for (; g+kSIMDWidth<=size; g+=kSIMDWidth) {
+      // load in processing order, lane l corresponds to bit g+l
+      __m128i signals=_mm_loadu_si128((const __m128i*)(buffer+size-kSIMDWidth-g));
+      signals=_mm_shufflelo_epi16(signals, 0x1b);
+      signals=_mm_shufflehi_epi16(signals, 0x1b);
+      signals=_mm_shuffle_epi32(signals, 0x4e);
+      __m128i isVoid=_mm_cmpeq_epi16(signals, voidSignal);
+      __m128i notOver=_mm_or_si128(isVoid, _mm_cmpeq_epi16(_mm_subs_epu16(signals, thresholdSignal), zero));
+      // bytes: signals not over threshold 0-7, void signals 0-7
+      unsigned bits=_mm_movemask_epi8(_mm_packs_epi16(notOver, isVoid));
+      masks.mOver[g/kMaskBits]|=(mask_t)(~bits&0xff)<<(g%kMaskBits);
+      masks.mNonVoid[g/kMaskBits]|=(mask_t)((~bits>>8)&0xff)<<(g%kMaskBits);
+    }
+    return g;
+  }
+
+  /// write full vectors of samples, return number of kept signals shifted to void
+  unsigned WriteSignalsSIMD(const ZeroSuppression::sample_t* buffer, unsigned size, int baselineshift, const ChannelMasks& masks, ZeroSuppression::sample_t* target, int& nVoid)
+  {
+    // lane l of a vector corresponds to bit 7-l of the mask section
+    const __m128i laneBits=_mm_setr_epi16(0x80,0x40,0x20,0x10,0x8,0x4,0x2,0x1);
+    const __m128i voidSignal=_mm_set1_epi16((short)ZeroSuppression::kVoidSample);
+    const __m128i shift=_mm_set1_epi16((short)(baselineshift<0?-baselineshift:baselineshift));
+    unsigned i=0;
+    for (; i+kSIMDWidth<=size; i+=kSIMDWidth) {
+      unsigned bits=GetBits(masks.mKept, size-kSIMDWidth-i, kSIMDWidth);
+      __m128i kept=_mm_and_si128(_mm_set1_epi16((short)bits), laneBits);
+      kept=_mm_cmpeq_epi16(kept, laneBits);
+      __m128i signals=_mm_loadu_si128((const __m128i*)(buffer+i));
+      signals=baselineshift<0?_mm_subs_epu16(signals, shift):_mm_add_epi16(signals, shift);
+      if (baselineshift>0) {
+	__m128i shiftedToVoid=_mm_and_si128(kept, _mm_cmpeq_epi16(signals, voidSignal));
+	nVoid+=__builtin_popcount(_mm_movemask_epi8(shiftedToVoid))/2;
+      }
+      if (target) {
+	signals=_mm_or_si128(_mm_and_si128(kept, signals), _mm_andnot_si128(kept, voidSignal));
+	_mm_storeu_si128((__m128i*)(target+i), signals);
+      }
+    }
+    return i;
+  }
+#endif
+}
+
+int ZeroSuppression::Apply(const sample_t* buffer, unsigned size, unsigned threshold, int baselineshift, sample_t* target)
+{
+  return ApplySIMD(buffer, size, threshold, baselineshift, target);
+}
+
+int ZeroSuppression::ApplyScalar(const sample_t* buffer, unsigned size, unsigned threshold, int baselineshift, sample_t* target)
+{
+  if (!buffer) return -1;
+  if (!IsBaselineShiftSupported(baselineshift)) {
+    return ApplyReference(buffer, size, threshold, baselineshift, target);
+  }
+  // the masks are complete before writing, target can be equal to buffer
+  ChannelMasks masks(size);
+  SetMasks(buffer, size, threshold, 0, masks);
+  int nFilledTimebins=PropagatePeaks(masks);
+  if (target || baselineshift>0) {
+    nFilledTimebins-=WriteSignals(buffer, size, baselineshift, masks, 0, target);
+  }
+  return nFilledTimebins;
+}
+
+int ZeroSuppression::ApplySIMD(const sample_t* buffer, unsigned size, unsigned threshold, int baselineshift, sample_t* target)
+{
+#if defined(ZEROSUPPRESSION_AVX2) || defined(ZEROSUPPRESSION_SSE2)
+  if (!buffer) return -1;
+  if (!IsBaselineShiftSupported(baselineshift)) {
+    return ApplyReference(buffer, size, threshold, baselineshift, target);
+  }
+  ChannelMasks masks(size);
+  unsigned first=SetMasksSIMD(buffer, size, threshold, masks);
+  SetMasks(buffer, size, threshold, first, masks);
+  int nFilledTimebins=PropagatePeaks(masks);
+  if (target || baselineshift>0) {
+    int nVoid=0;
+    first=WriteSignalsSIMD(buffer, size, baselineshift, masks, target, nVoid);
+    nVoid+=WriteSignals(buffer, size, baselineshift, masks, first, target);
+    nFilledTimebins-=nVoid;
+  }
+  return nFilledTimebins;
+#else
+  return ApplyScalar(buffer, size, threshold, baselineshift, target);
+#endif
+}
+
+const char* ZeroSuppression::GetSIMDKernelName()
+{
+#if defined(ZEROSUPPRESSION_AVX2)
+  return "avx2";
+#elif defined(ZEROSUPPRESSION_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+int ZeroSuppression::ApplyReference(const sample_t* buffer, unsigned size, unsigned threshold, int baselineshift, sample_t* target)
+{
+  if (!buffer) return -1;
+  unsigned nFilledTimebins=0;
+  bool bSignalPeak=false;
+  for (int i=size-1; i>=0; i--) {
+    unsigned currentSignal=buffer[i];
+    if (currentSignal == kVoidSample) {
+      currentSignal=0;
+    }
+
+    if (!bSignalPeak && currentSignal>threshold &&
+	i>=1 && buffer[i-1]>threshold && buffer[i-1]!=kVoidSample) {
+      // signal peak starts at two consecutive signals over threshold
+      bSignalPeak=true;
+    } else if (bSignalPeak && currentSignal>threshold) {
+      // signal belonging to active signal peak
+    } else if (bSignalPeak && currentSignal<=threshold) {
+      if ((i>=1 && buffer[i-1] != kVoidSample && buffer[i-1]>threshold) ||
+	  (i>=2 && buffer[i-1] != kVoidSample && buffer[i-2] != kVoidSample && buffer[i-2]>threshold)) {
+	// signal below threshold after peak, merged if next or
+	// next to next signal over threshold
+	// two signal peaks intercepted by one or two consecutive
+	// signals below threshold are merged
+      } else {
+	// signal below threshold after peak
+	bSignalPeak=false;
+	currentSignal=kVoidSample;
+      }
+    } else {
+      // suppress signal
+      currentSignal=kVoidSample;
+    }
+
+    if (currentSignal != kVoidSample) {
+      if (baselineshift<0) {
+	if ((int)currentSignal>-baselineshift) currentSignal-=-baselineshift;
+	else currentSignal=0;
+      } else {
+	// TODO: not sure if this makes sense
+	currentSignal+=baselineshift;
+      }
+    }
+
+    if (target) {
+      if (buffer[i] != kVoidSample) {
+	target[i] = currentSignal;
+      } else {
+	target[i] = kVoidSample;
+      }
+    }
+    if (currentSignal != kVoidSample && buffer[i] != kVoidSample) {
+      nFilledTimebins++;
+    }
+  }
+
+  return nFilledTimebins;
+}
@@ -0,0 +1,80 @@
+//-*- Mode: C++ -*-
+
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   ZeroSuppression.h
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Zero suppression kernels for the signal buffer of a channel
+
+#ifndef ZEROSUPPRESSION_H
+#define ZEROSUPPRESSION_H
+
+/**
+ * @class ZeroSuppression
+ * Zero suppression of the signal buffer of one channel.
+ *
+ * The channel is processed from the last timebin towards timebin 0, a
+ * signal peak starts at two consecutive signals over threshold. Signals
+ * below threshold are kept inside the peak if the next or the next to
+ * next signal is over threshold, i.e. peaks separated by one or two
+ * signals below threshold are merged. All other signals are suppressed
+ * and set to the void signal, the baseline shift is applied to the kept
+ * signals.
+ *
+ * Instead of processing sample by sample, the kernels calculate bit masks
+ * of the signals over threshold and of the non-void signals, the peak rules
+ * are applied to the masks with shifts and logical operations. The
+ * propagation of an active peak through consecutive signals is a carry
+ * propagation, calculated by a multi-word addition. The masks of signals
+ * are calculated with SSE2 or AVX2 instructions depending on the compiler
+ * flags, e.g. -mavx2, the scalar kernel is used on other architectures.
+ * All kernels give results identical to the sample by sample state machine
+ * of ApplyReference.
+ */
+class ZeroSuppression {
+ public:
+  typedef unsigned short sample_t;
+
+  /// value of timebins without signal
+  static const sample_t kVoidSample=0xffff;
+
+  /**
+   * Zero suppression with the best available kernel.
+   * @param buffer        signal buffer
+   * @param size          number of signals
+   * @param threshold     ZS threshold in ADC counts
+   * @param baselineshift baselineshift in ADC counts
+   * @param target        target buffer for ZS corrected values, optional,
+   *                      can be equal to the signal buffer
+   * @return number of filled timebins, negative error code if failed
+   */
+  static int Apply(const sample_t* buffer, unsigned size, unsigned threshold, int baselineshift, sample_t* target);
+
+  /// zero suppression with the portable bit mask kernel
+  static int ApplyScalar(const sample_t* buffer, unsigned size, unsigned threshold, int baselineshift, sample_t* target);
+
+  /// zero suppression with the vectorized kernel, scalar kernel if not available
+  static int ApplySIMD(const sample_t* buffer, unsigned size, unsigned threshold, int baselineshift, sample_t* target);
+
+  /// zero suppression sample by sample, reference for the kernels
+  static int ApplyReference(const sample_t* buffer, unsigned size, unsigned threshold, int baselineshift, sample_t* target);
+
+  /// name of the vectorized kernel, "scalar" if not available
+  static const char* GetSIMDKernelName();
+
+ private:
+  /// standard constructor prohibited, only static functions
+  ZeroSuppression();
+};
+#endif
@@ -0,0 +1,963 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   benchmarkMerger.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Standalone benchmark of the timeframe merging
+//  @note   requires C++11 standard
+
+// Merges collisions from a channel source into timeframes and reports the
+// throughput, no ROOT or AliRoot installation is required. The input is a
+// synthetic source or an event archive, see ChannelSource.
+//
+// Usage:
+//   benchmarkMerger [options]
+//     -i <input>        input source, default "synthetic:"
+//     -t <timeframes>   number of timeframes, default 10
+//     -r <rate>         collision rate wrt timeframe size, default 5
+//     -j <threads>      number of merging threads, default 0
+//     -z <threshold>    zero suppression threshold, default disabled
+//     -c <size>         size of the event cache in MB, default disabled
+//     -p <poolsize>     number of events for replay from the cache
+//     -o <filename>     write the last timeframe to file
+//     -s <seed>         seed of the collision distribution, default timestamp
+//     -l <length>       number of timebins per channel, default 1024
+//     -e <filename>     Huffman encode the timeframes, the code is generated
+//                       from the first timeframe, the last timeframe is
+//                       written to file; encoded data is decoded and checked
+//     -k                check the zero suppression, code length, signal
+//                       accumulation and channel kernels against the
+//                       reference implementation and measure throughput,
+//                       check the round trip of the timeframe file, the
+//                       event archive and the pedestal configuration and
+//                       the equivalence of the channel layouts
+
+#include "ChannelMerger.h"
+#include "ChannelSource.h"
+#include "CollisionDistribution.h"
+#include "ZeroSuppression.h"
+#include "CodeLengthTable.h"
+#include "SignalAccumulation.h"
+#include "ChannelMergerT.h"
+#include "HuffmanCoder.h"
+#include "TimeframeFile.h"
+#include "SampleStore.h"
+#include "EventArchive.h"
+#include "DecodedEvent.h"
+#include "PedestalEstimator.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+
+namespace {
+  void PrintUsage(const char* program)
+  {
+    std::cout << "usage: " << program << " [-i input] [-t timeframes] [-r rate] [-j threads]"
+	      << " [-z threshold] [-c cachesize] [-p poolsize] [-o filename] [-s seed] [-l length] [-e filename] [-k]" << std::endl;
+  }
+
+  typedef ZeroSuppression::sample_t sample_t;
+  typedef int (*zskernel_t)(const sample_t*, unsigned, unsigned, int, sample_t*);
+
+  /// random channel with bunches of signals separated by void signals
+  void FillChannel(std::vector<sample_t>& channel, std::default_random_engine& generator)
+  {
+    std::uniform_int_distribution<int> signal(0, 12);
+    std::uniform_int_distribution<int> peak(0, 900);
+    std::uniform_int_distribution<int> length(1, 40);
+    std::bernoulli_distribution isVoid(0.3);
+    std::bernoulli_distribution isPeak(0.2);
+    for (unsigned i=0; i<channel.size();) {
+      bool bVoid=isVoid(generator);
+      bool bPeak=isPeak(generator);
+      for (unsigned n=length(generator); n>0 && i<channel.size(); n--, i++) {
+	channel[i]=bVoid?ZeroSuppression::kVoidSample:(bPeak?peak(generator):signal(generator));
+      }
+    }
+  }
+
+  /// compare a kernel to the reference for out-of-place, in-place and count only mode
+  bool CompareKernel(zskernel_t kernel, const std::vector<sample_t>& channel, unsigned threshold, int baselineshift)
+  {
+    unsigned size=channel.size();
+    std::vector<sample_t> reference(size);
+    std::vector<sample_t> target(size);
+    int nReference=ZeroSuppression::ApplyReference(&channel[0], size, threshold, baselineshift, &reference[0]);
+    if ((*kernel)(&channel[0], size, threshold, baselineshift, &target[0])!=nReference || target!=reference) return false;
+    target=channel;
+    if ((*kernel)(&target[0], size, threshold, baselineshift, &target[0])!=nReference || target!=reference) return false;
+    if ((*kernel)(&channel[0], size, threshold, baselineshift, NULL)!=nReference) return false;
+    return true;
+  }
+
+  /**
+   * Check the zero suppression kernels against the reference and measure
+   * the throughput.
+   * @return number of mismatches
+   */
+  int CheckZeroSuppression()
+  {
+    const char* names[]={"reference", "scalar", ZeroSuppression::GetSIMDKernelName()};
+    zskernel_t kernels[]={ZeroSuppression::ApplyReference, ZeroSuppression::ApplyScalar, ZeroSuppression::ApplySIMD};
+    const unsigned nKernels=sizeof(kernels)/sizeof(kernels[0]);
+    const unsigned sizes[]={1, 2, 3, 7, 8, 15, 16, 17, 63, 64, 65, 127, 1000, 1024, 5000};
+    const unsigned thresholds[]={0, 1, 2, 5, 10, 1000, 0xfffe, 0xffff, 0x10000};
+    const int baselineshifts[]={0, -1, -5, -1000, 2, 5, 0xfff0, 0xffff, 0x10000, -0x10000};
+    std::default_random_engine generator(1);
+    int nMismatches=0;
+    int nChecks=0;
+    for (unsigned s=0; s<sizeof(sizes)/sizeof(sizes[0]); s++) {
+      std::vector<sample_t> channel(sizes[s]);
+      for (int iteration=0; iteration<20; iteration++) {
+	FillChannel(channel, generator);
+	for (unsigned t=0; t<sizeof(thresholds)/sizeof(thresholds[0]); t++) {
+	  for (unsigned b=0; b<sizeof(baselineshifts)/sizeof(baselineshifts[0]); b++) {
+	    for (unsigned k=1; k<nKernels; k++) {
+	      nChecks++;
+	      if (CompareKernel(kernels[k], channel, thresholds[t], baselineshifts[b])) continue;
+	      if (nMismatches++<10) {
+		std::cerr << "mismatch of kernel " << names[k] << ": size " << sizes[s]
+			  << " threshold " << thresholds[t] << " baselineshift " << baselineshifts[b] << std::endl;
+	      }
+	    }
+	  }
+	}
+      }
+    }
+    std::cout << "zero suppression: " << nChecks << " check(s), " << nMismatches << " mismatch(es)" << std::endl;
+
+    const unsigned channelLength=1024;
+    const unsigned nChannels=1000;
+    const int nRepetitions=20;
+    std::vector<sample_t> channels(channelLength*nChannels);
+    std::vector<sample_t> target(channelLength);
+    for (unsigned c=0; c<nChannels; c++) {
+      std::vector<sample_t> channel(channelLength);
+      FillChannel(channel, generator);
+      std::copy(channel.begin(), channel.end(), channels.begin()+c*channelLength);
+    }
+    for (unsigned k=0; k<nKernels; k++) {
+      std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+      long nFilled=0;
+      for (int r=0; r<nRepetitions; r++) {
+	for (unsigned c=0; c<nChannels; c++) {
+	  nFilled+=(*kernels[k])(&channels[c*channelLength], channelLength, 2, -1, &target[0]);
+	}
+      }
+      std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+      double size=(double)nRepetitions*channels.size()*sizeof(sample_t)/(1024*1024);
+      std::cout << "  " << std::setw(10) << std::left << names[k] << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(10) << size/time.count() << " MB/s  (" << nFilled << " filled timebins)" << std::endl;
+    }
+    return nMismatches;
+  }
+
+  /**
+   * Check the vectorized kernels of the code length table against the
+   * scalar versions and measure the throughput.
+   * @return number of mismatches
+   */
+  int CheckCodeLengthTable()
+  {
+    const unsigned signalRange=1024;
+    const unsigned cutoffLengths[]={0, 6, 12};
+    const unsigned sizes[]={1, 7, 8, 9, 15, 16, 17, 1000, 1024};
+    std::default_random_engine generator(2);
+    std::uniform_int_distribution<int> length(1, 20);
+    std::uniform_int_distribution<int> symbol(0, 0xffff);
+    int nMismatches=0;
+    int nChecks=0;
+    for (unsigned c=0; c<sizeof(cutoffLengths)/sizeof(cutoffLengths[0]); c++) {
+      CodeLengthTable table(2*signalRange, cutoffLengths[c], 10);
+      for (unsigned i=0; i<table.GetNSymbols(); i++) table.SetCodeLength(i, length(generator));
+      for (unsigned s=0; s<sizeof(sizes)/sizeof(sizes[0]); s++) {
+	std::vector<sample_t> channel(sizes[s]);
+	std::vector<sample_t> symbols(sizes[s]);
+	std::vector<sample_t> reference(sizes[s]);
+	for (int iteration=0; iteration<20; iteration++) {
+	  nChecks++;
+	  FillChannel(channel, generator);
+	  if (iteration%4==0) {
+	    // signals exceeding the range
+	    for (unsigned i=0; i<channel.size(); i+=3) channel[i]=symbol(generator);
+	  }
+	  CodeLengthTable::DeltaSymbolsScalar(&channel[0], channel.size(), signalRange, &reference[0]);
+	  CodeLengthTable::DeltaSymbols(&channel[0], channel.size(), signalRange, &symbols[0]);
+	  if (iteration%5==0) {
+	    // symbols outside of the alphabet
+	    symbols[0]=reference[0]=symbol(generator);
+	  }
+	  if (symbols!=reference ||
+	      table.BitCount(&symbols[0], symbols.size())!=table.BitCountScalar(&reference[0], reference.size())) {
+	    if (nMismatches++<10) {
+	      std::cerr << "mismatch of code length kernel: size " << sizes[s] << " cutoff " << cutoffLengths[c] << std::endl;
+	    }
+	  }
+	}
+      }
+    }
+    std::cout << "code length table: " << nChecks << " check(s), " << nMismatches << " mismatch(es)" << std::endl;
+
+    const unsigned channelLength=1024;
+    const unsigned nChannels=1000;
+    const int nRepetitions=20;
+    CodeLengthTable table(2*signalRange, 12, 10);
+    for (unsigned i=0; i<table.GetNSymbols(); i++) table.SetCodeLength(i, length(generator));
+    std::vector<sample_t> channels(channelLength*nChannels);
+    std::vector<sample_t> symbols(channelLength);
+    for (unsigned c=0; c<nChannels; c++) {
+      std::vector<sample_t> channel(channelLength);
+      FillChannel(channel, generator);
+      std::copy(channel.begin(), channel.end(), channels.begin()+c*channelLength);
+    }
+    const char* names[]={"scalar", CodeLengthTable::GetSIMDKernelName()};
+    for (unsigned k=0; k<2; k++) {
+      std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+      unsigned long nBits=0;
+      for (int r=0; r<nRepetitions; r++) {
+	for (unsigned c=0; c<nChannels; c++) {
+	  if (k==0) {
+	    CodeLengthTable::DeltaSymbolsScalar(&channels[c*channelLength], channelLength, signalRange, &symbols[0]);
+	    nBits+=table.BitCountScalar(&symbols[0], channelLength);
+	  } else {
+	    CodeLengthTable::DeltaSymbols(&channels[c*channelLength], channelLength, signalRange, &symbols[0]);
+	    nBits+=table.BitCount(&symbols[0], channelLength);
+	  }
+	}
+      }
+      std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+      double size=(double)nRepetitions*channels.size()*sizeof(sample_t)/(1024*1024);
+      std::cout << "  " << std::setw(10) << std::left << names[k] << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(10) << size/time.count() << " MB/s  (" << nBits << " bits)" << std::endl;
+    }
+    return nMismatches;
+  }
+
+  /**
+   * Compare the vectorized signal accumulation to the scalar kernel for
+   * random samples of type T, samples close to the maximum signal saturate.
+   * @return number of mismatches
+   */
+  template<typename T>
+  int CompareSignalAccumulation(std::default_random_engine& generator, T maxSignal, const char* name, int& nChecks)
+  {
+    const unsigned sizes[]={1, 3, 4, 7, 8, 15, 16, 17, 31, 32, 100};
+    std::uniform_int_distribution<int> signal(0, 1023);
+    std::uniform_int_distribution<int> kind(0, 3);
+    std::uniform_int_distribution<int> distance(0, 2000);
+    int nMismatches=0;
+    for (unsigned s=0; s<sizeof(sizes)/sizeof(sizes[0]); s++) {
+      std::vector<sample_t> signals(sizes[s]);
+      std::vector<sample_t> first(sizes[s]);
+      std::vector<T> samples(sizes[s]);
+      for (int iteration=0; iteration<200; iteration++) {
+	for (unsigned i=0; i<sizes[s]; i++) {
+	  signals[i]=signal(generator);
+	  first[i]=signal(generator);
+	  switch (kind(generator)) {
+	  case 0: samples[i]=maxSignal+1; break;
+	  case 1: samples[i]=maxSignal-distance(generator); break;
+	  default: samples[i]=signal(generator);
+	  }
+	}
+	std::vector<T> reference(samples);
+	nChecks++;
+	unsigned nReference=SignalAccumulation::AddScalar(&reference[0], &signals[0], &first[0], sizes[s]);
+	if (SignalAccumulation::AddSIMD(&samples[0], &signals[0], &first[0], sizes[s])!=nReference || samples!=reference) {
+	  if (nMismatches++<10) {
+	    std::cerr << "mismatch of " << name << " accumulation kernel: size " << sizes[s] << std::endl;
+	  }
+	}
+      }
+    }
+    return nMismatches;
+  }
+
+  /**
+   * Check the vectorized signal accumulation against the scalar kernel and
+   * measure the throughput.
+   * @return number of mismatches
+   */
+  int CheckSignalAccumulation()
+  {
+    std::default_random_engine generator(3);
+    int nChecks=0;
+    int nMismatches=CompareSignalAccumulation<SignalAccumulation::sample_t>(generator, SignalAccumulation::kMaxSignal, "16 bit", nChecks);
+    nMismatches+=CompareSignalAccumulation<SignalAccumulation::wide_sample_t>(generator, SignalAccumulation::kWideMaxSignal, "32 bit", nChecks);
+    std::cout << "signal accumulation: " << nChecks << " check(s), " << nMismatches << " mismatch(es)" << std::endl;
+
+    // accumulation of segments of one block as in the merging
+    const unsigned segmentLength=32;
+    const unsigned nSegments=32*1000;
+    const int nRepetitions=50;
+    std::vector<sample_t> signals(segmentLength*nSegments);
+    std::vector<sample_t> first(segmentLength*nSegments);
+    for (unsigned i=0; i<signals.size(); i++) {
+      signals[i]=generator()%20;
+      first[i]=generator()%20;
+    }
+    std::vector<SignalAccumulation::sample_t> samples(signals.size());
+    std::vector<SignalAccumulation::wide_sample_t> wideSamples(signals.size());
+    const std::string simd=SignalAccumulation::GetSIMDKernelName();
+    const std::string names[]={"scalar", simd, "scalar 32", simd+" 32"};
+    for (unsigned k=0; k<4; k++) {
+      std::fill(samples.begin(), samples.end(), SignalAccumulation::kVoidSample);
+      std::fill(wideSamples.begin(), wideSamples.end(), SignalAccumulation::kWideVoidSample);
+      std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+      unsigned long nOverflows=0;
+      for (int r=0; r<nRepetitions; r++) {
+	for (unsigned i=0; i<signals.size(); i+=segmentLength) {
+	  switch (k) {
+	  case 0: nOverflows+=SignalAccumulation::AddScalar(&samples[i], &signals[i], &first[i], segmentLength); break;
+	  case 1: nOverflows+=SignalAccumulation::AddSIMD(&samples[i], &signals[i], &first[i], segmentLength); break;
+	  case 2: nOverflows+=SignalAccumulation::AddScalar(&wideSamples[i], &signals[i], &first[i], segmentLength); break;
+	  default: nOverflows+=SignalAccumulation::AddSIMD(&wideSamples[i], &signals[i], &first[i], segmentLength);
+	  }
+	}
+      }
+      std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+      double size=(double)nRepetitions*signals.size()*sizeof(sample_t)/(1024*1024);
+      std::cout << "  " << std::setw(10) << std::left << names[k] << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(10) << size/time.count() << " MB/s  (" << nOverflows << " overflows)" << std::endl;
+    }
+    return nMismatches;
+  }
+
+  /// compare the channel kernels of two instantiations for one channel
+  bool CompareChannelKernels(const ChannelKernels& kernels, const ChannelKernels& reference, const std::vector<sample_t>& channel)
+  {
+    unsigned size=channel.size();
+    std::vector<unsigned> bunchLength(size), bunchTime(size), referenceLength(size), referenceTime(size);
+    unsigned nBunches=kernels.FindBunches(&channel[0], size, &bunchLength[0], &bunchTime[0]);
+    if (nBunches!=reference.FindBunches(&channel[0], size, &referenceLength[0], &referenceTime[0])) return false;
+    if (!std::equal(bunchLength.begin(), bunchLength.begin()+nBunches, referenceLength.begin()) ||
+	!std::equal(bunchTime.begin(), bunchTime.begin()+nBunches, referenceTime.begin())) return false;
+
+    ChannelSignalStatistics statistics, referenceStatistics;
+    kernels.CalculateStatistics(&channel[0], size, statistics, &bunchLength[0]);
+    reference.CalculateStatistics(&channel[0], size, referenceStatistics, &referenceLength[0]);
+    if (memcmp(&statistics, &referenceStatistics, sizeof(statistics))!=0 ||
+	!std::equal(bunchLength.begin(), bunchLength.begin()+statistics.NBunches, referenceLength.begin())) return false;
+
+    std::vector<unsigned> cmSignal(size, 70000), referenceCMSignal(size, 70000);
+    kernels.AddCommonMode(&channel[0], size, &cmSignal[0]);
+    reference.AddCommonMode(&channel[0], size, &referenceCMSignal[0]);
+    if (cmSignal!=referenceCMSignal) return false;
+
+    std::vector<unsigned> cmScaled(size);
+    for (unsigned i=0; i<size; i++) cmScaled[i]=(cmSignal[i]-70000)/3;
+    std::vector<sample_t> signal(channel), referenceSignal(channel);
+    for (unsigned i=0; i<size; i++) {
+      if (signal[i]==ZeroSuppression::kVoidSample) signal[i]=referenceSignal[i]=i%50;
+    }
+    if (kernels.SubtractCommonMode(&signal[0], size, &cmScaled[0])!=
+	reference.SubtractCommonMode(&referenceSignal[0], size, &cmScaled[0]) ||
+	signal!=referenceSignal) return false;
+    return true;
+  }
+
+  /**
+   * Check the channel kernels specialized on the channel length against the
+   * generic instantiation and measure the throughput.
+   * @return number of mismatches
+   */
+  int CheckChannelKernels()
+  {
+    std::default_random_engine generator(4);
+    const ChannelKernels& generic=ChannelMergerT<0>::GetKernels();
+    const unsigned lengths[]={1024, 1021};
+    int nChecks=0;
+    int nMismatches=0;
+    for (unsigned l=0; l<sizeof(lengths)/sizeof(lengths[0]); l++) {
+      const ChannelKernels& kernels=SelectChannelKernels(lengths[l]);
+      if (kernels.length!=lengths[l]) nMismatches++;
+      std::vector<sample_t> channel(lengths[l]);
+      for (int n=0; n<200; n++, nChecks++) {
+	FillChannel(channel, generator);
+	if (!CompareChannelKernels(kernels, generic, channel)) nMismatches++;
+      }
+    }
+    std::cout << "channel kernels: " << nChecks << " check(s), " << nMismatches << " mismatch(es)" << std::endl;
+
+    const unsigned channelLength=1024;
+    const int nRepetitions=20;
+    std::vector<std::vector<sample_t> > channels(1000, std::vector<sample_t>(channelLength));
+    for (unsigned i=0; i<channels.size(); i++) FillChannel(channels[i], generator);
+    std::vector<unsigned> bunchLength(channelLength), bunchTime(channelLength);
+    std::vector<unsigned> cmSignal(channelLength, 0);
+    const ChannelKernels* kernels[]={&generic, &SelectChannelKernels(channelLength)};
+    const char* names[]={"generic", "1024"};
+    for (unsigned k=0; k<2; k++) {
+      std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+      unsigned long nBunches=0;
+      for (int r=0; r<nRepetitions; r++) {
+	for (unsigned i=0; i<channels.size(); i++) {
+	  ChannelSignalStatistics statistics;
+	  kernels[k]->CalculateStatistics(&channels[i][0], channelLength, statistics, &bunchLength[0]);
+	  nBunches+=kernels[k]->FindBunches(&channels[i][0], channelLength, &bunchLength[0], &bunchTime[0]);
+	  kernels[k]->AddCommonMode(&channels[i][0], channelLength, &cmSignal[0]);
+	}
+      }
+      std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+      double size=(double)nRepetitions*channels.size()*channelLength*sizeof(sample_t)/(1024*1024);
+      std::cout << "  " << std::setw(10) << std::left << names[k] << std::right << std::fixed << std::setprecision(1)
+		<< std::setw(10) << size/time.count() << " MB/s  (" << nBunches << " bunches)" << std::endl;
+    }
+    return nMismatches;
+  }
+
+  /**
+   * Write random frames to a timeframe file, uncompressed and compressed,
+   * and compare the frames read back. Frames with corrupt sizes in the
+   * header have to be rejected by the reader.
+   * @return number of mismatches
+   */
+  int CheckTimeframeFile()
+  {
+    std::default_random_engine generator(5);
+    // the SAMPA simulation reads frames longer than its time window of 1021 timebins
+    const unsigned lengths[]={1021, 2048};
+    const unsigned nFrames=4;
+    const unsigned nChannels=50;
+    char filename[]="/tmp/benchmarkMerger-XXXXXX";
+    int fd=mkstemp(filename);
+    if (fd<0) {
+      std::cerr << "can not create temporary file for timeframe file check" << std::endl;
+      return 1;
+    }
+    close(fd);
+    int nChecks=0;
+    int nMismatches=0;
+    const unsigned flags[]={0, TimeframeFile::kCompressed};
+    for (unsigned l=0; l<sizeof(lengths)/sizeof(lengths[0]); l++) {
+      const unsigned channelLength=lengths[l];
+      std::vector<std::vector<sample_t> > channels(nFrames*nChannels, std::vector<sample_t>(channelLength));
+      for (unsigned i=0; i<channels.size(); i++) FillChannel(channels[i], generator);
+      std::vector<sample_t> samples(channelLength);
+      for (unsigned f=0; f<sizeof(flags)/sizeof(flags[0]); f++) {
+	TimeframeWriter writer;
+	int result=writer.Open(filename, channelLength, flags[f]);
+	for (unsigned frame=0; frame<nFrames && result>=0; frame++) {
+	  result=writer.StartFrame(frame);
+	  for (unsigned c=0; c<nChannels && result>=0; c++) {
+	    writer.AddDenseChannel(c<<3, &channels[frame*nChannels+c][0], channelLength, ZeroSuppression::kVoidSample);
+	  }
+	  if (result>=0) result=writer.FinishFrame();
+	}
+	if (result>=0) result=writer.Close();
+	nChecks++;
+	if (result!=(int)nFrames) nMismatches++;
+
+	TimeframeReader reader;
+	result=reader.Open(filename);
+	if (result>=0 && reader.GetChannelLength()!=channelLength) nMismatches++;
+	unsigned frame=0;
+	for (; result>=0 && (result=reader.NextFrame())>0; frame++) {
+	  nChecks++;
+	  if (frame>=nFrames || reader.GetFrameNumber()!=frame || reader.GetNChannels()!=nChannels) {
+	    nMismatches++;
+	    continue;
+	  }
+	  for (unsigned c=0; c<nChannels; c++) {
+	    if (reader.GetChannelIndex(c)!=c<<3 ||
+		reader.GetDenseChannel(c, &samples[0], ZeroSuppression::kVoidSample)<0 ||
+		samples!=channels[frame*nChannels+c]) {
+	      nMismatches++;
+	      break;
+	    }
+	  }
+	}
+	if (result<0 || frame!=nFrames) nMismatches++;
+      }
+    }
+
+    // corrupt nChannels and payloadSize of the first frame of the compressed file
+    for (unsigned word=1; word<3; word++) {
+      unsigned original=0;
+      unsigned value=0x7fffffff;
+      FILE* file=fopen(filename, "r+b");
+      if (file==NULL || fseek(file, 16+word*sizeof(unsigned), SEEK_SET)!=0 ||
+	  fread(&original, sizeof(original), 1, file)!=1 ||
+	  fseek(file, 16+word*sizeof(unsigned), SEEK_SET)!=0 ||
+	  fwrite(&value, sizeof(value), 1, file)!=1) nMismatches++;
+      if (file) fclose(file);
+      TimeframeReader reader;
+      nChecks++;
+      if (reader.Open(filename)<0 || reader.NextFrame()!=-EINVAL) nMismatches++;
+      reader.Close();
+      if ((file=fopen(filename, "r+b"))==NULL || fseek(file, 16+word*sizeof(unsigned), SEEK_SET)!=0 ||
+	  fwrite(&original, sizeof(original), 1, file)!=1) nMismatches++;
+      if (file) fclose(file);
+    }
+    remove(filename);
+    std::cout << "timeframe file: " << nChecks << " check(s), " << nMismatches << " mismatch(es)" << std::endl;
+    return nMismatches;
+  }
+
+  /// overwrite one 16 bit word of a file
+  bool PatchFile(const char* filename, long position, unsigned short value)
+  {
+    FILE* file=fopen(filename, "r+b");
+    if (file==NULL) return false;
+    bool result=fseek(file, position, SEEK_SET)==0 && fwrite(&value, sizeof(value), 1, file)==1;
+    fclose(file);
+    return result;
+  }
+
+  /**
+   * Check the round trip of the event archive, the rejection of corrupted
+   * bunches and the merging of channels with invalid hardware address.
+   * @return number of mismatches
+   */
+  int CheckEventArchive()
+  {
+    int nChecks=0;
+    int nMismatches=0;
+    char filename[]="/tmp/benchmarkMerger-XXXXXX.evarc";
+    char timeframeFile[]="/tmp/benchmarkMerger-XXXXXX";
+    int fds[2]={mkstemps(filename, 6), mkstemp(timeframeFile)};
+    for (unsigned i=0; i<2; i++) {
+      if (fds[i]>=0) close(fds[i]);
+    }
+    if (fds[0]<0 || fds[1]<0) {
+      std::cerr << "can not create temporary file for event archive check" << std::endl;
+      return 1;
+    }
+
+    // the hardware address 0x1fff is outside the DDL and has to be skipped
+    const DecodedEvent::sample_t signals[]={60, 80, 70, 65};
+    DecodedEvent event;
+    event.AddDDL();
+    event.AddChannel(0x00005);
+    event.AddBunch(100, 3, signals);
+    event.AddBunch(50, 2, signals);
+    event.AddChannel(0x01fff);
+    event.AddBunch(10, 2, signals);
+    event.AddDDL();
+    event.AddChannel(0x10007);
+    event.AddBunch(200, 4, signals);
+    EventArchiveWriter writer;
+    nChecks++;
+    if (writer.Open(filename)<0 || writer.AddEvent(event)<0 || writer.Close()!=1) nMismatches++;
+
+    EventArchive archive;
+    DecodedEvent attached;
+    nChecks++;
+    if (archive.Open(filename)<0 || archive.GetEvent(0, attached)!=0 ||
+	attached.GetNChannels()!=event.GetNChannels() ||
+	attached.GetPayloadSize()!=event.GetPayloadSize() ||
+	memcmp(attached.GetPayload(), event.GetPayload(), event.GetPayloadSize()*sizeof(DecodedEvent::sample_t))!=0) nMismatches++;
+    archive.Close();
+
+    std::ostringstream log;
+    ChannelMerger merger;
+    merger.SetLogStream(&log);
+    std::unique_ptr<ChannelSource> source(ChannelSource::Create(filename));
+    TimeframeWriter timeframeWriter;
+    int result=source?timeframeWriter.Open(timeframeFile, merger.GetChannelLength(), 0):-ENOENT;
+    if (result>=0) result=merger.StartTimeframe();
+    if (result>=0) result=merger.MergeCollisions(std::vector<float>(1, 0.), *source);
+    if (result>=0) result=merger.WriteTimeframe(timeframeWriter, 0);
+    if (result>=0) result=timeframeWriter.Close();
+    TimeframeReader reader;
+    nChecks++;
+    if (result<0 || reader.Open(timeframeFile)<0 || reader.NextFrame()<=0 || reader.GetNChannels()!=2 ||
+	reader.GetChannelIndex(0)!=0x00005 || reader.GetChannelIndex(1)!=0x10007) nMismatches++;
+    reader.Close();
+    source.reset();
+
+    // bunch length running past the end of the first channel, and one
+    // word past the end of the last channel; the first event follows the
+    // file header of 24 and the event header of 16 bytes
+    const long payload=24+16+2*event.GetNChannels()*sizeof(unsigned);
+    const long positions[]={payload+1*2, payload+(event.GetPayloadSize()-5)*2};
+    const unsigned short values[]={1000, 5};
+    const unsigned short originals[]={3, 4};
+    for (unsigned i=0; i<2; i++) {
+      nChecks++;
+      if (!PatchFile(filename, positions[i], values[i]) ||
+	  archive.Open(filename)<0 || archive.GetEvent(0, attached)!=-EINVAL) nMismatches++;
+      archive.Close();
+      nChecks++;
+      if (!PatchFile(filename, positions[i], originals[i]) ||
+	  archive.Open(filename)<0 || archive.GetEvent(0, attached)!=0) nMismatches++;
+      archive.Close();
+    }
+
+    remove(filename);
+    remove(timeframeFile);
+    std::cout << "event archive: " << nChecks << " check(s), " << nMismatches << " mismatch(es)" << std::endl;
+    return nMismatches;
+  }
+
+  /**
+   * Check that the pedestal configuration written by PedestalEstimator is
+   * read back column by column, also for sample counts of many events.
+   * @return number of mismatches
+   */
+  int CheckPedestalConfiguration()
+  {
+    int nChecks=0;
+    int nMismatches=0;
+    PedestalEstimator estimator(1024);
+    const unsigned indices[]={0x00002, 0x10005};
+    const unsigned nBunches[]={3, 250};
+    std::vector<unsigned short> signals(1000);
+    for (unsigned c=0; c<2; c++) {
+      for (unsigned bunch=0; bunch<nBunches[c]; bunch++) {
+	// samples up to the maximum signal 1023, bunches of 1000 samples
+	for (unsigned i=0; i<signals.size(); i++) signals[i]=i%7==0?1023:50+(i+bunch)%5;
+	estimator.Add(indices[c], &signals[0], signals.size());
+      }
+    }
+    std::ostringstream output;
+    nChecks++;
+    if (estimator.Write(output)!=2) nMismatches++;
+    std::istringstream input(output.str());
+    for (unsigned c=0; c<2; c++) {
+      unsigned DDLNumber=0, HWAddress=0, nSamples=0, nBunchesRead=0;
+      int pedestal=0, minSignal=0, maxSignal=0;
+      double rms=0.;
+      nChecks++;
+      if (!(input >> DDLNumber >> HWAddress >> pedestal >> minSignal >> maxSignal >> nSamples >> nBunchesRead >> rms) ||
+	  (DDLNumber<<16 | HWAddress)!=indices[c] || pedestal!=estimator.GetPedestal(indices[c]) ||
+	  minSignal!=50 || maxSignal!=1023 || nSamples!=estimator.GetNSamples(indices[c]) ||
+	  nSamples!=nBunches[c]*signals.size() || nBunchesRead!=nBunches[c] ||
+	  rms<estimator.GetRMS(indices[c])-.005 || rms>estimator.GetRMS(indices[c])+.005) nMismatches++;
+    }
+    std::cout << "pedestal configuration: " << nChecks << " check(s), " << nMismatches << " mismatch(es)" << std::endl;
+    return nMismatches;
+  }
+
+  /**
+   * Check the reserved blocks of the sample store and the equivalence of
+   * the channel layouts: timeframes merged with the pad plane layout and
+   * with the default layout have to be identical.
+   * @return number of mismatches
+   */
+  int CheckChannelLayout()
+  {
+    int nChecks=0;
+    int nMismatches=0;
+
+    // the blocks of reserved slots are adjacent in slot order
+    SampleStore store(1021);
+    const unsigned nBlocks=store.GetNBlocksPerChannel();
+    for (unsigned i=0; i<3; i++) store.AddChannel();
+    store.GetSample(2, 100)=5;
+    nChecks++;
+    if (store.ReserveSlots(2)!=-EBUSY) nMismatches++;
+    store.Clear();
+    nChecks++;
+    if (store.ReserveSlots(2)!=0 || store.GetNReservedSlots()!=2) nMismatches++;
+    store.GetSample(2, 100)=5;
+    store.GetSample(1, 1020)=7;
+    store.GetSample(0, 0)=3;
+    nChecks++;
+    if (store.FindBlock(1, 0)!=NULL || store.GetNUsedBlocks()!=3 ||
+	store.GetBlock(1, 0)!=store.GetBlock(0, nBlocks-1)+SampleStore::kBlockLength ||
+	&store.GetSample(1, 1020)!=&store.GetSample(0, 0)+nBlocks*SampleStore::kBlockLength+1020 ||
+	store.GetSample(2, 100)!=5 || store.GetSample(1, 1020)!=7 || store.GetSample(0, 0)!=3) nMismatches++;
+    store.Clear();
+    nChecks++;
+    if (store.FindBlock(0, 0)!=NULL || store.FindBlock(2, 3)!=NULL || store.GetNReservedSlots()!=2) nMismatches++;
+
+    // mapping with pads in a different order than the channel index, every
+    // fifth channel is not mapped
+    char mappingFile[]="/tmp/benchmarkMerger-XXXXXX";
+    char timeframeFiles[2][32]={"/tmp/benchmarkMerger-XXXXXX", "/tmp/benchmarkMerger-XXXXXX"};
+    int fds[3]={mkstemp(mappingFile), mkstemp(timeframeFiles[0]), mkstemp(timeframeFiles[1])};
+    for (unsigned i=0; i<3; i++) {
+      if (fds[i]>=0) close(fds[i]);
+    }
+    if (fds[0]<0 || fds[1]<0 || fds[2]<0) {
+      std::cerr << "can not create temporary file for channel layout check" << std::endl;
+      return nMismatches+1;
+    }
+    {
+      std::ofstream mapping(mappingFile);
+      for (unsigned ddl=0; ddl<2; ddl++) {
+	for (unsigned hwaddr=0; hwaddr<300; hwaddr++) {
+	  if (hwaddr%5==4) continue;
+	  mapping << ddl << " " << hwaddr << " " << (hwaddr*7)%11 << " " << (hwaddr*13)%97 << std::endl;
+	}
+      }
+    }
+
+    const unsigned nFrames=3;
+    std::ostringstream log;
+    ChannelMerger mergers[2];
+    std::unique_ptr<ChannelSource> sources[2];
+    for (unsigned layout=0; layout<2; layout++) {
+      ChannelMerger& merger=mergers[layout];
+      merger.SetLogStream(&log);
+      merger.SetNThreads(2);
+      merger.InitZeroSuppression(45);
+      if (merger.InitAltroMapping(mappingFile)<0 ||
+	  merger.SetChannelLayout(layout==0?ChannelMerger::kLayoutFirstSeen:ChannelMerger::kLayoutPadPlane)<0) {
+	nMismatches++;
+	continue;
+      }
+      sources[layout].reset(ChannelSource::Create("synthetic:events=20,ddls=2,channels=300,seed=7"));
+      CollisionDistribution collisions(3.);
+      collisions.SetSeed(11);
+      TimeframeWriter writer;
+      int result=sources[layout]?writer.Open(timeframeFiles[layout], merger.GetChannelLength(), 0):-ENOENT;
+      for (unsigned frame=0; frame<nFrames && result>=0; frame++) {
+	const std::vector<float>& tf=collisions.NextSequence();
+	merger.StartTimeframe();
+	result=merger.MergeCollisions(tf, *sources[layout]);
+	if (result>=0) result=merger.ApplyCommonModeEffect(-1, ChannelMerger::kCommonModeFEC);
+	if (result>=0) result=merger.CalculateZeroSuppression(true);
+	if (result>=0) result=merger.WriteTimeframe(writer, frame);
+      }
+      if (result>=0) result=writer.Close();
+      nChecks++;
+      if (result<0) nMismatches++;
+    }
+    std::ifstream first(timeframeFiles[0], std::ios::binary);
+    std::ifstream second(timeframeFiles[1], std::ios::binary);
+    std::string data[2]={std::string(std::istreambuf_iterator<char>(first), std::istreambuf_iterator<char>()),
+			 std::string(std::istreambuf_iterator<char>(second), std::istreambuf_iterator<char>())};
+    nChecks++;
+    if (data[0].empty() || data[0]!=data[1]) nMismatches++;
+
+    // the padrows are visited in the same order with both layouts, the
+    // channels of a padrow are ordered by pad and hold the same data
+    ChannelMerger::PadRowIterator padrows[2]={mergers[0].GetPadRows(), mergers[1].GetPadRows()};
+    std::vector<ChannelMerger::buffer_t> channelData[2];
+    channelData[0].resize(mergers[0].GetChannelLength());
+    channelData[1].resize(mergers[1].GetChannelLength());
+    unsigned nPadRows=0;
+    while (padrows[0].Next()) {
+      nChecks++;
+      if (!padrows[1].Next() || padrows[0].GetDDLNumber()!=padrows[1].GetDDLNumber() ||
+	  padrows[0].GetPadRow()!=padrows[1].GetPadRow() ||
+	  padrows[0].GetNChannels()!=padrows[1].GetNChannels()) {
+	nMismatches++;
+	break;
+      }
+      nPadRows++;
+      for (unsigned i=0; i<padrows[0].GetNChannels(); i++) {
+	if ((i>0 && padrows[1].GetPad(i-1)>padrows[1].GetPad(i)) ||
+	    padrows[0].GetChannelIndex(i)!=padrows[1].GetChannelIndex(i) ||
+	    padrows[0].GetDenseChannel(i, &channelData[0][0])!=padrows[1].GetDenseChannel(i, &channelData[1][0]) ||
+	    channelData[0]!=channelData[1]) {
+	  nMismatches++;
+	  break;
+	}
+      }
+    }
+    nChecks++;
+    if (nPadRows!=2*11 || padrows[1].Next()) nMismatches++;
+
+    remove(mappingFile);
+    remove(timeframeFiles[0]);
+    remove(timeframeFiles[1]);
+    std::cout << "channel layout: " << nChecks << " check(s), " << nMismatches << " mismatch(es)" << std::endl;
+    return nMismatches;
+  }
+
+  /**
+   * Decode all channel records of a buffer and check by encoding the
+   * decoded symbols again, the encoding is unique.
+   * @return number of channels, negative error code if failed
+   */
+  int DecodeTimeframe(const HuffmanCoder& coder, const std::vector<unsigned char>& encoded, unsigned channelLength,
+		      std::vector<unsigned char>* check)
+  {
+    std::vector<sample_t> symbols(channelLength);
+    int nChannels=0;
+    for (unsigned position=0; position<encoded.size(); nChannels++) {
+      unsigned index=0;
+      int result=coder.DecodeChannel(&encoded[position], encoded.size()-position, index, &symbols[0], channelLength);
+      if (result<0) return result;
+      position+=result;
+      if (check) coder.EncodeChannel(index, &symbols[0], channelLength, *check);
+    }
+    return nChannels;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::string input="synthetic:";
+  int nTimeframes=10;
+  float rate=5.;
+  unsigned nThreads=0;
+  int threshold=-1;
+  unsigned cacheSize=0;
+  unsigned poolSize=0;
+  const char* outputFile=NULL;
+  int seed=-1;
+  const char* huffmanFile=NULL;
+  unsigned channelLength=0;
+
+  for (int i=1; i<argc; i++) {
+    if (strcmp(argv[i], "-h")==0) {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+    if (strcmp(argv[i], "-k")==0) {
+      int nMismatches=CheckZeroSuppression();
+      nMismatches+=CheckCodeLengthTable();
+      nMismatches+=CheckSignalAccumulation();
+      nMismatches+=CheckChannelKernels();
+      nMismatches+=CheckTimeframeFile();
+      nMismatches+=CheckEventArchive();
+      nMismatches+=CheckPedestalConfiguration();
+      nMismatches+=CheckChannelLayout();
+      return nMismatches==0?0:1;
+    }
+    if (argv[i][0]!='-' || strlen(argv[i])!=2 || i+1>=argc) {
+      PrintUsage(argv[0]);
+      return -1;
+    }
+    const char* value=argv[++i];
+    switch (argv[i-1][1]) {
+    case 'i': input=value; break;
+    case 't': nTimeframes=atoi(value); break;
+    case 'r': rate=atof(value); break;
+    case 'j': nThreads=atoi(value); break;
+    case 'z': threshold=atoi(value); break;
+    case 'c': cacheSize=atoi(value); break;
+    case 'p': poolSize=atoi(value); break;
+    case 'o': outputFile=value; break;
+    case 's': seed=atoi(value); break;
+    case 'l': channelLength=atoi(value); break;
+    case 'e': huffmanFile=value; break;
+    default:
+      PrintUsage(argv[0]);
+      return -1;
+    }
+  }
+
+  std::unique_ptr<ChannelSource> source(ChannelSource::Create(input.c_str()));
+  if (!source) {
+    std::cerr << "can not open input '" << input << "'" << std::endl;
+    return -1;
+  }
+
+  ChannelMerger merger;
+  if (channelLength>0 && merger.SetChannelLength(channelLength)<0) {
+    std::cerr << "invalid channel length " << channelLength << std::endl;
+    return -1;
+  }
+  merger.SetNThreads(nThreads);
+  if (threshold>=0) merger.InitZeroSuppression(threshold);
+  if (cacheSize>0) merger.InitEventCache(cacheSize, poolSize);
+
+  CollisionDistribution collisions(rate);
+  if (seed>=0) collisions.SetSeed(seed);
+  typedef std::chrono::steady_clock steady_clock;
+  std::chrono::duration<double> mergeTime(0);
+  std::chrono::duration<double> processTime(0);
+  HuffmanCoder coder;
+  std::vector<unsigned char> encoded;
+  std::vector<unsigned char> check;
+  std::chrono::duration<double> encodeTime(0);
+  std::chrono::duration<double> decodeTime(0);
+  double nEncodedSamples=0.;
+  double nEncodedBytes=0.;
+  int nCollisions=0;
+  int nFrames=0;
+  for (; nFrames<nTimeframes; nFrames++) {
+    const std::vector<float>& tf=collisions.NextSequence();
+    steady_clock::time_point start=steady_clock::now();
+    merger.StartTimeframe();
+    int result=merger.MergeCollisions(tf, *source);
+    steady_clock::time_point merged=steady_clock::now();
+    if (result<0) {
+      std::cerr << "merging failed with error " << result << std::endl;
+      return result;
+    }
+    nCollisions+=result;
+    if (threshold>=0) merger.CalculateZeroSuppression(true);
+    if (outputFile) merger.WriteTimeframe(outputFile);
+    processTime+=steady_clock::now()-merged;
+    mergeTime+=merged-start;
+    if (huffmanFile) {
+      // result keeps the number of merged collisions
+      int coderResult=0;
+      if (!coder.IsReady()) {
+	merger.EncodeTimeframe(coder, true, encoded);
+	if ((coderResult=coder.GenerateCode())<0) {
+	  std::cerr << "generation of Huffman code failed with error " << coderResult << std::endl;
+	  return coderResult;
+	}
+      }
+      encoded.clear();
+      check.clear();
+      steady_clock::time_point encodeStart=steady_clock::now();
+      coderResult=merger.EncodeTimeframe(coder, false, encoded);
+      steady_clock::time_point encodeStop=steady_clock::now();
+      if (coderResult<0) {
+	std::cerr << "Huffman encoding failed with error " << coderResult << std::endl;
+	return coderResult;
+      }
+      int nChannels=DecodeTimeframe(coder, encoded, merger.GetChannelLength(), NULL);
+      steady_clock::time_point decodeStop=steady_clock::now();
+      if (nChannels<0 || DecodeTimeframe(coder, encoded, merger.GetChannelLength(), &check)!=nChannels || check!=encoded) {
+	std::cerr << "Huffman decoding failed, error " << nChannels << std::endl;
+	return -1;
+      }
+      encodeTime+=encodeStop-encodeStart;
+      decodeTime+=decodeStop-encodeStop;
+      nEncodedSamples+=(double)nChannels*merger.GetChannelLength();
+      nEncodedBytes+=encoded.size();
+      std::ofstream output(huffmanFile, std::ios::binary);
+      output.write(reinterpret_cast<const char*>(&encoded[0]), encoded.size());
+    }
+    if ((unsigned)result<tf.size()) {
+      // input exhausted
+      nFrames++;
+      break;
+    }
+  }
+
+  std::cout << std::endl
+	    << "input:       " << input << std::endl
+	    << "threads:     " << nThreads << std::endl
+	    << "timeframes:  " << nFrames << std::endl
+	    << "collisions:  " << nCollisions << std::endl
+	    << std::fixed << std::setprecision(3)
+	    << "merging:     " << mergeTime.count() << " s";
+  if (mergeTime.count()>0.) {
+    std::cout << ", " << std::setprecision(1) << nCollisions/mergeTime.count() << " collisions/s";
+  }
+  std::cout << std::endl
+	    << std::setprecision(3)
+	    << "processing:  " << processTime.count() << " s" << std::endl;
+  if (huffmanFile && nEncodedSamples>0.) {
+    // raw data size in 16 bit samples, compression factor wrt 10 bit samples
+    double rawSize=nEncodedSamples*sizeof(sample_t)/(1024*1024);
+    std::cout << std::setprecision(1)
+	      << "encoding:    " << encodeTime.count() << " s, " << rawSize/encodeTime.count() << " MB/s" << std::endl
+	      << "decoding:    " << decodeTime.count() << " s, " << rawSize/decodeTime.count() << " MB/s" << std::endl
+	      << std::setprecision(3)
+	      << "compression: " << nEncodedSamples*10/(8*nEncodedBytes) << " (including channel headers)" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,820 @@
+//****************************************************************************
+//* This file is free software: you can redistribute it and/or modify        *
+//* it under the terms of the GNU General Public License as published by     *
+//* the Free Software Foundation, either version 3 of the License, or	     *
+//* (at your option) any later version.					     *
+//*                                                                          *
+//* Primary Authors: Matthias Richter <richterm@scieq.net>                   *
+//*                                                                          *
+//* The authors make no claims about the suitability of this software for    *
+//* any purpose. It is provided "as is" without express or implied warranty. *
+//****************************************************************************
+
+//  @file   generateTimeframes.cxx
+//  @author Matthias Richter
+//  @since  2026-10-16
+//  @brief  Standalone generation of timeframes from a configuration file
+//  @note   requires C++11 standard
+
+// Compiled counterpart of the steering macro timeframes_from_raw.C for the
+// generation of timeframe data without ROOT, the executable links the
+// generator library directly. The parameters are read from a configuration
+// file with one 'key=value' pair per line, the keys are the parameter names
+// of the macro. Parameters can also be given on the command line and take
+// precedence over the configuration file.
+//
+// The statistics trees, histograms and the Huffman compression analysis
+// require ROOT and are only available in the macro, the corresponding
+// parameters are rejected. The timeframes can be Huffman encoded with
+// HuffmanCoder instead, see parameters huffmanTable and encodedFile.
+//
+// Usage:
+//   generate-timeframes [-c configfile] [key=value ...]
+//
+// Example configuration:
+//   # pileup of a random number of collisions at random offsets
+//   pileupmode=3
+//   rate=5.
+//   nframes=100
+//   confFilenames=datafiles.txt
+//   asciiDataTargetDir=tfdata
+
+#include "ChannelMerger.h"
+#include "CollisionDistribution.h"
+#include "TimeframePipeline.h"
+#include "TimeframeFile.h"
+#include "CollisionTimeline.h"
+#include "ThreadPool.h"
+#include "HuffmanCoder.h"
+#include "CodeLengthTable.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <sys/stat.h>
+
+namespace {
+  void PrintUsage(const char* program)
+  {
+    std::cout << "usage: " << program << " [-c configfile] [key=value ...]" << std::endl;
+  }
+
+  /**
+   * Parameters in 'key=value' format.
+   * Lines starting with '#' and empty lines are ignored, white space around
+   * key and value is removed. Every parameter has to be used, see GetUnused.
+   */
+  class Configuration {
+  public:
+    Configuration() : mParameters(), mUsed() {}
+
+    /// add one 'key=value' pair, overrides previous setting
+    int Set(const std::string& line) {
+      std::string::size_type separator=line.find('=');
+      if (separator==std::string::npos) return -EINVAL;
+      std::string key=Trim(line.substr(0, separator));
+      if (key.empty()) return -EINVAL;
+      mParameters[key]=Trim(line.substr(separator+1));
+      return 0;
+    }
+
+    /// read all parameters from a file
+    int Read(const char* filename) {
+      std::ifstream input(filename);
+      if (!input.good()) {
+	std::cerr << "can not open configuration file '" << filename << "'" << std::endl;
+	return -ENOENT;
+      }
+      std::string line;
+      for (int lineNo=1; std::getline(input, line); lineNo++) {
+	std::string content=Trim(line);
+	if (content.empty() || content[0]=='#') continue;
+	if (Set(content)<0) {
+	  std::cerr << filename << ":" << lineNo << ": invalid parameter '" << line << "'" << std::endl;
+	  return -EINVAL;
+	}
+      }
+      return 0;
+    }
+
+    bool Has(const char* key) const {
+      return mParameters.find(key)!=mParameters.end();
+    }
+
+    const char* GetString(const char* key, const char* defaultValue) {
+      std::map<std::string, std::string>::const_iterator parameter=mParameters.find(key);
+      if (parameter==mParameters.end()) return defaultValue;
+      mUsed[key]=true;
+      // an empty value or NULL disables the parameter like NULL in the macro
+      if (parameter->second.empty() || parameter->second=="NULL") return NULL;
+      return parameter->second.c_str();
+    }
+
+    int GetInt(const char* key, int defaultValue) {
+      const char* value=GetString(key, NULL);
+      return value?atoi(value):defaultValue;
+    }
+
+    float GetFloat(const char* key, float defaultValue) {
+      const char* value=GetString(key, NULL);
+      return value?atof(value):defaultValue;
+    }
+
+    /// keys not used by any of the Get functions
+    std::vector<std::string> GetUnused() const {
+      std::vector<std::string> unused;
+      for (std::map<std::string, std::string>::const_iterator parameter=mParameters.begin();
+	   parameter!=mParameters.end(); parameter++) {
+	if (mUsed.find(parameter->first)==mUsed.end()) unused.push_back(parameter->first);
+      }
+      return unused;
+    }
+
+  private:
+    static std::string Trim(const std::string& s) {
+      const char* whitespace=" \t\r\n";
+      std::string::size_type first=s.find_first_not_of(whitespace);
+      if (first==std::string::npos) return std::string();
+      return s.substr(first, s.find_last_not_of(whitespace)-first+1);
+    }
+
+    std::map<std::string, std::string> mParameters;
+    std::map<std::string, bool> mUsed;
+  };
+
+  /// configuration of the processing of timeframes
+  struct processing_setup_t {
+    int applyCommonModeEffect;
+    const char* asciiDataTargetDir;
+    const char* systemsTargetdir;
+    TimeframeWriter* timeframeWriter;
+    bool bHaveSignalOverflow;
+    std::ostream* log;
+    /// Huffman code, trained from the first frame if not ready
+    HuffmanCoder* coder;
+    /// code table written after training
+    const char* huffmanTable;
+    /// target of the encoded frames, encoded for the statistics only if NULL
+    std::ostream* encodedOutput;
+    /// time of the encoding in seconds
+    double encodeTime;
+    /// number of encoded samples and bytes
+    double nEncodedSamples;
+    double nEncodedBytes;
+  };
+
+  /// merged timeframe handed over to the processing
+  struct timeframe_data_t {
+    int TimeFrameNo;
+    std::vector<float> collisions;
+    int mergedCollisions;
+  };
+
+  /// create the target directory, existing directory is accepted
+  int MakeDirectory(const char* dirname)
+  {
+    if (mkdir(dirname, 0755)==0 || errno==EEXIST) return 0;
+    std::cerr << "can not create directory '" << dirname << "'" << std::endl;
+    return -errno;
+  }
+
+  /**
+   * Read the code lengths of a Huffman code.
+   * One line per symbol with symbol and code length, lines starting with
+   * '#' are ignored.
+   * @return 0 on success, -ENOENT if the file does not exist,
+   *         -EINVAL if the table is invalid
+   */
+  int ReadCodeTable(const char* filename, HuffmanCoder& coder)
+  {
+    std::ifstream input(filename);
+    if (!input.good()) return -ENOENT;
+    CodeLengthTable table(coder.GetNSymbols());
+    std::string line;
+    while (std::getline(input, line)) {
+      if (line.empty() || line[0]=='#') continue;
+      std::istringstream fields(line);
+      unsigned symbol=0;
+      unsigned length=0;
+      if (!(fields >> symbol >> length) || table.SetCodeLength(symbol, length)<0) return -EINVAL;
+    }
+    return coder.InitCode(table);
+  }
+
+  /// write the code lengths of a Huffman code, see ReadCodeTable
+  int WriteCodeTable(const char* filename, const HuffmanCoder& coder)
+  {
+    std::ofstream output(filename);
+    if (!output.good()) return -EIO;
+    output << "# symbol code length" << std::endl;
+    for (unsigned symbol=0; symbol<coder.GetNSymbols(); symbol++) {
+      if (coder.GetCodeLength(symbol)==0) continue;
+      output << symbol << " " << coder.GetCodeLength(symbol) << std::endl;
+    }
+    return output.good()?0:-EIO;
+  }
+
+  /**
+   * Huffman encode a timeframe and append it to the encoded output.
+   * The code is generated from the first frame if not ready. A frame in
+   * the output consists of the frame number and the number of bytes as
+   * 32 bit words followed by the channel records, see HuffmanCoder.
+   */
+  int EncodeTimeframe(ChannelMerger& merger, processing_setup_t& setup, unsigned frameNumber)
+  {
+    int result=0;
+    std::vector<unsigned char> encoded;
+    if (!setup.coder->IsReady()) {
+      merger.EncodeTimeframe(*setup.coder, true, encoded);
+      if ((result=setup.coder->GenerateCode())<0) {
+	std::cerr << "generation of Huffman code failed with error " << result << std::endl;
+	return result;
+      }
+      if ((result=WriteCodeTable(setup.huffmanTable, *setup.coder))<0) {
+	std::cerr << "can not write Huffman code table '" << setup.huffmanTable << "'" << std::endl;
+	return result;
+      }
+      *setup.log << "generated Huffman code from timeframe " << frameNumber << ", written to " << setup.huffmanTable << std::endl;
+    }
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    result=merger.EncodeTimeframe(*setup.coder, false, encoded);
+    std::chrono::duration<double> time=std::chrono::steady_clock::now()-start;
+    if (result<0) {
+      std::cerr << "Huffman encoding failed with error " << result << std::endl;
+      return result;
+    }
+    // every channel record holds the number of 40 bit words in the header
+    unsigned nChannels=0;
+    for (unsigned position=0; position+HuffmanCoder::kChannelHeaderSize<=encoded.size(); nChannels++) {
+      unsigned nWords=0;
+      memcpy(&nWords, &encoded[position+4], sizeof(nWords));
+      position+=HuffmanCoder::kChannelHeaderSize+5*nWords;
+    }
+    setup.encodeTime+=time.count();
+    setup.nEncodedSamples+=(double)nChannels*merger.GetChannelLength();
+    setup.nEncodedBytes+=encoded.size();
+    if (setup.encodedOutput) {
+      unsigned header[2]={frameNumber, (unsigned)encoded.size()};
+      setup.encodedOutput->write(reinterpret_cast<const char*>(header), sizeof(header));
+      if (!encoded.empty()) setup.encodedOutput->write(reinterpret_cast<const char*>(&encoded[0]), encoded.size());
+      if (!setup.encodedOutput->good()) return -EIO;
+    }
+    return 0;
+  }
+
+  /// zero suppression, common mode effect and output of a merged timeframe
+  int ProcessTimeframe(ChannelMerger& merger, void* parameter, void* data)
+  {
+    processing_setup_t& setup=*(processing_setup_t*)parameter;
+    timeframe_data_t* timeframe=(timeframe_data_t*)data;
+    int TimeFrameNo=timeframe->TimeFrameNo;
+    int mergedCollisions=timeframe->mergedCollisions;
+    std::vector<float> tf;
+    tf.swap(timeframe->collisions);
+    delete timeframe;
+    timeframe=NULL;
+
+    merger.CalculateZeroSuppression(true);
+    if (setup.applyCommonModeEffect>0)
+      merger.ApplyCommonModeEffect(-1, setup.applyCommonModeEffect-1);
+    if (merger.GetSignalOverflowCount() > 0) {
+      *setup.log << "signal overflow in current timeframe detected" << std::endl;
+      setup.bHaveSignalOverflow=true;
+    }
+    if (mergedCollisions != (int)tf.size()) {
+      // incomplete timeframe is not written
+      return 0;
+    }
+
+    char filename[1024];
+    if (setup.asciiDataTargetDir) {
+      // write timeframe data to file
+      int result=MakeDirectory(setup.asciiDataTargetDir);
+      if (result<0) return result;
+      snprintf(filename, sizeof(filename), "%s/tf%04d.dat", setup.asciiDataTargetDir, TimeFrameNo-1);
+      if ((result=merger.WriteTimeframe(filename))<0) return result;
+    }
+    if (setup.timeframeWriter) {
+      // append to the binary timeframe file
+      int result=merger.WriteTimeframe(*setup.timeframeWriter, TimeFrameNo-1);
+      if (result<0) return result;
+    }
+    if (setup.coder) {
+      int result=EncodeTimeframe(merger, setup, TimeFrameNo-1);
+      if (result<0) return result;
+    }
+
+    if (setup.systemsTargetdir != NULL) {
+      // write to text file used for SystemC simulation
+      int result=MakeDirectory(setup.systemsTargetdir);
+      if (result<0) return result;
+      snprintf(filename, sizeof(filename), "%s/event%04d.dat", setup.systemsTargetdir, TimeFrameNo-1);
+      if ((result=merger.WriteSystemcInputFile(filename))<0) return result;
+    }
+
+    *setup.log << "Successfully generated timeframe " << TimeFrameNo << " from " << tf.size() << " collision(s)" << std::endl;
+    for (std::vector<float>::const_iterator element=tf.begin(); element!=tf.end(); element++) *setup.log << "   collision at offset " << *element << std::endl;
+    return 0;
+  }
+
+  /**
+   * Messages of frames generated in parallel, printed in frame order.
+   * The messages of a frame are printed as soon as all frames before are
+   * printed.
+   */
+  class FrameLog {
+  public:
+    FrameLog(unsigned firstFrame, unsigned nFrames)
+      : mMutex(), mFirstFrame(firstFrame), mNextFrame(0), mMessages(nFrames), mDone(nFrames, false) {}
+
+    /// add the messages of a frame
+    void Add(unsigned frame, const std::string& messages) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mMessages[frame-mFirstFrame]=messages;
+      mDone[frame-mFirstFrame]=true;
+      for (; mNextFrame<mDone.size() && mDone[mNextFrame]; mNextFrame++) {
+	std::cout << mMessages[mNextFrame] << std::flush;
+	mMessages[mNextFrame].clear();
+      }
+    }
+
+    /// print the messages of all frames after a frame has failed
+    void Flush() {
+      std::lock_guard<std::mutex> lock(mMutex);
+      for (; mNextFrame<mDone.size(); mNextFrame++) std::cout << mMessages[mNextFrame];
+      std::cout << std::flush;
+    }
+
+  private:
+    std::mutex mMutex;
+    unsigned mFirstFrame;
+    unsigned mNextFrame;
+    std::vector<std::string> mMessages;
+    std::vector<bool> mDone;
+  };
+
+  /**
+   * Generate a range of frames of the timeline.
+   * The frames spanned by the drift length before the range are merged
+   * without processing to restore the samples shifted into the range.
+   * The messages of every frame are collected and handed to the frame log,
+   * the messages of the preceding frames are dropped.
+   * @param first     first frame of the range
+   * @param end       end of the range
+   * @return 0 on success, negative error code if failed
+   */
+  int GenerateFrameRange(ChannelMerger& merger, const CollisionTimeline& timeline, unsigned first, unsigned end,
+			 bool normalizeTimeframe, processing_setup_t& setup, FrameLog& log)
+  {
+    unsigned nUnderflowFrames=merger.GetNUnderflowFrames();
+    unsigned frame=first>nUnderflowFrames?first-nUnderflowFrames:0;
+    merger.RegisterChannels(timeline, frame);
+    int result=0;
+    for (; frame<end && result>=0; frame++) {
+      std::ostringstream messages;
+      merger.SetLogStream(&messages);
+      setup.log=&messages;
+      merger.StartTimeframe();
+      merger.SeedTimeframe(frame);
+      int mergedCollisions=merger.MergeCollisions(timeline, frame);
+      if (mergedCollisions<0) {
+	std::cerr << "merging collisions failed with error code " << mergedCollisions << std::endl;
+	result=mergedCollisions;
+      } else {
+	if (normalizeTimeframe) {
+	  merger.Normalize(timeline.GetNCollisions(frame));
+	}
+	if (frame<first) continue;
+	timeframe_data_t* timeframe=new timeframe_data_t;
+	timeframe->TimeFrameNo=frame+1;
+	timeframe->collisions=timeline.GetCollisionTimes(frame);
+	timeframe->mergedCollisions=mergedCollisions;
+	result=ProcessTimeframe(merger, &setup, timeframe);
+      }
+      if (frame>=first) log.Add(frame, messages.str());
+    }
+    merger.SetLogStream(NULL);
+    setup.log=&std::cout;
+    return result<0?result:0;
+  }
+
+  /**
+   * Append the frames of a binary timeframe file to a writer.
+   * @return number of frames, negative error code if failed
+   */
+  int CopyTimeframes(const char* filename, TimeframeWriter& writer)
+  {
+    TimeframeReader reader;
+    int result=reader.Open(filename);
+    int nFrames=0;
+    while (result>=0 && (result=reader.NextFrame())>0) {
+      if ((result=writer.StartFrame(reader.GetFrameNumber()))<0) break;
+      for (unsigned channel=0; channel<reader.GetNChannels(); channel++) {
+	unsigned size=0;
+	const unsigned short* data=reader.GetChannelData(channel, size);
+	writer.AddChannel(reader.GetChannelIndex(channel), data, size);
+      }
+      if ((result=writer.FinishFrame())<0) break;
+      nFrames++;
+    }
+    return result<0?result:nFrames;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  Configuration configuration;
+  std::vector<std::string> commandline;
+  for (int i=1; i<argc; i++) {
+    if (strcmp(argv[i], "-h")==0) {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+    if (strcmp(argv[i], "-c")==0 && i+1<argc) {
+      if (configuration.Read(argv[++i])<0) return -1;
+      continue;
+    }
+    if (strchr(argv[i], '=')==NULL) {
+      PrintUsage(argv[0]);
+      return -1;
+    }
+    commandline.push_back(argv[i]);
+  }
+  // command line parameters override the configuration file
+  for (std::vector<std::string>::const_iterator parameter=commandline.begin();
+       parameter!=commandline.end(); parameter++) {
+    if (configuration.Set(*parameter)<0) {
+      std::cerr << "invalid parameter '" << *parameter << "'" << std::endl;
+      return -1;
+    }
+  }
+
+  // parameters of the steering macro which require ROOT
+  const char* rootParameters[]={
+    "doHuffmanCompression", "huffmanLengthCutoff", "huffmanFileName", "targetFileName",
+    "statisticsTreeMode", "statisticsTextFileName", "fusedProcessing", NULL
+  };
+  for (const char** key=rootParameters; *key!=NULL; key++) {
+    if (configuration.Has(*key)) {
+      std::cerr << "parameter '" << *key << "' requires ROOT, use macro timeframes_from_raw.C" << std::endl;
+      return -1;
+    }
+  }
+
+  // the defaults of the steering macro
+  const int   pileupmode=configuration.GetInt("pileupmode", 3);
+  const float rate=configuration.GetFloat("rate", 5.);
+  const int   ncollisions=configuration.GetInt("ncollisions", 10);
+  const int   nframes=configuration.GetInt("nframes", 1000);
+  const int   baseline=configuration.GetInt("baseline", 5);
+  const int   thresholdZS=configuration.GetInt("thresholdZS", 2);
+  const int   noiseFactor=configuration.GetInt("noiseFactor", 1);
+  const int   applyCommonModeEffect=configuration.GetInt("applyCommonModeEffect", 0);
+  const int   normalizeTimeframe=configuration.GetInt("normalizeTimeframe", 0);
+  const char* pedestalConfiguration=configuration.GetString("pedestalConfiguration", "pedestal.dat");
+  const char* channelMappingConfiguration=configuration.GetString("channelMappingConfiguration", "mapping.dat");
+  const char* confFilenames=configuration.GetString("confFilenames", "datafiles.txt");
+  const char* asciiDataTargetDir=configuration.GetString("asciiDataTargetDir", NULL);
+  const char* systemsTargetdir=configuration.GetString("systemsTargetdir", NULL);
+  const int   minddl=configuration.GetInt("minddl", 0);
+  const int   maxddl=configuration.GetInt("maxddl", 1);
+  const int   minpadrow=configuration.GetInt("minpadrow", -1);
+  const int   maxpadrow=configuration.GetInt("maxpadrow", -1);
+  const int   pipelineSlots=configuration.GetInt("pipelineSlots", 0);
+  const int   inputPrefetch=configuration.GetInt("inputPrefetch", 0);
+  // parameters of the standalone executable
+  const int   nThreads=configuration.GetInt("nThreads", 0);
+  const int   eventCacheSize=configuration.GetInt("eventCacheSize", 0);
+  const int   eventPoolSize=configuration.GetInt("eventPoolSize", 0);
+  const int   seed=configuration.GetInt("seed", -1);
+  const int   channelLength=configuration.GetInt("channelLength", 1024);
+  const int   driftLength=configuration.GetInt("driftLength", 0);
+  const int   channelLayout=configuration.GetInt("channelLayout", 0);
+  const char* timeframeFile=configuration.GetString("timeframeFile", NULL);
+  const int   compressTimeframes=configuration.GetInt("compressTimeframes", 0);
+  const int   frameWorkers=configuration.GetInt("frameWorkers", 0);
+  const int   firstFrame=configuration.GetInt("firstFrame", 0);
+  const char* huffmanTable=configuration.GetString("huffmanTable", NULL);
+  const char* encodedFile=configuration.GetString("encodedFile", NULL);
+
+  std::vector<std::string> unused=configuration.GetUnused();
+  if (!unused.empty()) {
+    for (std::vector<std::string>::const_iterator key=unused.begin(); key!=unused.end(); key++) {
+      std::cerr << "unknown parameter '" << *key << "'" << std::endl;
+    }
+    return -1;
+  }
+  if (pileupmode==2 || pileupmode<0 || pileupmode>3) {
+    std::cerr << "pileup mode " << pileupmode << " not supported" << std::endl;
+    return -1;
+  }
+  if (frameWorkers<0 || firstFrame<0 || (firstFrame>0 && frameWorkers==0)) {
+    std::cerr << "invalid frame range or number of frame workers, firstFrame requires frameWorkers" << std::endl;
+    return -1;
+  }
+  if (frameWorkers>0 && (nframes<0 || pipelineSlots>0 || inputPrefetch>0 || eventCacheSize>0)) {
+    std::cerr << "frameWorkers requires a number of frames and does not support pipelineSlots, inputPrefetch and the event cache" << std::endl;
+    return -1;
+  }
+  if (encodedFile && !huffmanTable) {
+    std::cerr << "encodedFile requires the Huffman code table huffmanTable" << std::endl;
+    return -1;
+  }
+  HuffmanCoder coder;
+  if (huffmanTable) {
+    // an existing table is used, otherwise the code is generated from the
+    // first timeframe and written to the table
+    int result=ReadCodeTable(huffmanTable, coder);
+    if (result==-ENOENT && frameWorkers>0) {
+      std::cerr << "frameWorkers require an existing Huffman code table '" << huffmanTable << "'" << std::endl;
+      return -1;
+    } else if (result<0 && result!=-ENOENT) {
+      std::cerr << "invalid Huffman code table '" << huffmanTable << "'" << std::endl;
+      return -1;
+    }
+  }
+
+  CollisionDistribution generator(rate);
+  if (seed>=0) generator.SetSeed(seed);
+  // all mergers are configured identically, the frame workers use their own
+  auto configure=[&](ChannelMerger& merger)->int {
+    if (channelLength<=0 || merger.SetChannelLength(channelLength)<0) {
+      std::cerr << "invalid channel length " << channelLength << std::endl;
+      return -1;
+    }
+    if (driftLength<0 || merger.SetDriftLength(driftLength)<0) {
+      std::cerr << "invalid drift length " << driftLength << std::endl;
+      return -1;
+    }
+    if (merger.SetChannelLayout(channelLayout)<0) {
+      std::cerr << "invalid channel layout " << channelLayout << std::endl;
+      return -1;
+    }
+    if (seed>=0)
+      merger.SetRandomSeed(seed);
+    if (minddl>=0 && maxddl>=0)
+      merger.SetDDLRange(minddl, maxddl);
+    if (minpadrow>=0 && maxpadrow>=0)
+      merger.SetPadRowRange(minpadrow, maxpadrow);
+    if (pedestalConfiguration)
+      merger.InitChannelBaseline(pedestalConfiguration, -baseline); // note the '-'!
+    if (channelMappingConfiguration)
+      merger.InitAltroMapping(channelMappingConfiguration);
+    if (thresholdZS>=0)
+      merger.InitZeroSuppression(thresholdZS);
+    merger.InitNoiseManipulation(noiseFactor);
+    // normalized timeframes accumulate many collisions, e.g. for the baseline
+    if (normalizeTimeframe)
+      merger.SetWideAccumulation(true);
+    merger.SetNThreads(nThreads);
+    if (eventCacheSize>0)
+      merger.InitEventCache(eventCacheSize, eventPoolSize);
+    return 0;
+  };
+  ChannelMerger merger;
+  if (configure(merger)<0) return -1;
+
+  std::istream* inputfiles=&std::cin;
+  std::ifstream inputconfiguration(confFilenames?confFilenames:"");
+  if (inputconfiguration.good()) {
+    inputfiles=&inputconfiguration;
+    // prefetch requires the end of the file list, not applied to std input
+    if (inputPrefetch>0)
+      merger.SetInputPrefetch(inputPrefetch);
+  } else {
+    std::cout << "Can not open configuration file '" << (confFilenames?confFilenames:"") << "' " << std::endl
+	      << "Reading input file names from std input, one filename per line" << std::endl;
+  }
+
+  processing_setup_t setup;
+  setup.applyCommonModeEffect=applyCommonModeEffect;
+  setup.asciiDataTargetDir=asciiDataTargetDir;
+  setup.systemsTargetdir=systemsTargetdir;
+  setup.timeframeWriter=NULL;
+  setup.bHaveSignalOverflow=false;
+  setup.log=&std::cout;
+  setup.coder=huffmanTable?&coder:NULL;
+  setup.huffmanTable=huffmanTable;
+  setup.encodedOutput=NULL;
+  setup.encodeTime=0.;
+  setup.nEncodedSamples=0.;
+  setup.nEncodedBytes=0.;
+  std::ofstream encodedOutput;
+  if (encodedFile) {
+    encodedOutput.open(encodedFile, std::ios::binary);
+    if (!encodedOutput.good()) {
+      std::cerr << "can not open file '" << encodedFile << "' for writing encoded data" << std::endl;
+      return -1;
+    }
+    setup.encodedOutput=&encodedOutput;
+  }
+  TimeframeWriter timeframeWriter;
+  if (timeframeFile) {
+    int result=timeframeWriter.Open(timeframeFile, channelLength, compressTimeframes?TimeframeFile::kCompressed:0);
+    if (result<0) {
+      std::cerr << "can not open file '" << timeframeFile << "' for writing timeframe data" << std::endl;
+      return -1;
+    }
+    setup.timeframeWriter=&timeframeWriter;
+  }
+  TimeframePipeline* pipeline=NULL;
+  if (pipelineSlots > 0) {
+    pipeline=new TimeframePipeline(ProcessTimeframe, &setup, pipelineSlots);
+  }
+
+  // collision times of the next timeframe
+  auto nextCollisions=[&](std::vector<float>& tf) {
+    tf.clear();
+    if ((pileupmode&0x1) == 0) {
+      // fixed number of collisions
+      tf.resize(ncollisions, 0.);
+    } else {
+      // random number of collisions
+      const std::vector<float>& randomTF=generator.NextSequence();
+      if ((pileupmode&0x2) == 0) {
+	// merge random number of collisions, each at offset 0.
+	tf.resize(randomTF.size(), 0.);
+      } else {
+	// merge random number of collisions at random offsets
+	tf=randomTF;
+      }
+    }
+  };
+
+  int iResult=0;
+  int timeframeCounter=0;
+  while (frameWorkers==0 && (timeframeCounter++<nframes || nframes<0)) {
+    std::vector<float> tf;
+    nextCollisions(tf);
+
+    timeframe_data_t* timeframe=new timeframe_data_t;
+    timeframe->TimeFrameNo=timeframeCounter;
+    timeframe->collisions=tf;
+    merger.StartTimeframe();
+    merger.SeedTimeframe(timeframeCounter-1);
+    int mergedCollisions=merger.MergeCollisions(tf, *inputfiles);
+    if (mergedCollisions < 0) {
+      // a failed merge is neither processed nor written
+      std::cerr << "merging collisions failed with error code " << mergedCollisions << std::endl;
+      iResult=mergedCollisions;
+      delete timeframe;
+      break;
+    }
+    timeframe->mergedCollisions=mergedCollisions;
+    if (normalizeTimeframe) {
+      // normalization for estimation of baseline
+      merger.Normalize(tf.size());
+    }
+    // the processing function owns and deletes the timeframe data
+    if (pipeline) {
+      if ((iResult=pipeline->Push(merger, timeframe)) < 0) {
+	delete timeframe;
+	break;
+      }
+    } else if ((iResult=ProcessTimeframe(merger, &setup, timeframe)) < 0) {
+      break;
+    }
+    if (mergedCollisions != (int)tf.size()) {
+      // probably no more input data to be read
+      std::cout << "simulated " << timeframeCounter-1 << " timeframe(s)" << std::endl;
+      break;
+    }
+  }
+
+  if (frameWorkers>0) {
+    // all collision times and events are drawn up front, the frames are
+    // then independent and generated in contiguous ranges by the workers
+    CollisionTimeline timeline;
+    for (int frame=0; frame<firstFrame+nframes; frame++) {
+      std::vector<float> tf;
+      nextCollisions(tf);
+      timeline.AddFrame(tf);
+    }
+    int nAssigned=merger.AssignEvents(timeline, *inputfiles);
+    if (nAssigned<0) {
+      std::cerr << "assigning events to collisions failed with error code " << nAssigned << std::endl;
+      iResult=nAssigned;
+    }
+    unsigned endFrame=nAssigned>firstFrame?nAssigned:firstFrame;
+    unsigned nFrames=endFrame-firstFrame;
+    unsigned nWorkers=(unsigned)frameWorkers<nFrames?frameWorkers:nFrames;
+    std::vector<int> workerResult(nWorkers, 0);
+    std::vector<bool> workerOverflow(nWorkers, false);
+    std::vector<std::string> partFiles(nWorkers);
+    std::vector<std::string> encodedPartFiles(nWorkers);
+    std::vector<processing_setup_t> workerSetups(nWorkers, setup);
+    FrameLog frameLog(firstFrame, nFrames);
+    auto worker=[&](unsigned w) {
+      unsigned first=firstFrame+(nFrames*w)/nWorkers;
+      unsigned end=firstFrame+(nFrames*(w+1))/nWorkers;
+      ChannelMerger frameMerger;
+      processing_setup_t& workerSetup=workerSetups[w];
+      TimeframeWriter partWriter;
+      std::ofstream encodedPart;
+      // the configuration messages have been printed by the main merger
+      std::ostringstream configurationMessages;
+      frameMerger.SetLogStream(&configurationMessages);
+      workerResult[w]=configure(frameMerger);
+      if (workerResult[w]>=0 && timeframeFile) {
+	// the frames of a worker are collected in a part file and appended in order
+	partFiles[w]=std::string(timeframeFile)+".part"+std::to_string(w);
+	workerResult[w]=partWriter.Open(partFiles[w].c_str(), channelLength, compressTimeframes?TimeframeFile::kCompressed:0);
+	workerSetup.timeframeWriter=&partWriter;
+      }
+      if (workerResult[w]>=0 && encodedFile) {
+	// the loaded code is shared, encoding does not change the coder
+	encodedPartFiles[w]=std::string(encodedFile)+".part"+std::to_string(w);
+	encodedPart.open(encodedPartFiles[w].c_str(), std::ios::binary);
+	if (!encodedPart.good()) workerResult[w]=-EIO;
+	workerSetup.encodedOutput=&encodedPart;
+      }
+      if (workerResult[w]>=0)
+	workerResult[w]=GenerateFrameRange(frameMerger, timeline, first, end, normalizeTimeframe, workerSetup, frameLog);
+      if (partWriter.IsOpen()) {
+	int result=partWriter.Close();
+	if (workerResult[w]>=0 && result<0) workerResult[w]=result;
+      }
+      if (encodedPart.is_open()) {
+	encodedPart.close();
+	if (workerResult[w]>=0 && encodedPart.fail()) workerResult[w]=-EIO;
+      }
+      workerOverflow[w]=workerSetup.bHaveSignalOverflow;
+    };
+    if (iResult>=0 && nWorkers>0) {
+      if (nWorkers>1) {
+	ThreadPool pool(nWorkers);
+	pool.Run(nWorkers, worker);
+      } else {
+	worker(0);
+      }
+      frameLog.Flush();
+    }
+    for (unsigned w=0; w<nWorkers; w++) {
+      if (iResult>=0) iResult=workerResult[w];
+      if (workerOverflow[w]) setup.bHaveSignalOverflow=true;
+      setup.encodeTime+=workerSetups[w].encodeTime;
+      setup.nEncodedSamples+=workerSetups[w].nEncodedSamples;
+      setup.nEncodedBytes+=workerSetups[w].nEncodedBytes;
+      if (!encodedPartFiles[w].empty()) {
+	if (iResult>=0) {
+	  std::ifstream encodedPart(encodedPartFiles[w].c_str(), std::ios::binary);
+	  if (encodedPart.peek()!=std::ifstream::traits_type::eof()) encodedOutput << encodedPart.rdbuf();
+	  if (!encodedOutput.good()) iResult=-EIO;
+	}
+	remove(encodedPartFiles[w].c_str());
+      }
+      if (partFiles[w].empty()) continue;
+      if (iResult>=0) {
+	int result=CopyTimeframes(partFiles[w].c_str(), timeframeWriter);
+	if (result<0) iResult=result;
+      }
+      remove(partFiles[w].c_str());
+    }
+    if (iResult>=0 && (int)endFrame<firstFrame+nframes) {
+      // probably no more input data to be read
+      std::cout << "simulated " << nFrames << " timeframe(s)" << std::endl;
+    }
+  }
+
+  if (pipeline) {
+    int result=pipeline->Flush();
+    if (iResult>=0) iResult=result;
+    delete pipeline;
+    pipeline=NULL;
+  }
+  if (timeframeFile) {
+    int result=timeframeWriter.Close();
+    if (result>=0) {
+      std::cout << "wrote " << result << " timeframe(s) to file " << timeframeFile << std::endl;
+    } else if (iResult>=0) {
+      iResult=result;
+    }
+  }
+  if (encodedFile) {
+    encodedOutput.close();
+    if (encodedOutput.fail() && iResult>=0) iResult=-EIO;
+  }
+  if (setup.coder && setup.encodeTime>0. && setup.nEncodedBytes>0.) {
+    // raw data size in 16 bit samples, compression factor wrt 10 bit samples
+    double rawSize=setup.nEncodedSamples*sizeof(unsigned short)/(1024*1024);
+    std::cout << "Huffman encoding: " << setup.encodeTime << " s, " << rawSize/setup.encodeTime << " MB/s, compression "
+	      << setup.nEncodedSamples*10/(8*setup.nEncodedBytes) << " (including channel headers)" << std::endl;
+  }
+  if (iResult<0) {
+    std::cerr << "processing of timeframes failed with error " << iResult << std::endl;
+    return iResult;
+  }
+
+  if (setup.bHaveSignalOverflow) {
+    std::cout << "WARNING: signal overflow detected in at least one timeframe" << std::endl;
+  }
+  return 0;
+}